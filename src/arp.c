@@ -0,0 +1,218 @@
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "arp.h"
+#include "arp_pattern.h"
+#include "scheduler.h"
+#include "config_snapshot.h"
+#include "midi_ble.h"
+#include "midi_clock.h"
+#include "keyboard.h"
+
+#define ARP_IDLE_POLL_MS   10   // Step rate while waiting for MIDI clock
+#define ARP_OFF_VELOCITY   64
+
+struct held_note {
+    uint8_t note;
+    uint8_t velocity;
+};
+
+// Held notes sorted by pitch; written by the scan thread, read by the step
+static struct held_note held[ARP_MAX_HELD];
+static int held_len;
+static struct k_spinlock arp_lock;
+
+// Step state (step call / arp_lock)
+static bool stepping;          // A step call is pending on the scheduler
+static uint32_t step_idx;
+static uint32_t rng = 0x2545F491;
+static uint32_t steps;
+
+// MIDI clock grid (step call only)
+static int64_t grid_played = -1;   // Last grid step sounded since Start
+
+// ========== CLOCK ==========
+// The only part of the arpeggiator that depends on the clock source.
+// MIDI clock messages are tracked in midi_clock.c alone; the grid here
+// only reads song positions from it.
+
+// Step length in scheduler ticks on the internal clock
+static int64_t internal_step_ticks(const struct config_snapshot *cfg)
+{
+    uint64_t beat_us = 60000000U / cfg->arp_tempo;
+
+    return (int64_t)k_us_to_ticks_near64(beat_us / cfg->arp_division);
+}
+
+// Time of the next MIDI clock grid step after `due`, and whether the
+// step at `due` should sound. Steps sit on song positions (beats since
+// Start / division) rather than at a fixed distance from the previous
+// one, so the grid stays phase-locked to the sender even while the
+// tempo estimate moves. Returns 0 while the clock is stopped.
+static int64_t midi_grid_next(const struct config_snapshot *cfg, int64_t due, bool *play)
+{
+    int64_t beats_q16;
+
+    *play = false;
+    if (!midi_clock_position(due, &beats_q16)) {
+        grid_played = -1;
+        return 0;
+    }
+    if (beats_q16 < 0) {
+        // Started, first clock not in yet: aim at beat 0
+        grid_played = -1;
+        return midi_clock_time_of(0);
+    }
+
+    int64_t pos_q16 = beats_q16 * cfg->arp_division;   // Steps since Start
+    int64_t idx = pos_q16 >> 16;
+
+    if (idx < grid_played) {
+        grid_played = -1;   // Start again: song position went back
+        step_idx = 0;
+    }
+    // A step that has not sounded yet plays unless it is over half late
+    if (idx > grid_played && (pos_q16 & 0xFFFF) < 0x8000) {
+        *play = true;
+        grid_played = idx;
+    }
+
+    int64_t next_q16 = ((idx + 1) << 16) + cfg->arp_division - 1;
+    return midi_clock_time_of(next_q16 / cfg->arp_division);
+}
+
+// Time of the step after the one at `due`, its length (for the gate) and
+// whether the step at `due` sounds
+static int64_t clock_next(const struct config_snapshot *cfg, int64_t due,
+                          int64_t *step, bool *play)
+{
+    if (cfg->arp_clock == ARP_CLOCK_MIDI) {
+        int64_t next = midi_grid_next(cfg, due, play);
+
+        *step = next - due;
+        return next ? next : due + k_ms_to_ticks_ceil64(ARP_IDLE_POLL_MS);
+    }
+
+    *step = internal_step_ticks(cfg);
+    *play = true;
+    return due + *step;
+}
+
+// ========== STEP ==========
+
+// Scheduler call (timer context)
+static void arp_step(int64_t due)
+{
+    const struct config_snapshot *cfg = config_snapshot_get();
+    k_spinlock_key_t key = k_spin_lock(&arp_lock);
+
+    if (cfg->arp_mode == ARP_OFF) {
+        stepping = false;
+        k_spin_unlock(&arp_lock, key);
+        config_snapshot_put(cfg);
+        return;
+    }
+
+    int64_t step;
+    bool play;
+    int64_t next = clock_next(cfg, due, &step, &play);
+
+    if (play && held_len) {
+        int64_t gate = MAX(step * cfg->arp_gate / 100, 1);
+
+        if (cfg->arp_mode == ARP_REPEAT) {
+            for (int i = 0; i < held_len; i++) {
+                scheduler_post_midi(due, MIDI_BLE_NOTE_ON | MIDI_CHANNEL,
+                                    held[i].note, held[i].velocity);
+                scheduler_post_midi(due + gate, MIDI_BLE_NOTE_OFF | MIDI_CHANNEL,
+                                    held[i].note, ARP_OFF_VELOCITY);
+            }
+        } else {
+            const struct held_note *h =
+                &held[arp_pattern_pick(cfg->arp_mode, step_idx, held_len, &rng)];
+            scheduler_post_midi(due, MIDI_BLE_NOTE_ON | MIDI_CHANNEL,
+                                h->note, h->velocity);
+            scheduler_post_midi(due + gate, MIDI_BLE_NOTE_OFF | MIDI_CHANNEL,
+                                h->note, ARP_OFF_VELOCITY);
+        }
+        step_idx++;
+        steps++;
+    }
+
+    // Stay on the grid, but never queue a backlog of steps after a stall
+    int64_t now = scheduler_now();
+    if (next <= now) {
+        next = now + 1;
+    }
+    stepping = (scheduler_post_call(next, arp_step) == 0);
+    k_spin_unlock(&arp_lock, key);
+    config_snapshot_put(cfg);
+}
+
+// ========== HELD NOTES ==========
+
+void arp_note_on(uint8_t note, uint8_t velocity)
+{
+    const struct config_snapshot *cfg = config_snapshot_get();
+    k_spinlock_key_t key = k_spin_lock(&arp_lock);
+    bool first = (held_len == 0);
+    int i;
+
+    for (i = 0; i < held_len && held[i].note < note; i++) {
+    }
+    if (i < held_len && held[i].note == note) {
+        held[i].velocity = velocity;
+    } else if (held_len < ARP_MAX_HELD) {
+        memmove(&held[i + 1], &held[i], (held_len - i) * sizeof(held[0]));
+        held[i] = (struct held_note){ .note = note, .velocity = velocity };
+        held_len++;
+    }
+
+    if (first) {
+        step_idx = 0;
+    }
+
+    // On the internal clock the first key starts the pattern right away;
+    // on MIDI clock the grid keeps following the clock
+    if (!stepping || (first && cfg->arp_clock == ARP_CLOCK_INTERNAL)) {
+        scheduler_cancel_call(arp_step);
+        stepping = (scheduler_post_call(scheduler_now(), arp_step) == 0);
+    }
+    k_spin_unlock(&arp_lock, key);
+    config_snapshot_put(cfg);
+}
+
+void arp_note_off(uint8_t note)
+{
+    k_spinlock_key_t key = k_spin_lock(&arp_lock);
+
+    for (int i = 0; i < held_len; i++) {
+        if (held[i].note == note) {
+            memmove(&held[i], &held[i + 1], (held_len - i - 1) * sizeof(held[0]));
+            held_len--;
+            break;
+        }
+    }
+    k_spin_unlock(&arp_lock, key);
+}
+
+void arp_get_status(struct arp_status *out)
+{
+    const struct config_snapshot *cfg = config_snapshot_get();
+    k_spinlock_key_t key = k_spin_lock(&arp_lock);
+
+    out->held = held_len;
+    out->steps = steps;
+    k_spin_unlock(&arp_lock, key);
+
+    if (cfg->arp_clock == ARP_CLOCK_MIDI) {
+        struct midi_clock_status clk;
+
+        midi_clock_get_status(&clk);
+        out->clock_running = clk.running;
+        out->tempo_x10 = clk.tempo_x100 / 10;
+    } else {
+        out->clock_running = true;
+        out->tempo_x10 = cfg->arp_tempo * 10;
+    }
+    config_snapshot_put(cfg);
+}
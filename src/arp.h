@@ -0,0 +1,56 @@
+#ifndef ARP_H
+#define ARP_H
+
+#include <zephyr/types.h>
+#include "midi_clock.h"
+
+// ========== ARPEGGIATOR / NOTE REPEAT ==========
+// With arp_mode set (Arpeggiator characteristic), keys no longer sound
+// directly: the scan thread only adds and removes held notes here, and a
+// step call on the MIDI event scheduler plays them on a beat grid. Each
+// step posts its Note On at the step time and its Note Off after the gate
+// time, so timing is set by the scheduler timer, not by the scan pass.
+//
+// The grid runs from the internal tempo, or from MIDI clock received over
+// BLE MIDI (midi_clock.c): steps sit on the tracked song position, so they
+// stay on the sender's beat; Start restarts the pattern, Stop silences it.
+
+enum arp_mode {
+    ARP_OFF,
+    ARP_UP,
+    ARP_DOWN,
+    ARP_UP_DOWN,
+    ARP_RANDOM,
+    ARP_REPEAT,       // Note repeat: every held note on every step
+    ARP_MODE_COUNT,
+};
+
+enum arp_clock {
+    ARP_CLOCK_INTERNAL,
+    ARP_CLOCK_MIDI,
+};
+
+#define ARP_MAX_HELD       16
+#define ARP_CLOCK_PPQN     MIDI_CLOCK_PPQN   // Divisions must be whole clocks
+
+struct arp_status {
+    uint8_t held;
+    bool clock_running;     // Internal clock, or MIDI clock ticking and started
+    uint16_t tempo_x10;     // BPM x 10 the grid runs at
+    uint32_t steps;
+};
+
+/**
+ * @brief A key routed to the arpeggiator went down (scan thread)
+ */
+void arp_note_on(uint8_t note, uint8_t velocity);
+
+/**
+ * @brief A key routed to the arpeggiator was released (scan thread)
+ */
+void arp_note_off(uint8_t note);
+
+/** @brief Get the arpeggiator state for diagnostics */
+void arp_get_status(struct arp_status *out);
+
+#endif // ARP_H
@@ -0,0 +1,30 @@
+#include "arp_pattern.h"
+#include "arp.h"
+
+static uint32_t next_random(uint32_t *rng)
+{
+    // xorshift32: cheap and good enough to pick a note
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 17;
+    *rng ^= *rng << 5;
+    return *rng;
+}
+
+int arp_pattern_pick(uint8_t mode, uint32_t step, uint32_t held, uint32_t *rng)
+{
+    switch (mode) {
+    case ARP_DOWN:
+        return held - 1 - step % held;
+    case ARP_UP_DOWN:
+        if (held == 1) {
+            return 0;
+        } else {
+            uint32_t pos = step % (2 * held - 2);
+            return pos < held ? pos : 2 * held - 2 - pos;
+        }
+    case ARP_RANDOM:
+        return next_random(rng) % held;
+    default:
+        return step % held;
+    }
+}
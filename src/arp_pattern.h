@@ -0,0 +1,26 @@
+#ifndef ARP_PATTERN_H
+#define ARP_PATTERN_H
+
+#include <zephyr/types.h>
+
+// ========== ARPEGGIATOR PATTERN ==========
+// Which held note a step plays. Held notes are sorted by pitch and steps
+// count from the first key that went down:
+// - Up / Down: lowest to highest / highest to lowest, then around again
+// - Up/Down: up then down without repeating the top and bottom notes
+//   (0 1 2 3 2 1 0 1 ...)
+// - Random: any held note, from a xorshift32 sequence
+// Pure logic, the step timing is in arp.c.
+
+/**
+ * @brief Index of the held note a step plays
+ *
+ * @param mode ARP_UP, ARP_DOWN, ARP_UP_DOWN or ARP_RANDOM (enum arp_mode)
+ * @param step Steps played since the first key went down
+ * @param held Number of held notes, at least 1
+ * @param rng xorshift32 state for ARP_RANDOM, never 0
+ * @return Index into the pitch-sorted held notes, below held
+ */
+int arp_pattern_pick(uint8_t mode, uint32_t step, uint32_t held, uint32_t *rng);
+
+#endif // ARP_PATTERN_H
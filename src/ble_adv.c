@@ -0,0 +1,334 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/sys/printk.h>
+#include "ble_adv.h"
+#include "ble_adv_policy.h"
+#include "ble_midi_service.h"
+
+// Advertising data
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+// Scan response data
+static const struct bt_data sd[] = {
+    BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_MIDI_SERVICE_VAL),
+};
+
+static bt_addr_le_t directed_peer;
+
+static const char *const phase_names[ADV_PHASE_COUNT] = {
+    [ADV_IDLE]        = "idle",
+    [ADV_DIRECTED]    = "directed",
+    [ADV_ACCEPT_LIST] = "accept list",
+    [ADV_FAST]        = "fast",
+    [ADV_SLOW]        = "slow",
+};
+
+// Phase state. Changed on the system workqueue only: advertising cannot
+// be restarted from inside the connection callbacks, so they only post a
+// request and reschedule adv_work.
+static enum ble_adv_phase phase = ADV_IDLE;
+static int64_t phase_end;               // 0 = runs until a connection
+
+static struct k_spinlock adv_lock;      // Everything below
+static enum ble_adv_phase requested;    // Phase to (re)enter, ADV_IDLE = none
+static bt_addr_le_t last_peer;          // Bonded central that disconnected
+static bool peer_pending;               // ... not tried with directed yet
+static int64_t disconnected_at;         // 0 = no reconnect being timed
+static struct ble_adv_stats stats;
+
+static atomic_t links;                  // Connected centrals
+
+static void adv_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(adv_work, adv_work_handler);
+
+static void request_phase(enum ble_adv_phase first, bool now)
+{
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+
+    requested = first;
+    k_spin_unlock(&adv_lock, key);
+
+    if (now) {
+        k_work_reschedule(&adv_work, K_NO_WAIT);
+    }
+}
+
+// ========== BONDS ==========
+struct bond_match {
+    const bt_addr_le_t *addr;
+    bool found;
+};
+
+static void bond_match_cb(const struct bt_bond_info *info, void *data)
+{
+    struct bond_match *m = data;
+
+    if (bt_addr_le_cmp(&info->addr, m->addr) == 0) {
+        m->found = true;
+    }
+}
+
+static bool is_bonded(const bt_addr_le_t *addr)
+{
+    struct bond_match m = { .addr = addr };
+
+    bt_foreach_bond(BT_ID_DEFAULT, bond_match_cb, &m);
+    return m.found;
+}
+
+static void bond_count_cb(const struct bt_bond_info *info, void *data)
+{
+    (*(uint8_t *)data)++;
+}
+
+static uint8_t bond_count(void)
+{
+    uint8_t n = 0;
+
+    bt_foreach_bond(BT_ID_DEFAULT, bond_count_cb, &n);
+    return n;
+}
+
+static void accept_list_add_cb(const struct bt_bond_info *info, void *data)
+{
+    int err = bt_le_filter_accept_list_add(&info->addr);
+
+    if (err) {
+        (*(int *)data)++;
+    }
+}
+
+// Put every bond on the controller's filter accept list; advertising must
+// be stopped. Rebuilt on each burst, so new bonds are always included.
+static int load_accept_list(void)
+{
+    int failed = 0;
+    int err = bt_le_filter_accept_list_clear();
+
+    if (err) {
+        return err;
+    }
+    bt_foreach_bond(BT_ID_DEFAULT, accept_list_add_cb, &failed);
+    return failed ? -ENOMEM : 0;
+}
+
+// ========== PHASES ==========
+// Skip phases that have no one to target (ble_adv_policy.c), then set up
+// the one chosen: the directed peer, or the accept list
+static enum ble_adv_phase first_usable(enum ble_adv_phase p)
+{
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+    bool have_peer = peer_pending;
+    k_spin_unlock(&adv_lock, key);
+
+    p = ble_adv_policy_first_usable(p, have_peer, bond_count() > 0);
+    if (p == ADV_DIRECTED) {
+        key = k_spin_lock(&adv_lock);
+        bt_addr_le_copy(&directed_peer, &last_peer);
+        peer_pending = false;   // One burst per disconnect
+        k_spin_unlock(&adv_lock, key);
+    } else if (p == ADV_ACCEPT_LIST && load_accept_list() != 0) {
+        p = ADV_FAST;
+    }
+    return p;
+}
+
+static int phase_start(enum ble_adv_phase p)
+{
+    struct ble_adv_interval iv = ble_adv_policy_interval(p);
+    struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_CONN,
+                                                        iv.min, iv.max, NULL);
+    int err;
+
+    switch (p) {
+    case ADV_DIRECTED:
+        param.peer = &directed_peer;
+        err = bt_le_adv_start(&param, NULL, 0, NULL, 0);
+        break;
+    case ADV_ACCEPT_LIST:
+        // Only bonded centrals may connect
+        param.options |= BT_LE_ADV_OPT_FILTER_CONN;
+        err = bt_le_adv_start(&param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+        break;
+    case ADV_FAST:
+    case ADV_SLOW:
+        err = bt_le_adv_start(&param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+        break;
+    default:
+        return 0;
+    }
+    return err == -EALREADY ? 0 : err;
+}
+
+static void set_phase(enum ble_adv_phase p, int64_t now)
+{
+    int64_t duration = ble_adv_policy_duration(p);
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+
+    phase = p;
+    phase_end = duration ? now + duration : 0;
+    stats.phase = p;
+    k_spin_unlock(&adv_lock, key);
+}
+
+// Enter a requested phase, move on when the current one has run out, or
+// resume the current one (e.g. once a connection object is free again)
+static int adv_update(void)
+{
+    int64_t now = k_uptime_get();
+    bool enter;
+
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+    enum ble_adv_phase req = requested;
+    requested = ADV_IDLE;
+    k_spin_unlock(&adv_lock, key);
+
+    enum ble_adv_phase next = ble_adv_policy_next(phase, req, phase_end && now >= phase_end,
+                                                  atomic_get(&links) < CONFIG_BT_MAX_CONN,
+                                                  &enter);
+    if (next == ADV_IDLE) {
+        if (enter) {
+            bt_le_adv_stop();
+            set_phase(ADV_IDLE, now);
+        }
+        return 0;
+    }
+    if (enter) {
+        bt_le_adv_stop();
+        set_phase(first_usable(next), now);
+    }
+
+    int err = phase_start(phase);
+    if (err) {
+        key = k_spin_lock(&adv_lock);
+        stats.errors++;
+        k_spin_unlock(&adv_lock, key);
+        // Retried when a connection object is recycled or the phase ends
+    }
+    if (phase_end) {
+        k_work_reschedule(&adv_work, K_MSEC(MAX(phase_end - now, 0)));
+    }
+    return err;
+}
+
+static void adv_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    int err = adv_update();
+    if (err) {
+        printk("Advertising failed to restart (%s, err %d)\n",
+               phase_names[phase], err);
+    }
+}
+
+// ========== CONNECTION EVENTS ==========
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (err == BT_HCI_ERR_ADV_TIMEOUT) {
+        // Nobody answered the directed burst
+        k_spinlock_key_t key = k_spin_lock(&adv_lock);
+        stats.directed_timeouts++;
+        k_spin_unlock(&adv_lock, key);
+        request_phase(ADV_ACCEPT_LIST, true);
+        return;
+    }
+    if (err) {
+        return;
+    }
+
+    atomic_inc(&links);
+
+    int64_t now = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+    if (disconnected_at) {
+        uint32_t ms = (uint32_t)(now - disconnected_at);
+
+        stats.reconnects++;
+        stats.by_phase[phase]++;
+        stats.last_ms = ms;
+        stats.total_ms += ms;
+        stats.max_ms = MAX(stats.max_ms, ms);
+        stats.min_ms = stats.reconnects == 1 ? ms : MIN(stats.min_ms, ms);
+        disconnected_at = 0;
+    }
+    k_spin_unlock(&adv_lock, key);
+
+    // Encrypt: re-uses the stored keys of a bonded central, pairs and
+    // bonds (Just Works) with a new one. Centrals that refuse still work.
+    if (bt_conn_set_security(conn, BT_SECURITY_L2)) {
+        printk("BLE: security request failed\n");
+    }
+
+    // Keep advertising while there is room for another central
+    request_phase(ADV_FAST, true);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    const bt_addr_le_t *dst = bt_conn_get_dst(conn);
+    bool bonded = is_bonded(dst);
+
+    atomic_dec(&links);
+
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+    if (!disconnected_at) {
+        disconnected_at = k_uptime_get();
+    }
+    if (bonded) {
+        bt_addr_le_copy(&last_peer, dst);
+        peer_pending = true;
+    }
+    k_spin_unlock(&adv_lock, key);
+
+    // Started once the connection object is recycled
+    request_phase(ADV_DIRECTED, false);
+}
+
+// The connection object is free again - a slot can be advertised
+static void recycled(void)
+{
+    k_work_reschedule(&adv_work, K_NO_WAIT);
+}
+
+BT_CONN_CB_DEFINE(adv_conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+};
+
+// ========== API ==========
+int ble_adv_start(void)
+{
+    request_phase(ADV_ACCEPT_LIST, false);
+    return adv_update();
+}
+
+const char *ble_adv_phase_name(enum ble_adv_phase p)
+{
+    return p < ADV_PHASE_COUNT ? phase_names[p] : "?";
+}
+
+void ble_adv_get_stats(struct ble_adv_stats *out)
+{
+    uint8_t bonds = bond_count();
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+
+    *out = stats;
+    k_spin_unlock(&adv_lock, key);
+    out->bonds = bonds;
+}
+
+void ble_adv_reset_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&adv_lock);
+    uint8_t p = stats.phase;
+
+    stats = (struct ble_adv_stats){ .phase = p };
+    k_spin_unlock(&adv_lock, key);
+}
@@ -0,0 +1,63 @@
+#ifndef BLE_ADV_H
+#define BLE_ADV_H
+
+#include <zephyr/types.h>
+
+// ========== ADVERTISING / RECONNECT ==========
+// Centrals bond with the keyboard (Just Works; keys kept in settings), and
+// whenever a link slot is free advertising walks through these phases:
+//   1. Directed: high-duty directed advertising to the bonded central that
+//      just disconnected (the controller gives up after 1.28 s)
+//   2. Accept list: fast advertising that only bonded centrals may connect
+//      to, for ADV_ACCEPT_LIST_MS
+//   3. Fast: general advertising, for ADV_FAST_MS
+//   4. Slow: low-duty general advertising until a central connects
+// A phase is skipped when it has no one to target: directed needs a bonded
+// peer that disconnected, the accept list needs at least one bond. At boot
+// the sequence starts at the accept list; after a new connection it
+// starts at fast, for the next central. The phase and interval choice is
+// in ble_adv_policy.c.
+
+#define ADV_ACCEPT_LIST_MS  10000
+#define ADV_FAST_MS         30000
+
+enum ble_adv_phase {
+    ADV_IDLE,           // Every link slot is taken
+    ADV_DIRECTED,
+    ADV_ACCEPT_LIST,
+    ADV_FAST,
+    ADV_SLOW,
+    ADV_PHASE_COUNT
+};
+
+/** @brief Disconnect-to-reconnect timing */
+struct ble_adv_stats {
+    uint8_t phase;          // enum ble_adv_phase now
+    uint8_t bonds;          // Bonded centrals
+    uint32_t reconnects;    // Connections that ended a disconnected period
+    uint32_t by_phase[ADV_PHASE_COUNT]; // ... per phase they connected in
+    uint32_t last_ms;       // Disconnect -> connected, most recent
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t total_ms;      // Sum, for the average
+    uint32_t directed_timeouts; // Directed bursts nobody answered
+    uint32_t errors;        // Advertising start failures
+};
+
+/**
+ * @brief Start advertising (after bt_enable() and loading the bonds)
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int ble_adv_start(void);
+
+/** @brief Printable name of a phase */
+const char *ble_adv_phase_name(enum ble_adv_phase phase);
+
+/** @brief Get the reconnect counters */
+void ble_adv_get_stats(struct ble_adv_stats *out);
+
+/** @brief Clear the reconnect counters */
+void ble_adv_reset_stats(void);
+
+#endif // BLE_ADV_H
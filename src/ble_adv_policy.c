@@ -0,0 +1,70 @@
+#include <zephyr/bluetooth/gap.h>
+#include "ble_adv_policy.h"
+
+// The controller ends high-duty directed advertising after 1.28 s and the
+// stack reports it as a failed connection; this only covers a lost report
+#define ADV_DIRECTED_GUARD_MS  2000
+
+enum ble_adv_phase ble_adv_policy_next(enum ble_adv_phase current,
+                                       enum ble_adv_phase requested,
+                                       bool expired, bool slot_free, bool *enter)
+{
+    enum ble_adv_phase next = current;
+
+    *enter = false;
+    if (requested != ADV_IDLE) {
+        next = requested;
+        *enter = true;
+    } else if (expired && current < ADV_SLOW) {
+        next = current + 1;
+        *enter = true;
+    }
+
+    if (!slot_free) {
+        // Every slot is taken; the next disconnect requests a phase
+        *enter = (current != ADV_IDLE);
+        return ADV_IDLE;
+    }
+    if (next == ADV_IDLE) {
+        // A slot came free without a request (e.g. at startup)
+        next = ADV_FAST;
+        *enter = true;
+    }
+    return next;
+}
+
+enum ble_adv_phase ble_adv_policy_first_usable(enum ble_adv_phase p, bool have_peer,
+                                               bool have_bonds)
+{
+    if (p == ADV_DIRECTED && !have_peer) {
+        p = ADV_ACCEPT_LIST;
+    }
+    if (p == ADV_ACCEPT_LIST && !have_bonds) {
+        p = ADV_FAST;
+    }
+    return p;
+}
+
+int64_t ble_adv_policy_duration(enum ble_adv_phase p)
+{
+    switch (p) {
+    case ADV_DIRECTED:    return ADV_DIRECTED_GUARD_MS;
+    case ADV_ACCEPT_LIST: return ADV_ACCEPT_LIST_MS;
+    case ADV_FAST:        return ADV_FAST_MS;
+    default:              return 0;
+    }
+}
+
+struct ble_adv_interval ble_adv_policy_interval(enum ble_adv_phase p)
+{
+    switch (p) {
+    case ADV_ACCEPT_LIST:
+        return (struct ble_adv_interval){ BT_GAP_ADV_FAST_INT_MIN_1, BT_GAP_ADV_FAST_INT_MAX_1 };
+    case ADV_FAST:
+        return (struct ble_adv_interval){ BT_GAP_ADV_FAST_INT_MIN_2, BT_GAP_ADV_FAST_INT_MAX_2 };
+    case ADV_SLOW:
+        return (struct ble_adv_interval){ BT_GAP_ADV_SLOW_INT_MIN, BT_GAP_ADV_SLOW_INT_MAX };
+    default:
+        return (struct ble_adv_interval){ 0, 0 };
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef BLE_ADV_POLICY_H
+#define BLE_ADV_POLICY_H
+
+#include <zephyr/types.h>
+#include "ble_adv.h"
+
+// ========== ADVERTISING PHASE POLICY ==========
+// Which phase ble_adv.c advertises in, how long and how fast (see the
+// phase list in ble_adv.h). Pure logic: the connection events, the bond
+// store and the controller calls stay in ble_adv.c.
+
+/** @brief Advertising interval range, in 0.625 ms units */
+struct ble_adv_interval {
+    uint16_t min;
+    uint16_t max;       // 0 for high-duty directed: the controller picks
+};
+
+/**
+ * @brief Phase to advertise in next
+ *
+ * A requested phase (from a connection event) is entered even if it is
+ * the current one; otherwise an expired phase moves on to the one after
+ * it. With every link slot taken nothing runs.
+ *
+ * @param current Phase running now
+ * @param requested Phase a connection event asked for, ADV_IDLE = none
+ * @param expired The current phase has run out
+ * @param slot_free At least one link slot is free
+ * @param enter Set if advertising has to be stopped and the returned
+ *              phase entered (ADV_IDLE: stopped), cleared to resume current
+ * @return Phase to run, before ble_adv_policy_first_usable()
+ */
+enum ble_adv_phase ble_adv_policy_next(enum ble_adv_phase current,
+                                       enum ble_adv_phase requested,
+                                       bool expired, bool slot_free, bool *enter);
+
+/**
+ * @brief First phase from p on that has someone to target
+ *
+ * @param p Phase to start at
+ * @param have_peer A bonded central disconnected and has not had its
+ *                  directed burst yet
+ * @param have_bonds At least one central is bonded
+ * @return p, or a later phase
+ */
+enum ble_adv_phase ble_adv_policy_first_usable(enum ble_adv_phase p, bool have_peer,
+                                               bool have_bonds);
+
+/**
+ * @brief How long a phase runs before the next one
+ *
+ * @return Milliseconds, 0 = until a central connects
+ */
+int64_t ble_adv_policy_duration(enum ble_adv_phase p);
+
+/** @brief Advertising interval of a phase ({0, 0} for ADV_IDLE) */
+struct ble_adv_interval ble_adv_policy_interval(enum ble_adv_phase p);
+
+#endif // BLE_ADV_POLICY_H
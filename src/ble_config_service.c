@@ -3,7 +3,14 @@
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
 #include "ble_config_service.h"
+#include "config_snapshot.h"
+#include "config_store.h"
+#include "latency_stats.h"
+#include "arp.h"
+#include "kbd_state.h"
 
 LOG_MODULE_REGISTER(ble_conf, LOG_LEVEL_INF);
 
@@ -11,6 +18,14 @@ LOG_MODULE_REGISTER(ble_conf, LOG_LEVEL_INF);
 uint8_t g_sensitivity = 50;
 uint8_t g_led_theme = 0;
 int8_t  g_transpose = 0;
+uint8_t g_guide_channel = 0;
+struct arp_settings g_arp = {
+    .mode = 0,
+    .division = 4,
+    .gate = 50,
+    .tempo = 120,
+    .clock = 0,
+};
 
 // ========== UUID DEFINITIONS ==========
 // Base UUID: 12345678-1234-5678-1234-56789abc0000
@@ -27,13 +42,39 @@ int8_t  g_transpose = 0;
 #define BT_UUID_TRANSPOSE_VAL \
     BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abc0003)
 
+// Diagnostics (read-only)
+#define BT_UUID_LATENCY_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abc0004)
+
+#define BT_UUID_GUIDE_CHANNEL_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abc0005)
+
+#define BT_UUID_ARP_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abc0006)
+
+// Telemetry (read / notify)
+#define BT_UUID_KEY_STATE_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abc0007)
+
 #define BT_UUID_SUPERR_SERVICE  BT_UUID_DECLARE_128(BT_UUID_SUPERR_VAL)
 #define BT_UUID_SENSITIVITY     BT_UUID_DECLARE_128(BT_UUID_SENSITIVITY_VAL)
 #define BT_UUID_THEME           BT_UUID_DECLARE_128(BT_UUID_THEME_VAL)
 #define BT_UUID_TRANSPOSE       BT_UUID_DECLARE_128(BT_UUID_TRANSPOSE_VAL)
+#define BT_UUID_LATENCY         BT_UUID_DECLARE_128(BT_UUID_LATENCY_VAL)
+#define BT_UUID_GUIDE_CHANNEL   BT_UUID_DECLARE_128(BT_UUID_GUIDE_CHANNEL_VAL)
+#define BT_UUID_ARP             BT_UUID_DECLARE_128(BT_UUID_ARP_VAL)
+#define BT_UUID_KEY_STATE       BT_UUID_DECLARE_128(BT_UUID_KEY_STATE_VAL)
 
 // ========== CALLBACKS ==========
 
+// Common tail for every setting write: republish for the hot paths and
+// queue the (debounced) flash save
+static void setting_changed(void)
+{
+    config_snapshot_request_update();
+    config_store_schedule_save();
+}
+
 // 1. Sensitivity Write Callback (0-100)
 static ssize_t write_sensitivity(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                                  const void *buf, uint16_t len, uint16_t offset,
@@ -46,6 +87,7 @@ static ssize_t write_sensitivity(struct bt_conn *conn, const struct bt_gatt_attr
     
     g_sensitivity = val;
     LOG_INF("Sensitivity updated to: %d", val);
+    setting_changed();
     
     return len;
 }
@@ -62,6 +104,7 @@ static ssize_t write_theme(struct bt_conn *conn, const struct bt_gatt_attr *attr
     
     g_led_theme = val;
     LOG_INF("LED Theme updated to: %d", val);
+    setting_changed();
     
     return len;
 }
@@ -80,10 +123,109 @@ static ssize_t write_transpose(struct bt_conn *conn, const struct bt_gatt_attr *
     
     g_transpose = val;
     LOG_INF("Transpose updated to: %d", val);
+    setting_changed();
     
     return len;
 }
 
+// 4. Guide Channel Write Callback (0=Off, 1-16)
+// Note On/Off received on this channel light the keys (see main.c)
+static ssize_t write_guide_channel(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                   const void *buf, uint16_t len, uint16_t offset,
+                                   uint8_t flags)
+{
+    if (len != 1) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+    uint8_t val = *((uint8_t *)buf);
+    if (val > 16) return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+
+    g_guide_channel = val;
+    LOG_INF("Guide channel updated to: %d", val);
+    setting_changed();
+
+    return len;
+}
+
+// 5. Arpeggiator Write Callback (5 bytes, see struct arp_settings)
+bool arp_settings_valid(const struct arp_settings *a)
+{
+    return a->mode < ARP_MODE_COUNT &&
+           a->division >= 1 && ARP_CLOCK_PPQN % a->division == 0 &&
+           a->gate >= 5 && a->gate <= 100 &&
+           a->tempo >= 40 && a->tempo <= 240 &&
+           a->clock <= ARP_CLOCK_MIDI;
+}
+
+static ssize_t write_arp(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                         const void *buf, uint16_t len, uint16_t offset,
+                         uint8_t flags)
+{
+    struct arp_settings val;
+
+    if (offset) return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    if (len != sizeof(val)) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+    memcpy(&val, buf, sizeof(val));
+    if (!arp_settings_valid(&val)) return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+
+    g_arp = val;
+    LOG_INF("Arpeggiator updated: mode %d, %d steps/beat, gate %d%%, %d BPM, clock %d",
+            val.mode, val.division, val.gate, val.tempo, val.clock);
+    setting_changed();
+
+    return len;
+}
+
+static ssize_t read_arp(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                        void *buf, uint16_t len, uint16_t offset)
+{
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &g_arp, sizeof(g_arp));
+}
+
+// 6. Latency Stats Read Callback
+// Layout (little-endian): version u8, span count u8, bucket width (us) u16,
+// then per span (queue, notify): count, p50, p99, max as u32 (us)
+static ssize_t read_latency(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            void *buf, uint16_t len, uint16_t offset)
+{
+    uint8_t out[4 + LATENCY_SPAN_COUNT * 16];
+    uint8_t *p = out;
+
+    *p++ = 1; // Format version
+    *p++ = LATENCY_SPAN_COUNT;
+    sys_put_le16(LATENCY_BUCKET_US, p);
+    p += 2;
+
+    for (int span = 0; span < LATENCY_SPAN_COUNT; span++) {
+        struct latency_summary sum;
+        latency_get_summary(span, &sum);
+        sys_put_le32(sum.count, p);
+        sys_put_le32(sum.p50_us, p + 4);
+        sys_put_le32(sum.p99_us, p + 8);
+        sys_put_le32(sum.max_us, p + 12);
+        p += 16;
+    }
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, out, sizeof(out));
+}
+
+// 7. Keyboard State Read Callback / CCC (see kbd_state.h for the layout)
+// A read returns the whole snapshot, so a reconnecting app restores the
+// held keys with one request before relying on notifications
+static ssize_t read_key_state(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                              void *buf, uint16_t len, uint16_t offset)
+{
+    uint8_t out[KBD_STATE_MAX_LEN];
+    size_t out_len = kbd_state_encode(out);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, out, out_len);
+}
+
+static void key_state_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    kbd_state_subscribed(value == BT_GATT_CCC_NOTIFY);
+}
+
 // ========== SERVICE DEFINITION ==========
 BT_GATT_SERVICE_DEFINE(superr_svc,
     BT_GATT_PRIMARY_SERVICE(BT_UUID_SUPERR_SERVICE),
@@ -104,9 +246,45 @@ BT_GATT_SERVICE_DEFINE(superr_svc,
     BT_GATT_CHARACTERISTIC(BT_UUID_TRANSPOSE,
                            BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
                            BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
-                           NULL, write_transpose, &g_transpose)
+                           NULL, write_transpose, &g_transpose),
+
+    // Characteristic: Guide Channel (Read/Write)
+    BT_GATT_CHARACTERISTIC(BT_UUID_GUIDE_CHANNEL,
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                           NULL, write_guide_channel, &g_guide_channel),
+
+    // Characteristic: Arpeggiator (Read/Write)
+    BT_GATT_CHARACTERISTIC(BT_UUID_ARP,
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+                           read_arp, write_arp, NULL),
+
+    // Characteristic: Latency Stats (Read)
+    BT_GATT_CHARACTERISTIC(BT_UUID_LATENCY,
+                           BT_GATT_CHRC_READ,
+                           BT_GATT_PERM_READ,
+                           read_latency, NULL, NULL),
+
+    // Characteristic: Keyboard State (Read/Notify)
+    BT_GATT_CHARACTERISTIC(BT_UUID_KEY_STATE,
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_READ,
+                           read_key_state, NULL, NULL),
+    BT_GATT_CCC(key_state_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE)
 );
 
+const struct bt_gatt_attr *ble_config_key_state_attr(void)
+{
+    static const struct bt_gatt_attr *attr;
+
+    if (!attr) {
+        attr = bt_gatt_find_by_uuid(superr_svc.attrs, superr_svc.attr_count,
+                                    BT_UUID_KEY_STATE);
+    }
+    return attr;
+}
+
 int ble_config_init(void)
 {
     // Zephyr's BT_GATT_SERVICE_DEFINE automatically registers it at boot time.
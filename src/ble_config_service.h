@@ -2,17 +2,39 @@
 #define BLE_CONFIG_SERVICE_H
 
 #include <zephyr/types.h>
+#include <zephyr/toolchain.h>
+#include <stdbool.h>
 
 // ========== GLOBAL SETTINGS ==========
-// These are modified by the Phone App via Bluetooth
-// and read by the Main Loop to change behavior.
+// These are modified by the Phone App via Bluetooth.
+// Hot paths must not read them directly - use config_snapshot_get().
 
 extern uint8_t g_sensitivity; // 0 (Hard) to 100 (Sensitive). Default: 50
 extern uint8_t g_led_theme;   // 0=Aurora, 1=Fire, 2=Matrix. Default: 0
 extern int8_t  g_transpose;   // -12 to +12 semitones. Default: 0
+extern uint8_t g_guide_channel; // 0=Off, 1-16 = MIDI channel lighting guide keys. Default: 0
+
+// Arpeggiator / note repeat (see arp.h), one 5-byte characteristic
+struct arp_settings {
+    uint8_t mode;       // enum arp_mode. Default: 0 (Off)
+    uint8_t division;   // Steps per beat, divides 24 (1=1/4, 2=1/8, 3=1/8T, 4=1/16, ...). Default: 4
+    uint8_t gate;       // Note length, % of a step (5-100). Default: 50
+    uint8_t tempo;      // Internal clock BPM (40-240). Default: 120
+    uint8_t clock;      // enum arp_clock. Default: 0 (Internal)
+} __packed;
+
+extern struct arp_settings g_arp;
+
+/** @brief Clamp / validate arpeggiator settings; false if unusable */
+bool arp_settings_valid(const struct arp_settings *a);
 
 // ========== API ==========
+struct bt_gatt_attr;
+
 /** @brief Initialize the Configuration Service */
 int ble_config_init(void);
 
+/** @brief Value attribute of the Keyboard State characteristic (kbd_state.c) */
+const struct bt_gatt_attr *ble_config_key_state_attr(void);
+
 #endif
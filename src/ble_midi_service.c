@@ -3,12 +3,18 @@
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
+#include <zephyr/settings/settings.h>
 #include <zephyr/sys/printk.h>
 #include "ble_midi_service.h"
-
-// BLE MIDI Service UUID: 03B80E5A-EDE8-4B33-A751-6CE34EC4C700
-#define BT_UUID_MIDI_SERVICE_VAL \
-    BT_UUID_128_ENCODE(0x03B80E5A, 0xEDE8, 0x4B33, 0xA751, 0x6CE34EC4C700)
+#include "ble_adv.h"
+#include "boot_timing.h"
+#include "latency_stats.h"
+#include "midi_ble.h"
+#include "midi_ble_rx.h"
+#include "keyboard.h"
+#if defined(CONFIG_SUPERR_SIM)
+#include "sim.h"
+#endif
 
 // MIDI I/O Characteristic UUID: 7772E5DB-3868-4112-A1A9-F2669D106BF3
 #define BT_UUID_MIDI_IO_VAL \
@@ -17,9 +23,36 @@
 #define BT_UUID_MIDI_SERVICE  BT_UUID_DECLARE_128(BT_UUID_MIDI_SERVICE_VAL)
 #define BT_UUID_MIDI_IO       BT_UUID_DECLARE_128(BT_UUID_MIDI_IO_VAL)
 
-// Connection tracking
-static struct bt_conn *current_conn = NULL;
-static bool notify_enabled = false;
+// ========== PER-LINK STATE ==========
+// Up to CONFIG_BT_MAX_CONN centrals are served at once. Every MIDI packet
+// is fanned out to each link that has notifications enabled. A link may
+// only have MIDI_LINK_CREDITS notifications in flight; a credit is taken
+// per notify and returned from the completion callback, so a slow central
+// can never hold the shared TX buffers the other links need (see the TX
+// scheduler below for what it misses).
+#define MIDI_LINK_CREDITS  4
+
+#if defined(CONFIG_BT_L2CAP_TX_BUF_COUNT)
+BUILD_ASSERT(MIDI_LINK_CREDITS * CONFIG_BT_MAX_CONN <= CONFIG_BT_L2CAP_TX_BUF_COUNT,
+             "Every link must be able to use all of its credits at once");
+#endif
+
+struct midi_link {
+    struct bt_conn *conn;      // NULL = free slot
+    uint16_t mtu;              // ATT MTU
+    uint16_t interval;         // Connection interval (1.25 ms units)
+    uint8_t tx_phy;            // BT_GAP_LE_PHY_*
+    atomic_t credits;          // Notifications this link may still queue
+    uint32_t sent;
+    uint32_t dropped;          // Packets this link missed
+    // Note Offs this link still owes its central (channel + 1, 0 = none);
+    // TX thread only
+    uint8_t pending_off[128];
+    bool has_pending_off;
+};
+
+static struct midi_link links[CONFIG_BT_MAX_CONN];
+static struct k_spinlock links_lock;
 
 // BLE Status LED
 static const struct gpio_dt_spec *ble_status_led_ptr = NULL;
@@ -27,6 +60,18 @@ static const struct gpio_dt_spec *ble_status_led_ptr = NULL;
 // MIDI data buffer (for read operations - optional)
 static uint8_t midi_data_buf[20] = {0};
 static uint8_t midi_data_len = 0;
+static struct k_spinlock midi_data_lock;
+
+// Link lookup - call with links_lock held
+static struct midi_link *link_find(struct bt_conn *conn)
+{
+    for (int i = 0; i < ARRAY_SIZE(links); i++) {
+        if (links[i].conn == conn) {
+            return &links[i];
+        }
+    }
+    return NULL;
+}
 
 // Forward declarations
 static ssize_t read_midi_io(struct bt_conn *conn, const struct bt_gatt_attr *attr,
@@ -51,24 +96,68 @@ BT_GATT_SERVICE_DEFINE(midi_svc,
 static ssize_t read_midi_io(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                             void *buf, uint16_t len, uint16_t offset)
 {
-    // Return last MIDI data sent (optional)
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, midi_data_buf, midi_data_len);
+    uint8_t data[sizeof(midi_data_buf)];
+    uint8_t data_len;
+
+    // Return last MIDI data sent (optional), copied as one packet: the TX
+    // thread may replace it while the read runs
+    k_spinlock_key_t key = k_spin_lock(&midi_data_lock);
+    data_len = midi_data_len;
+    memcpy(data, midi_data_buf, data_len);
+    k_spin_unlock(&midi_data_lock, key);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, data, data_len);
 }
 
 // Write MIDI I/O characteristic (for receiving MIDI from central)
 static ssize_t write_midi_io(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                              const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
 {
-    // Handle incoming MIDI data (optional - for bidirectional MIDI)
-    printk("Received MIDI data: %d bytes\n", len);
+    // Parsed in place into the receive rings (midi_ble_rx.c); nothing is
+    // buffered or handed off here
+    if (offset) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
+    int slot = link ? (int)(link - links) : -1;
+    k_spin_unlock(&links_lock, key);
+
+    if (slot >= 0) {
+        midi_ble_rx_parse((uint8_t)slot, buf, len);
+    }
     return len;
 }
 
 // CCC (Client Characteristic Configuration) changed callback
+// value is the aggregate over all links; per-link state is checked with
+// bt_gatt_is_subscribed() at send time
 static void midi_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value)
 {
-    notify_enabled = (value == BT_GATT_CCC_NOTIFY);
-    printk("MIDI notifications %s\n", notify_enabled ? "enabled" : "disabled");
+    printk("MIDI notifications %s\n",
+           value == BT_GATT_CCC_NOTIFY ? "enabled" : "disabled on all links");
+}
+
+static int link_count(void)
+{
+    int n = 0;
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+
+    for (int i = 0; i < ARRAY_SIZE(links); i++) {
+        if (links[i].conn) {
+            n++;
+        }
+    }
+    k_spin_unlock(&links_lock, key);
+    return n;
+}
+
+static void update_status_led(void)
+{
+    if (ble_status_led_ptr && gpio_is_ready_dt(ble_status_led_ptr)) {
+        gpio_pin_set_dt(ble_status_led_ptr, link_count() > 0);
+    }
 }
 
 // Connection callbacks
@@ -76,56 +165,114 @@ static void connected(struct bt_conn *conn, uint8_t err)
 {
     if (err) {
         printk("BLE Connection failed (err 0x%02x)\n", err);
-    } else {
-        current_conn = bt_conn_ref(conn);
-        printk("BLE MIDI Connected\n");
-        
-        // Turn on BLE status LED
-        if (ble_status_led_ptr && gpio_is_ready_dt(ble_status_led_ptr)) {
-            gpio_pin_set_dt(ble_status_led_ptr, 1);
-        }
+        return;
+    }
+
+    struct bt_conn_info info;
+    struct midi_link *link;
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+
+    link = link_find(NULL);
+    if (link) {
+        link->conn = bt_conn_ref(conn);
+        link->mtu = bt_gatt_get_mtu(conn);
+        link->interval = 0;
+        link->tx_phy = BT_GAP_LE_PHY_1M;
+        link->sent = 0;
+        link->dropped = 0;
+        memset(link->pending_off, 0, sizeof(link->pending_off));
+        link->has_pending_off = false;
+        atomic_set(&link->credits, MIDI_LINK_CREDITS);
+        midi_ble_rx_reset((uint8_t)(link - links));
+    }
+    k_spin_unlock(&links_lock, key);
+
+    if (!link) {
+        // More links than slots cannot happen with BT_MAX_CONN sized
+        // arrays, but never track a connection we have no room for
+        printk("BLE MIDI: no free link slot\n");
+        return;
     }
+
+    if (bt_conn_get_info(conn, &info) == 0) {
+        link->interval = info.le.interval;
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+        link->tx_phy = info.le.phy->tx_phy;
+#endif
+    }
+
+    printk("BLE MIDI Connected (link %d, %d active)\n",
+           (int)(link - links), link_count());
+    update_status_led();
 }
 
 static void disconnected(struct bt_conn *conn, uint8_t reason)
 {
-    printk("BLE MIDI Disconnected (reason 0x%02x)\n", reason);
-    
-    if (current_conn) {
-        bt_conn_unref(current_conn);
-        current_conn = NULL;
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
+    struct bt_conn *old = NULL;
+
+    if (link) {
+        old = link->conn;
+        link->conn = NULL;
     }
-    
-    notify_enabled = false;
-    
-    // Turn off BLE status LED
-    if (ble_status_led_ptr && gpio_is_ready_dt(ble_status_led_ptr)) {
-        gpio_pin_set_dt(ble_status_led_ptr, 0);
+    k_spin_unlock(&links_lock, key);
+
+    if (old) {
+        bt_conn_unref(old);
     }
+
+    printk("BLE MIDI Disconnected (reason 0x%02x, %d active)\n", reason, link_count());
+    update_status_led();
 }
 
-BT_CONN_CB_DEFINE(conn_callbacks) = {
-    .connected = connected,
-    .disconnected = disconnected,
-};
+static void le_param_updated(struct bt_conn *conn, uint16_t interval,
+                             uint16_t latency, uint16_t timeout)
+{
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
 
-// Advertising parameters (new API - no deprecated options)
-static struct bt_le_adv_param adv_param = BT_LE_ADV_PARAM_INIT(
-    BT_LE_ADV_OPT_CONN,
-    BT_GAP_ADV_FAST_INT_MIN_2,
-    BT_GAP_ADV_FAST_INT_MAX_2,
-    NULL
-);
+    if (link) {
+        link->interval = interval;
+    }
+    k_spin_unlock(&links_lock, key);
+}
+
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
+
+    if (link) {
+        link->tx_phy = param->tx_phy;
+    }
+    k_spin_unlock(&links_lock, key);
+}
+#endif
+
+static void att_mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx)
+{
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
+
+    if (link) {
+        link->mtu = MIN(tx, rx);
+    }
+    k_spin_unlock(&links_lock, key);
+}
 
-// Advertising data
-static const struct bt_data ad[] = {
-    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+static struct bt_gatt_cb gatt_callbacks = {
+    .att_mtu_updated = att_mtu_updated,
 };
 
-// Scan response data
-static const struct bt_data sd[] = {
-    BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_MIDI_SERVICE_VAL),
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .le_param_updated = le_param_updated,
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+    .le_phy_updated = le_phy_updated,
+#endif
 };
 
 // Initialize BLE MIDI
@@ -146,45 +293,487 @@ int ble_midi_init(const struct gpio_dt_spec *status_led)
     }
 
     printk("Bluetooth initialized\n");
+    boot_timing_mark(BOOT_PHASE_BT_ENABLED);
+
+    if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+        // Identity and bonds; advertising cannot start before they are in
+        settings_load_subtree("bt");
+    }
 
-    // Start advertising (using new API)
-    err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    bt_gatt_cb_register(&gatt_callbacks);
+
+    err = ble_adv_start();
     if (err) {
         printk("Advertising failed to start (err %d)\n", err);
         return err;
     }
 
+    boot_timing_mark(BOOT_PHASE_ADVERTISING);
     printk("BLE MIDI advertising as '%s'\n", CONFIG_BT_DEVICE_NAME);
     
     return 0;
 }
 
-// Send MIDI data
-int ble_midi_send(const uint8_t *data, uint8_t len)
+// ========== TX SCHEDULER ==========
+// The scan thread never calls into the host stack: ble_midi_send_event()
+// only puts the message in a bounded queue and wakes the TX thread, which
+// batches queued messages into one packet and fans it out to the links.
+//
+// Back-pressure policy (queue full):
+// - Control Changes are always merged: a newer value for a controller that
+//   is still queued overwrites the old one.
+// - Note Ons and CCs that do not fit are dropped.
+// - Note Offs are never dropped. They evict the oldest queued Note On or CC
+//   (a queued Note On for the same note is cancelled with it), and if the
+//   queue only holds Note Offs they are parked for every link.
+// While no link has a credit the queue simply holds. Once any link can
+// send, a link with no credit left misses the packet - a slow central must
+// not hold up the others - but keeps the Note Offs from it in its
+// pending-off table; those are sent first once it has a credit again.
+#define MIDI_TX_QUEUE_LEN    32
+#define MIDI_TX_MAX_PACKET   64   // Payload cap regardless of MTU
+#define MIDI_TX_ATT_OVERHEAD 3    // Notification opcode + handle
+
+struct midi_tx_event {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint32_t time_ms;        // Enqueue time (packet timestamp)
+    uint32_t capture_cyc;    // Latency stamp, 0 = untimed
+};
+
+static struct midi_tx_event tx_queue[MIDI_TX_QUEUE_LEN];
+static uint8_t tx_head;      // Next to send
+static uint8_t tx_count;
+static struct k_spinlock tx_lock;
+static struct ble_midi_tx_stats tx_stats;
+static atomic_t tx_stats_gen;    // Odd while a tx_lock holder updates tx_stats
+static uint8_t overflow_off[128];   // Parked Note Offs (channel + 1, 0 = none)
+static bool has_overflow_off;
+static K_SEM_DEFINE(tx_sem, 0, 1);
+
+static inline bool is_note_off(const struct midi_tx_event *e)
+{
+    uint8_t type = e->status & 0xF0;
+    return type == MIDI_BLE_NOTE_OFF || (type == MIDI_BLE_NOTE_ON && e->data2 == 0);
+}
+
+static inline struct midi_tx_event *tx_at(int i)
+{
+    return &tx_queue[(tx_head + i) % MIDI_TX_QUEUE_LEN];
+}
+
+// Remove queue entry i (0 = oldest), keeping order - call with tx_lock held
+static void tx_remove(int i)
 {
-    if (!data || len == 0 || len > sizeof(midi_data_buf)) {
-        return -EINVAL;
+    for (; i < tx_count - 1; i++) {
+        *tx_at(i) = *tx_at(i + 1);
     }
+    tx_count--;
+}
 
-    // Store for read operations
-    memcpy(midi_data_buf, data, len);
-    midi_data_len = len;
-    
-    // Send notification if connected and enabled
-    if (current_conn && notify_enabled) {
-        int err = bt_gatt_notify(current_conn, &midi_svc.attrs[1], data, len);
-        if (err) {
-            printk("MIDI notify failed (err %d)\n", err);
-            return err;
+int ble_midi_send_event(uint8_t status, uint8_t data1, uint8_t data2, uint32_t capture_cyc)
+{
+    struct midi_tx_event e = {
+        .status = status,
+        .data1 = data1,
+        .data2 = data2,
+        .time_ms = k_uptime_get_32(),
+        .capture_cyc = capture_cyc,
+    };
+    int ret = 0;
+
+#if defined(CONFIG_SUPERR_SIM)
+    // Everything the firmware sends, before queueing and back-pressure
+    sim_midi_capture(status, data1, data2);
+#endif
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    atomic_inc(&tx_stats_gen);
+    tx_stats.enqueued++;
+
+    // Collapse redundant CCs: only the latest value matters
+    if ((status & 0xF0) == MIDI_BLE_CONTROL_CHANGE) {
+        for (int i = tx_count - 1; i >= 0; i--) {
+            struct midi_tx_event *q = tx_at(i);
+            if (q->status == status && q->data1 == data1) {
+                q->data2 = data2;
+                tx_stats.merged++;
+                goto out;
+            }
         }
     }
-    
-    return 0;
+
+    if (tx_count == MIDI_TX_QUEUE_LEN) {
+        if (!is_note_off(&e)) {
+            tx_stats.dropped++;
+            ret = -ENOMEM;
+            goto out;
+        }
+
+        // Make room by trimming the oldest Note On / CC
+        int victim = -1;
+        for (int i = 0; i < tx_count; i++) {
+            if (!is_note_off(tx_at(i))) {
+                victim = i;
+                break;
+            }
+        }
+        if (victim < 0) {
+            overflow_off[data1 & 0x7F] = (status & 0x0F) + 1;
+            has_overflow_off = true;
+            goto out;
+        }
+
+        struct midi_tx_event *v = tx_at(victim);
+        bool cancels = (v->status & 0xF0) == MIDI_BLE_NOTE_ON &&
+                       (v->status & 0x0F) == (status & 0x0F) && v->data1 == data1;
+        tx_remove(victim);
+        tx_stats.trimmed++;
+        if (cancels) {
+            // The note never sounded, so its Note Off is not needed either
+            goto out;
+        }
+    }
+
+    *tx_at(tx_count) = e;
+    tx_count++;
+    if (tx_count > tx_stats.max_depth) {
+        tx_stats.max_depth = tx_count;
+    }
+
+out:
+    tx_stats.depth = tx_count;
+    atomic_inc(&tx_stats_gen);
+    k_spin_unlock(&tx_lock, key);
+    k_sem_give(&tx_sem);
+    return ret;
+}
+
+// Notification sent (called from the BT host once the controller has
+// taken the packet) - returns the link's credit, wakes the TX thread and
+// closes the capture -> air latency span of the packet's oldest message
+static void midi_notify_complete(struct bt_conn *conn, void *user_data)
+{
+    uint32_t capture_cyc = (uint32_t)(uintptr_t)user_data;
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    struct midi_link *link = link_find(conn);
+
+    if (link) {
+        atomic_inc(&link->credits);
+    }
+    k_spin_unlock(&links_lock, key);
+    k_sem_give(&tx_sem);
+
+    if (capture_cyc) {
+        latency_record(LATENCY_NOTIFY, capture_cyc);
+    }
+}
+
+// Queue one packet on one link, spending a credit; false if none was left
+static bool link_notify(struct midi_link *link, struct bt_conn *conn,
+                        const uint8_t *data, uint16_t len, uint32_t capture_cyc)
+{
+    if (atomic_dec(&link->credits) <= 0) {
+        atomic_inc(&link->credits);
+        return false;
+    }
+
+    struct bt_gatt_notify_params params = {
+        .attr = &midi_svc.attrs[1],
+        .data = data,
+        .len = len,
+        .func = midi_notify_complete,
+        .user_data = (void *)(uintptr_t)capture_cyc,
+    };
+
+    if (bt_gatt_notify_cb(conn, &params)) {
+        atomic_inc(&link->credits);
+        return false;
+    }
+    link->sent++;
+    return true;
+}
+
+// Send a link's parked Note Offs; false if it ran out of credits first
+static bool link_flush_pending(struct midi_link *link, struct bt_conn *conn)
+{
+    uint8_t buf[MIDI_TX_MAX_PACKET];
+    struct midi_ble_packet pkt;
+    uint32_t now = k_uptime_get_32();
+    int note = 0;
+
+    while (link->has_pending_off) {
+        int first = note;
+        uint16_t cap = MIN(sizeof(buf), link->mtu - MIDI_TX_ATT_OVERHEAD);
+
+        midi_ble_packet_init(&pkt, buf, cap);
+        for (; note < 128; note++) {
+            if (!link->pending_off[note]) {
+                continue;
+            }
+            if (midi_ble_packet_add(&pkt, now, MIDI_BLE_NOTE_OFF | (link->pending_off[note] - 1),
+                                    note, DEFAULT_RELEASE_VELOCITY)) {
+                break;
+            }
+        }
+        if (pkt.len && !link_notify(link, conn, buf, pkt.len, 0)) {
+            return false;
+        }
+        for (int n = first; n < note; n++) {
+            link->pending_off[n] = 0;
+        }
+        link->has_pending_off = (note < 128);
+    }
+    return true;
+}
+
+// Build the next packet from the queue head without removing anything;
+// returns the number of messages it holds
+static int build_packet(struct midi_ble_packet *pkt, uint8_t *buf, uint16_t cap,
+                        uint32_t *oldest_cyc)
+{
+    int n = 0;
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    midi_ble_packet_init(pkt, buf, cap);
+    *oldest_cyc = 0;
+    while (n < tx_count) {
+        const struct midi_tx_event *e = tx_at(n);
+        if (midi_ble_packet_add(pkt, e->time_ms, e->status, e->data1, e->data2)) {
+            break;
+        }
+        if (!*oldest_cyc) {
+            *oldest_cyc = e->capture_cyc;
+        }
+        n++;
+    }
+    k_spin_unlock(&tx_lock, key);
+    return n;
+}
+
+// Keep the Note Offs among the first n queued messages for a link that
+// misses them (TX thread only - the pending tables are not shared)
+static void link_park_note_offs(struct midi_link *link, int n)
+{
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    for (int m = 0; m < n; m++) {
+        const struct midi_tx_event *e = tx_at(m);
+        if (is_note_off(e)) {
+            link->pending_off[e->data1 & 0x7F] = (e->status & 0x0F) + 1;
+            link->has_pending_off = true;
+        }
+    }
+    k_spin_unlock(&tx_lock, key);
 }
 
-// Check if connected
+// Hand Note Offs parked by a full queue to every link
+static void take_overflow_offs(struct midi_link **targets, int n_links)
+{
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    if (has_overflow_off) {
+        for (int note = 0; note < 128; note++) {
+            if (!overflow_off[note]) {
+                continue;
+            }
+            for (int i = 0; i < n_links; i++) {
+                targets[i]->pending_off[note] = overflow_off[note];
+                targets[i]->has_pending_off = true;
+            }
+            overflow_off[note] = 0;
+        }
+        has_overflow_off = false;
+    }
+    k_spin_unlock(&tx_lock, key);
+}
+
+static void midi_tx_thread_entry(void *p1, void *p2, void *p3)
+{
+    uint8_t buf[MIDI_TX_MAX_PACKET];
+    struct midi_ble_packet pkt;
+    struct bt_conn *conns[CONFIG_BT_MAX_CONN];
+    struct midi_link *targets[CONFIG_BT_MAX_CONN];
+
+    while (1) {
+        k_sem_take(&tx_sem, K_FOREVER);
+
+        // Drain until the queue is empty or no link can take more (a
+        // returned credit gives the semaphore again)
+        while (1) {
+            int n_links = 0;
+            int n_ready = 0;
+            uint16_t cap = sizeof(buf);
+
+            // Connected links, referenced so a disconnect cannot free them
+            uint16_t mtus[CONFIG_BT_MAX_CONN];
+            int n_conns = 0;
+            k_spinlock_key_t key = k_spin_lock(&links_lock);
+            for (int i = 0; i < ARRAY_SIZE(links); i++) {
+                if (links[i].conn) {
+                    conns[n_conns] = bt_conn_ref(links[i].conn);
+                    targets[n_conns] = &links[i];
+                    mtus[n_conns] = links[i].mtu;
+                    n_conns++;
+                }
+            }
+            k_spin_unlock(&links_lock, key);
+
+            // Keep the subscribed ones (GATT calls outside the spinlock)
+            for (int i = 0; i < n_conns; i++) {
+                if (!bt_gatt_is_subscribed(conns[i], &midi_svc.attrs[1], BT_GATT_CCC_NOTIFY)) {
+                    bt_conn_unref(conns[i]);
+                    continue;
+                }
+                conns[n_links] = conns[i];
+                targets[n_links] = targets[i];
+                cap = MIN(cap, mtus[i] - MIDI_TX_ATT_OVERHEAD);
+                n_links++;
+            }
+
+            // Parked Note Offs go first on every link
+            take_overflow_offs(targets, n_links);
+            for (int i = 0; i < n_links; i++) {
+                if (targets[i]->has_pending_off) {
+                    link_flush_pending(targets[i], conns[i]);
+                }
+                if (!targets[i]->has_pending_off && atomic_get(&targets[i]->credits) > 0) {
+                    n_ready++;
+                }
+            }
+
+            uint32_t oldest_cyc;
+            int n_msgs = 0;
+
+            // With subscribers but none ready, hold the queue (back-pressure)
+            if (n_links == 0 || n_ready > 0) {
+                n_msgs = build_packet(&pkt, buf, cap, &oldest_cyc);
+            }
+
+            if (n_msgs > 0) {
+                bool sent_any = false;
+
+                for (int i = 0; i < n_links; i++) {
+                    struct midi_link *link = targets[i];
+
+                    if (!link->has_pending_off &&
+                        link_notify(link, conns[i], buf, pkt.len, oldest_cyc)) {
+                        sent_any = true;
+                    } else {
+                        // Behind or out of credits: miss this packet but
+                        // keep its Note Offs (sent before anything newer)
+                        link->dropped++;
+                        link_park_note_offs(link, n_msgs);
+                    }
+                }
+
+                // Consume the messages: sent, parked or (no subscribers)
+                // nobody to send them to
+                key = k_spin_lock(&tx_lock);
+                for (int m = 0; m < n_msgs && sent_any; m++) {
+                    if (tx_at(m)->capture_cyc) {
+                        latency_record(LATENCY_QUEUE, tx_at(m)->capture_cyc);
+                    }
+                }
+                tx_head = (tx_head + n_msgs) % MIDI_TX_QUEUE_LEN;
+                tx_count -= n_msgs;
+                atomic_inc(&tx_stats_gen);
+                if (sent_any) {
+                    tx_stats.packets++;
+                    tx_stats.messages += n_msgs;
+                }
+                tx_stats.depth = tx_count;
+                atomic_inc(&tx_stats_gen);
+                k_spin_unlock(&tx_lock, key);
+
+                if (sent_any) {
+                    key = k_spin_lock(&midi_data_lock);
+                    midi_data_len = MIN(pkt.len, sizeof(midi_data_buf));
+                    memcpy(midi_data_buf, buf, midi_data_len);
+                    k_spin_unlock(&midi_data_lock, key);
+                }
+            }
+
+            for (int i = 0; i < n_links; i++) {
+                bt_conn_unref(conns[i]);
+            }
+
+            if (n_msgs == 0) {
+                break;
+            }
+        }
+    }
+}
+
+K_THREAD_DEFINE(midi_tx_thread, 1536, midi_tx_thread_entry, NULL, NULL, NULL,
+                2, 0, 0);
+
+// Lock-free: the writers already exclude each other with tx_lock and
+// bracket their updates with tx_stats_gen, so a reader (shell) only
+// retries, it never holds up the scan thread queuing a note
+void ble_midi_get_tx_stats(struct ble_midi_tx_stats *out)
+{
+    atomic_val_t before, after;
+
+    do {
+        before = atomic_get(&tx_stats_gen);
+        *out = tx_stats;
+        after = atomic_get(&tx_stats_gen);
+    } while ((before & 1) || before != after);
+}
+
+void ble_midi_reset_tx_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    atomic_inc(&tx_stats_gen);
+    memset(&tx_stats, 0, sizeof(tx_stats));
+    tx_stats.depth = tx_count;
+    atomic_inc(&tx_stats_gen);
+    k_spin_unlock(&tx_lock, key);
+}
+
+// Check if at least one client is connected with notifications enabled
 bool ble_midi_is_connected(void)
 {
-    return (current_conn != NULL && notify_enabled);
+    struct bt_conn *conns[CONFIG_BT_MAX_CONN];
+    int n = 0;
+    bool subscribed = false;
+
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+    for (int i = 0; i < ARRAY_SIZE(links); i++) {
+        if (links[i].conn) {
+            conns[n++] = bt_conn_ref(links[i].conn);
+        }
+    }
+    k_spin_unlock(&links_lock, key);
+
+    for (int i = 0; i < n; i++) {
+        subscribed |= bt_gatt_is_subscribed(conns[i], &midi_svc.attrs[1], BT_GATT_CCC_NOTIFY);
+        bt_conn_unref(conns[i]);
+    }
+    return subscribed;
 }
 
+int ble_midi_get_links(struct ble_midi_link_info *out, int max)
+{
+    int n = 0;
+    k_spinlock_key_t key = k_spin_lock(&links_lock);
+
+    for (int i = 0; i < ARRAY_SIZE(links) && n < max; i++) {
+        if (!links[i].conn) {
+            continue;
+        }
+        out[n].slot = i;
+        out[n].mtu = links[i].mtu;
+        out[n].interval = links[i].interval;
+        out[n].tx_phy = links[i].tx_phy;
+        out[n].credits = (uint8_t)atomic_get(&links[i].credits);
+        out[n].sent = links[i].sent;
+        out[n].dropped = links[i].dropped;
+        n++;
+    }
+    k_spin_unlock(&links_lock, key);
+    return n;
+}
@@ -4,6 +4,10 @@
 #include <zephyr/types.h>
 #include <zephyr/drivers/gpio.h>
 
+// BLE MIDI Service UUID: 03B80E5A-EDE8-4B33-A751-6CE34EC4C700
+#define BT_UUID_MIDI_SERVICE_VAL \
+    BT_UUID_128_ENCODE(0x03B80E5A, 0xEDE8, 0x4B33, 0xA751, 0x6CE34EC4C700)
+
 /**
  * @brief Initialize BLE MIDI service and start advertising
  * 
@@ -13,20 +17,71 @@
 int ble_midi_init(const struct gpio_dt_spec *status_led);
 
 /**
- * @brief Send MIDI data over BLE
- * 
- * @param data BLE MIDI packet data
- * @param len Length of data
- * @return 0 on success, negative on error
+ * @brief Queue a 3-byte MIDI message for every subscribed central
+ *
+ * Never blocks and never calls into the BT host: the message is queued
+ * and sent, batched with others, by the MIDI TX thread. When the queue is
+ * full, CCs are merged, Note Ons and CCs dropped, and Note Offs always
+ * kept (see ble_midi_service.c). A central that still has its notification
+ * credits in flight misses the packet rather than delaying the others,
+ * but still gets its Note Offs.
+ *
+ * Also safe from ISRs: the MIDI event scheduler sends from its timer
+ * callback.
+ *
+ * @param status Status byte (MIDI_BLE_NOTE_ON | channel, ...)
+ * @param data1 First data byte
+ * @param data2 Second data byte
+ * @param capture_cyc k_cycle_get_32() stamp of the key contact that produced
+ *                    this message for latency stats, 0 if untimed
+ * @return 0 if queued or merged, -ENOMEM if dropped
  */
-int ble_midi_send(const uint8_t *data, uint8_t len);
+int ble_midi_send_event(uint8_t status, uint8_t data1, uint8_t data2, uint32_t capture_cyc);
+
+/** @brief TX scheduler counters */
+struct ble_midi_tx_stats {
+    uint32_t enqueued;     // ble_midi_send_event() calls
+    uint32_t merged;       // CCs folded into a queued CC
+    uint32_t dropped;      // Note Ons / CCs refused by a full queue
+    uint32_t trimmed;      // Queued Note Ons / CCs evicted for a Note Off
+    uint32_t packets;      // Packets sent (to at least one link)
+    uint32_t messages;     // Messages in those packets
+    uint32_t depth;        // Current queue depth
+    uint32_t max_depth;    // Deepest the queue has been
+};
+
+/** @brief Get the TX scheduler counters */
+void ble_midi_get_tx_stats(struct ble_midi_tx_stats *out);
+
+/** @brief Clear the TX scheduler counters */
+void ble_midi_reset_tx_stats(void);
 
 /**
- * @brief Check if a BLE MIDI client is connected
+ * @brief Check if at least one BLE MIDI client is subscribed
  * 
  * @return true if connected, false otherwise
  */
 bool ble_midi_is_connected(void);
 
+/** @brief Snapshot of one connected BLE MIDI link (diagnostics) */
+struct ble_midi_link_info {
+    uint8_t slot;          // Link slot (0 .. CONFIG_BT_MAX_CONN - 1)
+    uint16_t mtu;          // ATT MTU
+    uint16_t interval;     // Connection interval (1.25 ms units)
+    uint8_t tx_phy;        // BT_GAP_LE_PHY_*
+    uint8_t credits;       // Notifications the link may still queue
+    uint32_t sent;         // Notifications queued
+    uint32_t dropped;      // Copies skipped (no credit / notify error)
+};
+
+/**
+ * @brief Get the state of the connected links
+ *
+ * @param out Array to fill
+ * @param max Capacity of out
+ * @return Number of links written
+ */
+int ble_midi_get_links(struct ble_midi_link_info *out, int max);
+
 #endif // BLE_MIDI_SERVICE_H
 
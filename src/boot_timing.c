@@ -0,0 +1,52 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "boot_timing.h"
+
+static uint32_t phase_us[BOOT_PHASE_COUNT];
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_MAIN]        = "main",
+    [BOOT_PHASE_GPIO]        = "gpio",
+    [BOOT_PHASE_SETTINGS]    = "settings",
+    [BOOT_PHASE_WATCHDOG]    = "watchdog",
+    [BOOT_PHASE_THREADS]     = "threads",
+    [BOOT_PHASE_FIRST_SCAN]  = "first scan",
+    [BOOT_PHASE_BT_ENABLED]  = "bt enabled",
+    [BOOT_PHASE_ADVERTISING] = "advertising",
+};
+
+void boot_timing_mark(enum boot_phase phase)
+{
+    if (phase >= BOOT_PHASE_COUNT || phase_us[phase] != 0) {
+        return;
+    }
+
+    uint32_t now = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+    phase_us[phase] = now ? now : 1; // 0 means "not reached"
+}
+
+uint32_t boot_timing_get(enum boot_phase phase)
+{
+    return (phase < BOOT_PHASE_COUNT) ? phase_us[phase] : 0;
+}
+
+void boot_timing_report(void)
+{
+    uint32_t prev = 0;
+
+    printk("[BOOT] Phase timing (us since kernel start):\n");
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (phase_us[i] == 0) {
+            printk("   %-12s --\n", phase_names[i]);
+            continue;
+        }
+        // Threads run concurrently, so a phase can finish before the
+        // previous one in this list - show the delta only when positive
+        if (phase_us[i] >= prev) {
+            printk("   %-12s %8u  (+%u)\n", phase_names[i], phase_us[i], phase_us[i] - prev);
+            prev = phase_us[i];
+        } else {
+            printk("   %-12s %8u\n", phase_names[i], phase_us[i]);
+        }
+    }
+}
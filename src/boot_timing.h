@@ -0,0 +1,40 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <zephyr/types.h>
+
+// ========== BOOT PHASES ==========
+// Marked in the order they normally complete. Times are microseconds since
+// the kernel started (ROM/bootloader time before that is not visible).
+enum boot_phase {
+    BOOT_PHASE_MAIN,          // main() entered
+    BOOT_PHASE_GPIO,          // Matrix GPIOs configured
+    BOOT_PHASE_SETTINGS,      // Saved settings restored, snapshot published
+    BOOT_PHASE_WATCHDOG,      // Watchdog armed
+    BOOT_PHASE_THREADS,       // Scan + LED threads created
+    BOOT_PHASE_FIRST_SCAN,    // First full matrix pass finished (playable)
+    BOOT_PHASE_BT_ENABLED,    // bt_enable() returned
+    BOOT_PHASE_ADVERTISING,   // Advertising started
+    BOOT_PHASE_COUNT
+};
+
+/**
+ * @brief Record the completion time of a boot phase (first call wins)
+ *
+ * Cheap enough to call from the scan thread.
+ */
+void boot_timing_mark(enum boot_phase phase);
+
+/**
+ * @brief Get the recorded time of a phase
+ *
+ * @return Microseconds since kernel start, or 0 if not reached yet
+ */
+uint32_t boot_timing_get(enum boot_phase phase);
+
+/**
+ * @brief Print the boot-phase timing report to the console
+ */
+void boot_timing_report(void);
+
+#endif // BOOT_TIMING_H
@@ -0,0 +1,221 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "config_snapshot.h"
+#include "ble_config_service.h"
+
+LOG_MODULE_REGISTER(config_snap, LOG_LEVEL_INF);
+
+// ========== PUBLISH POLICY ==========
+// Three buffers are rotated, and publishes are spaced at least
+// PUBLISH_DELAY_MS apart. Each buffer counts the readers holding it
+// (config_snapshot_get() / config_snapshot_put()); a rebuild only takes a
+// buffer that is neither published nor held, so a reader that is slow to
+// let go (the LED thread under load, say) delays the rebuild instead of
+// seeing its snapshot change underneath it.
+#define NUM_SNAPSHOTS     3
+#define PUBLISH_DELAY_MS  20
+
+static struct config_snapshot snapshots[NUM_SNAPSHOTS];
+static atomic_t readers[NUM_SNAPSHOTS];
+static atomic_ptr_t current_snapshot = ATOMIC_PTR_INIT(NULL);
+static uint8_t next_slot = 0;
+static uint32_t generation = 0;
+
+static void rebuild_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(rebuild_work, rebuild_work_handler);
+
+// ========== TABLE BUILDERS ==========
+
+// Velocity from M1->M2 time difference (inverse relationship)
+static uint8_t velocity_for_time(uint32_t time_diff_ms, uint8_t sensitivity)
+{
+    if (time_diff_ms == 0) return MAX_VELOCITY;
+
+    // Linear interpolation
+    // Fast (small time) -> High Velocity
+    // Slow (large time) -> Low Velocity
+    uint8_t raw_vel = MAX_VELOCITY - ((time_diff_ms * (MAX_VELOCITY - MIN_VELOCITY)) / MAX_VELOCITY_TIME_MS);
+
+    // Apply Sensitivity Scaling
+    // sensitivity: 50 = 1.0x (Normal)
+    // 100 = 2.0x (Super Sensitive)
+    // 0 = 0.0x (Off)
+    float scale = (float)sensitivity / 50.0f;
+    int scaled_vel = (int)((float)raw_vel * scale);
+
+    if (scaled_vel > 127) scaled_vel = 127;
+    if (scaled_vel < 0) scaled_vel = 0;
+
+    return (uint8_t)scaled_vel;
+}
+
+// Release velocity from the M2->M1 release time. Releases are gentler than
+// strikes and not scaled by sensitivity: fast lift -> 127, slow -> 1
+static uint8_t release_velocity_for_time(uint32_t time_diff_ms)
+{
+    return MAX_VELOCITY - ((time_diff_ms * (MAX_VELOCITY - MIN_RELEASE_VELOCITY)) / MAX_VELOCITY_TIME_MS);
+}
+
+// Map Velocity (0-127) to Thermal Color Gradient for the selected theme
+static struct led_rgb color_for_velocity(uint8_t velocity, uint8_t theme)
+{
+    struct led_rgb color = {0};
+
+    // Clamp velocity
+    if (velocity < MIN_VELOCITY) velocity = MIN_VELOCITY;
+    if (velocity > MAX_VELOCITY) velocity = MAX_VELOCITY;
+
+    // Normalize to 0.0 - 1.0 range based on min/max
+    float t = (float)(velocity - MIN_VELOCITY) / (float)(MAX_VELOCITY - MIN_VELOCITY);
+
+    // THEME 0: AURORA (Blue -> Purple -> Pink)
+    if (theme == 0) {
+        color.r = (uint8_t)(t * 255.0f);
+        color.b = (uint8_t)((1.0f - t) * 255.0f);
+        if (t > 0.8f) color.g = (uint8_t)((t - 0.8f) * 150.0f); // Hot Pop
+    }
+    // THEME 1: FIRE (Red -> Orange -> White)
+    else if (theme == 1) {
+        color.r = 255;
+        color.g = (uint8_t)(t * 200.0f); // Add Green to make Orange/Yellow
+        color.b = (uint8_t)(t > 0.8f ? (t - 0.8f) * 255.0f : 0); // White hot tip
+    }
+    // THEME 2: MATRIX (Dim Green -> Bright Green -> White)
+    else {
+        color.r = (uint8_t)(t > 0.9f ? (t - 0.9f) * 2550.0f : 0); // Flash white at max (clamped)
+        color.g = (uint8_t)(50 + t * 205.0f);
+        color.b = 0;
+    }
+
+    return color;
+}
+
+// Guide (host-lit) keys use a fixed colour that none of the theme palettes
+// reach, so the player can tell "press this" from "you pressed this"
+static struct led_rgb guide_color_for_theme(uint8_t theme)
+{
+    switch (theme) {
+    case 0:  return (struct led_rgb){ .r = 0,  .g = 60, .b = 20 };  // Aurora: green
+    case 1:  return (struct led_rgb){ .r = 0,  .g = 30, .b = 60 };  // Fire: blue
+    default: return (struct led_rgb){ .r = 40, .g = 0,  .b = 60 };  // Matrix: violet
+    }
+}
+
+static void build_snapshot(struct config_snapshot *snap)
+{
+    // Sample each global exactly once so the tables agree with each other
+    snap->sensitivity = g_sensitivity;
+    snap->led_theme = g_led_theme;
+    snap->transpose = g_transpose;
+    snap->guide_channel = g_guide_channel;
+    struct arp_settings arp = g_arp;
+    snap->arp_mode = arp.mode;
+    snap->arp_division = arp.division;
+    snap->arp_gate = arp.gate;
+    snap->arp_tempo = arp.tempo;
+    snap->arp_clock = arp.clock;
+
+    for (int t = 0; t <= MAX_VELOCITY_TIME_MS; t++) {
+        snap->velocity_curve[t] = velocity_for_time(t, snap->sensitivity);
+        snap->release_curve[t] = release_velocity_for_time(t);
+    }
+
+    for (int v = 0; v <= MAX_VELOCITY; v++) {
+        snap->palette[v] = color_for_velocity(v, snap->led_theme);
+    }
+
+    // Keys transposed past either end of the MIDI range stay on the end
+    // note rather than wrapping around to the other end
+    memset(snap->key_for_note, NO_KEY, sizeof(snap->key_for_note));
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snap->note_map[i] = (uint8_t)CLAMP(BASE_MIDI_NOTE + i + snap->transpose, 0, 127);
+        if (snap->key_for_note[snap->note_map[i]] == NO_KEY) {
+            snap->key_for_note[snap->note_map[i]] = i;
+        }
+    }
+    snap->guide_color = guide_color_for_theme(snap->led_theme);
+
+    snap->generation = ++generation;
+}
+
+// The next buffer in rotation that is neither published nor held by a
+// reader, or NULL if all of them are busy
+static struct config_snapshot *free_slot(void)
+{
+    const void *current = atomic_ptr_get(&current_snapshot);
+
+    for (int i = 0; i < NUM_SNAPSHOTS; i++) {
+        int slot = (next_slot + i) % NUM_SNAPSHOTS;
+
+        if (&snapshots[slot] != current && atomic_get(&readers[slot]) == 0) {
+            next_slot = (slot + 1) % NUM_SNAPSHOTS;
+            return &snapshots[slot];
+        }
+    }
+    return NULL;
+}
+
+static bool publish_next(void)
+{
+    struct config_snapshot *snap = free_slot();
+
+    if (!snap) {
+        return false;
+    }
+    build_snapshot(snap);
+    atomic_ptr_set(&current_snapshot, snap);
+    return true;
+}
+
+// Runs on the system workqueue - never on the scan or LED hot path
+static void rebuild_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    if (!publish_next()) {
+        // Every spare buffer is still held: try again after the delay
+        LOG_WRN("Config snapshots busy, rebuild postponed");
+        k_work_schedule(&rebuild_work, K_MSEC(PUBLISH_DELAY_MS));
+        return;
+    }
+    LOG_INF("Config snapshot %u published", generation);
+}
+
+// ========== API ==========
+
+int config_snapshot_init(void)
+{
+    publish_next();
+    return 0;
+}
+
+const struct config_snapshot *config_snapshot_get(void)
+{
+    while (1) {
+        struct config_snapshot *snap = atomic_ptr_get(&current_snapshot);
+        atomic_t *count = &readers[snap - snapshots];
+
+        // Counted first, then checked: if a publish moved on in between,
+        // the rebuild may already have taken this buffer, so let go and
+        // take the new one
+        atomic_inc(count);
+        if (atomic_ptr_get(&current_snapshot) == snap) {
+            return snap;
+        }
+        atomic_dec(count);
+    }
+}
+
+void config_snapshot_put(const struct config_snapshot *snap)
+{
+    atomic_dec(&readers[snap - snapshots]);
+}
+
+void config_snapshot_request_update(void)
+{
+    // Already-pending rebuilds are left alone, so a burst of writes
+    // collapses into one rebuild that sees the final values.
+    k_work_schedule(&rebuild_work, K_MSEC(PUBLISH_DELAY_MS));
+}
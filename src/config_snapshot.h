@@ -0,0 +1,76 @@
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <zephyr/types.h>
+#include <zephyr/drivers/led_strip.h>
+#include "keyboard.h"
+
+// ========== CONFIG SNAPSHOT ==========
+// Immutable view of the user settings plus the tables derived from them.
+// The BT RX callbacks only touch the g_* globals and request a rebuild;
+// the tables are recomputed on the system workqueue and published with a
+// single pointer swap, so the scan and LED threads never see a half-applied
+// change and never take a lock. Readers hold a snapshot between
+// config_snapshot_get() and config_snapshot_put(); a held buffer is never
+// rebuilt.
+struct config_snapshot {
+    uint32_t generation;      // Bumped on every publish
+
+    // Raw settings (copied from the g_* globals at build time)
+    uint8_t sensitivity;
+    uint8_t led_theme;
+    int8_t  transpose;
+    uint8_t guide_channel;    // 0 = guide lighting off, else MIDI channel + 1
+    uint8_t arp_mode;         // enum arp_mode (0 = keys sound directly)
+    uint8_t arp_division;     // Steps per beat
+    uint8_t arp_gate;         // % of a step
+    uint8_t arp_tempo;        // Internal clock BPM
+    uint8_t arp_clock;        // enum arp_clock
+
+    // Derived tables
+    uint8_t velocity_curve[MAX_VELOCITY_TIME_MS + 1]; // M1->M2 time (ms) -> velocity
+    uint8_t release_curve[MAX_VELOCITY_TIME_MS + 1];  // M2->M1 release time (ms) -> velocity
+    struct led_rgb palette[MAX_VELOCITY + 1];         // Velocity -> theme colour
+    uint8_t note_map[NUM_KEYS];                       // Key index -> MIDI note
+    uint8_t key_for_note[128];                        // MIDI note -> key index (NO_KEY if none)
+    struct led_rgb guide_color;                       // Host guide layer colour
+};
+
+#define NO_KEY 0xFF
+
+// ========== API ==========
+/**
+ * @brief Build and publish the first snapshot from the current globals
+ *
+ * Must run before the scan and LED threads start.
+ *
+ * @return 0 on success
+ */
+int config_snapshot_init(void);
+
+/**
+ * @brief Get the current snapshot (lock-free)
+ *
+ * Readers take one snapshot per scan pass / LED frame and must not hold on
+ * to it across a sleep. Every get must be matched by config_snapshot_put().
+ *
+ * @return Pointer to the published snapshot (never NULL after init)
+ */
+const struct config_snapshot *config_snapshot_get(void);
+
+/**
+ * @brief Release a snapshot taken with config_snapshot_get()
+ *
+ * @param snap Snapshot to release
+ */
+void config_snapshot_put(const struct config_snapshot *snap);
+
+/**
+ * @brief Request a rebuild after a setting changed
+ *
+ * Safe to call from BT RX context. Bursts of writes are coalesced into a
+ * single rebuild.
+ */
+void config_snapshot_request_update(void);
+
+#endif // CONFIG_SNAPSHOT_H
@@ -0,0 +1,189 @@
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/logging/log.h>
+#include "config_store.h"
+#include "ble_config_service.h"
+#include <string.h>
+
+LOG_MODULE_REGISTER(config_store, LOG_LEVEL_INF);
+
+#define SETTINGS_ROOT "superr"
+
+// Values as last written to (or loaded from) flash
+static uint8_t saved_sensitivity;
+static uint8_t saved_led_theme;
+static int8_t  saved_transpose;
+static uint8_t saved_guide_channel;
+static struct arp_settings saved_arp;
+
+static uint32_t write_count = 0;
+
+static void save_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(save_work, save_work_handler);
+
+// ========== SETTINGS HANDLER ==========
+static int read_u8(size_t len, settings_read_cb read_cb, void *cb_arg, uint8_t *out)
+{
+    if (len != sizeof(*out)) {
+        return -EINVAL;
+    }
+    int rc = read_cb(cb_arg, out, sizeof(*out));
+    return (rc < 0) ? rc : 0;
+}
+
+static int superr_settings_set(const char *name, size_t len,
+                               settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    uint8_t val;
+    int rc;
+
+    if (settings_name_steq(name, "sens", &next) && !next) {
+        rc = read_u8(len, read_cb, cb_arg, &val);
+        if (rc == 0) {
+            g_sensitivity = (val > 100) ? 100 : val;
+        }
+        return rc;
+    }
+
+    if (settings_name_steq(name, "theme", &next) && !next) {
+        rc = read_u8(len, read_cb, cb_arg, &val);
+        if (rc == 0) {
+            g_led_theme = val;
+        }
+        return rc;
+    }
+
+    if (settings_name_steq(name, "transp", &next) && !next) {
+        rc = read_u8(len, read_cb, cb_arg, &val);
+        if (rc == 0) {
+            int8_t t = (int8_t)val;
+            if (t < -12) t = -12;
+            if (t > 12) t = 12;
+            g_transpose = t;
+        }
+        return rc;
+    }
+
+    if (settings_name_steq(name, "guide", &next) && !next) {
+        rc = read_u8(len, read_cb, cb_arg, &val);
+        if (rc == 0) {
+            g_guide_channel = (val > 16) ? 0 : val;
+        }
+        return rc;
+    }
+
+    if (settings_name_steq(name, "arp", &next) && !next) {
+        struct arp_settings a;
+        if (len != sizeof(a)) {
+            return -EINVAL;
+        }
+        rc = read_cb(cb_arg, &a, sizeof(a));
+        if (rc < 0) {
+            return rc;
+        }
+        if (arp_settings_valid(&a)) {
+            g_arp = a;
+        }
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(superr, SETTINGS_ROOT, NULL, superr_settings_set, NULL, NULL);
+
+// ========== WRITE-BEHIND ==========
+static void save_value(const char *key, const void *val, size_t len)
+{
+    int err = settings_save_one(key, val, len);
+    if (err) {
+        LOG_ERR("Failed to save %s (err %d)", key, err);
+        return;
+    }
+    write_count++;
+}
+
+// Only values that differ from what is already in flash are written
+static void save_changed(void)
+{
+    uint8_t sens = g_sensitivity;
+    uint8_t theme = g_led_theme;
+    int8_t transpose = g_transpose;
+    uint8_t guide = g_guide_channel;
+    struct arp_settings arp = g_arp;
+
+    if (sens != saved_sensitivity) {
+        save_value(SETTINGS_ROOT "/sens", &sens, sizeof(sens));
+        saved_sensitivity = sens;
+    }
+    if (theme != saved_led_theme) {
+        save_value(SETTINGS_ROOT "/theme", &theme, sizeof(theme));
+        saved_led_theme = theme;
+    }
+    if (transpose != saved_transpose) {
+        save_value(SETTINGS_ROOT "/transp", &transpose, sizeof(transpose));
+        saved_transpose = transpose;
+    }
+    if (guide != saved_guide_channel) {
+        save_value(SETTINGS_ROOT "/guide", &guide, sizeof(guide));
+        saved_guide_channel = guide;
+    }
+    if (memcmp(&arp, &saved_arp, sizeof(arp)) != 0) {
+        save_value(SETTINGS_ROOT "/arp", &arp, sizeof(arp));
+        saved_arp = arp;
+    }
+}
+
+static void save_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    save_changed();
+    LOG_INF("Settings saved (%u flash writes since boot)", write_count);
+}
+
+// ========== API ==========
+
+int config_store_init(void)
+{
+    int err = settings_subsystem_init();
+    if (err) {
+        LOG_ERR("Settings init failed (err %d)", err);
+        return err;
+    }
+
+    err = settings_load_subtree(SETTINGS_ROOT);
+    if (err) {
+        LOG_ERR("Settings load failed (err %d)", err);
+    }
+
+    // Whatever is in the globals now matches flash (or the defaults)
+    saved_sensitivity = g_sensitivity;
+    saved_led_theme = g_led_theme;
+    saved_transpose = g_transpose;
+    saved_guide_channel = g_guide_channel;
+    saved_arp = g_arp;
+
+    return err;
+}
+
+void config_store_schedule_save(void)
+{
+    k_work_reschedule(&save_work, K_MSEC(SAVE_DELAY_MS));
+}
+
+void config_store_flush(void)
+{
+    struct k_work_sync sync;
+
+    // Run the pending save now, on the workqueue, so it cannot race a
+    // save that is already in progress
+    k_work_reschedule(&save_work, K_NO_WAIT);
+    k_work_flush_delayable(&save_work, &sync);
+}
+
+uint32_t config_store_write_count(void)
+{
+    return write_count;
+}
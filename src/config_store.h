@@ -0,0 +1,41 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <zephyr/types.h>
+
+// ========== PERSISTENT SETTINGS ==========
+// The g_* settings are mirrored to flash (Zephyr settings on NVS) with a
+// debounced write-behind: a burst of GATT writes (e.g. a slider drag)
+// results in a single flash write per changed value.
+
+// Every new write pushes the save out again, so flash is only touched once
+// the user has stopped changing things for SAVE_DELAY_MS.
+#define SAVE_DELAY_MS 2000
+
+/**
+ * @brief Mount settings storage and restore saved values into the globals
+ *
+ * Call before config_snapshot_init() and before the scan/LED threads start.
+ *
+ * @return 0 on success (missing values keep their defaults)
+ */
+int config_store_init(void);
+
+/**
+ * @brief Schedule a save of the current globals (debounced)
+ *
+ * Safe to call from BT RX context.
+ */
+void config_store_schedule_save(void);
+
+/**
+ * @brief Write any pending changes immediately (e.g. before System OFF)
+ */
+void config_store_flush(void);
+
+/**
+ * @brief Number of flash writes issued since boot (diagnostics)
+ */
+uint32_t config_store_write_count(void);
+
+#endif // CONFIG_STORE_H
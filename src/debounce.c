@@ -0,0 +1,94 @@
+#include <string.h>
+#include "debounce.h"
+
+static enum debounce_edge turn_on(struct debounce_contact *c,
+                                  const struct debounce_cfg *cfg, uint32_t now_us)
+{
+    c->active = true;
+    c->count = cfg->release_ticks;
+    c->hold = cfg->hold_ticks;
+    c->lockout = 0;
+    c->edge_us = now_us;
+    return DEBOUNCE_PRESS;
+}
+
+enum debounce_edge debounce_sample(struct debounce_contact *c,
+                                   const struct debounce_cfg *cfg,
+                                   bool closed, uint32_t now_us)
+{
+    bool was_closed = c->raw_closed;
+    c->raw_closed = closed;
+
+    if (!c->active) {
+        if (closed && !was_closed) {
+            c->close_us = now_us;
+        }
+        if (c->lockout) {
+            c->lockout--;
+            return DEBOUNCE_NONE;
+        }
+        // A closed run that began inside the re-arm window is timed from
+        // its first sample
+        return closed ? turn_on(c, cfg, c->close_us) : DEBOUNCE_NONE;
+    }
+
+    if (c->hold) {
+        c->hold--;
+    }
+    if (closed) {
+        if (c->count < cfg->release_ticks) {
+            c->count++;
+        }
+        return DEBOUNCE_NONE;
+    }
+
+    if (was_closed) {
+        c->open_us = now_us;
+    }
+    if (c->hold) {
+        return DEBOUNCE_NONE;   // Open runs do not count during the hold
+    }
+    if (c->count > 0) {
+        c->count--;
+    }
+    if (c->count == 0) {
+        c->active = false;
+        c->lockout = cfg->rearm_ticks;
+        c->edge_us = c->open_us;
+        return DEBOUNCE_RELEASE;
+    }
+    return DEBOUNCE_NONE;
+}
+
+enum debounce_edge debounce_press(struct debounce_contact *c,
+                                  const struct debounce_cfg *cfg,
+                                  uint32_t now_us)
+{
+    if (!c->active && !c->raw_closed) {
+        c->close_us = now_us;
+    }
+    c->raw_closed = true;
+    if (c->active || c->lockout) {
+        return DEBOUNCE_NONE;
+    }
+    return turn_on(c, cfg, now_us);
+}
+
+void debounce_end_hold(struct debounce_contact *c)
+{
+    c->hold = 0;
+}
+
+enum debounce_edge debounce_confirm_press(struct debounce_contact *c,
+                                          const struct debounce_cfg *cfg)
+{
+    if (c->active || !c->raw_closed) {
+        return DEBOUNCE_NONE;
+    }
+    return turn_on(c, cfg, c->close_us);
+}
+
+void debounce_reset(struct debounce_contact *c)
+{
+    memset(c, 0, sizeof(*c));
+}
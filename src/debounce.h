@@ -0,0 +1,102 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <zephyr/types.h>
+
+// ========== PER-CONTACT DEBOUNCE ==========
+// Eager-on integrating debounce, one instance per key contact, sampled once
+// per scan tick:
+// - A closed sample on an idle contact turns it on at once, and the edge
+//   is timed at that first sample (velocity must not be delayed or skewed).
+// - While on, closed samples count up and open samples count down
+//   (0..release_ticks). The contact only turns off when the count reaches
+//   zero, so release bounce is integrated away rather than restarting a
+//   fixed hold timer. The release edge is timed at the first open sample
+//   of the run that reached zero.
+// - After turning off, presses are ignored for rearm_ticks so release
+//   chatter cannot retrigger the contact.
+// - For hold_ticks after a press the contact cannot turn off at all, so a
+//   slow press whose first contact chatters open for longer than the
+//   release window keeps its start time until the second contact lands.
+//   The caller ends the hold early with debounce_end_hold() once the key
+//   is down.
+// - A closed run that starts inside the re-arm window is timed from its
+//   first sample once it is taken: when the window ends, or earlier with
+//   debounce_confirm_press() when the other contact proves the key really
+//   went down (a fast repeat).
+// All windows are in scan ticks (see CONFIG_SUPERR_SCAN_PERIOD_US).
+
+struct debounce_cfg {
+    uint8_t release_ticks;   // Net open samples needed to turn off (>= 1)
+    uint8_t rearm_ticks;     // Ticks after release before a press counts
+    uint16_t hold_ticks;     // Ticks after a press it cannot turn off
+};
+
+struct debounce_contact {
+    bool active;             // Debounced state
+    bool raw_closed;         // Last raw sample
+    uint8_t count;           // Integrator while active
+    uint8_t lockout;         // Remaining re-arm ticks while inactive
+    uint16_t hold;           // Remaining hold ticks while active
+    uint32_t edge_us;        // Time of the last press or release edge
+    uint32_t open_us;        // First open sample of the current open run
+    uint32_t close_us;       // First closed sample of the current closed run
+};
+
+enum debounce_edge {
+    DEBOUNCE_NONE,
+    DEBOUNCE_PRESS,
+    DEBOUNCE_RELEASE,
+};
+
+/**
+ * @brief Feed one scan-tick sample of a contact
+ *
+ * @param c       Contact state
+ * @param cfg     Windows for this contact
+ * @param closed  Raw sample (true = contact closed)
+ * @param now_us  Time the sample was read
+ *
+ * @return Edge produced by this sample, if any
+ */
+enum debounce_edge debounce_sample(struct debounce_contact *c,
+                                   const struct debounce_cfg *cfg,
+                                   bool closed, uint32_t now_us);
+
+/**
+ * @brief Feed an extra closed sample taken between scan ticks
+ *
+ * Only turns an idle, re-armed contact on; it does not advance the
+ * integrator or the re-arm window, which count scan ticks.
+ *
+ * @return DEBOUNCE_PRESS if the contact turned on, else DEBOUNCE_NONE
+ */
+enum debounce_edge debounce_press(struct debounce_contact *c,
+                                  const struct debounce_cfg *cfg,
+                                  uint32_t now_us);
+
+/**
+ * @brief End the press hold of an active contact
+ *
+ * From the next sample on it turns off after release_ticks net open
+ * samples as usual.
+ */
+void debounce_end_hold(struct debounce_contact *c);
+
+/**
+ * @brief Take a press the re-arm window ignored
+ *
+ * If the contact is off but its last sample was closed, turn it on with
+ * the edge at the first closed sample of that run.
+ *
+ * @return DEBOUNCE_PRESS if the contact turned on, else DEBOUNCE_NONE
+ */
+enum debounce_edge debounce_confirm_press(struct debounce_contact *c,
+                                          const struct debounce_cfg *cfg);
+
+/**
+ * @brief Force a contact off without producing an edge
+ */
+void debounce_reset(struct debounce_contact *c);
+
+#endif // DEBOUNCE_H
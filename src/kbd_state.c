@@ -0,0 +1,234 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include "kbd_state.h"
+#include "ble_config_service.h"
+
+// Snapshot. The scan thread is the only writer; readers (notify work,
+// GATT reads, shell) take a consistent copy under a spinlock. A retry
+// loop would not do: the readers run cooperatively at a higher priority
+// than the scan thread, so one that preempted an update would spin
+// forever. The lock is held for a few stores or one copy of the
+// snapshot, well under a microsecond of the scan pass.
+struct kbd_snapshot {
+    uint8_t held[KBD_STATE_BITMAP];
+    uint8_t velocity[NUM_KEYS];
+    uint16_t seq;
+};
+
+static struct kbd_snapshot state;
+static struct k_spinlock state_lock;
+
+// Per-link send state, indexed by bt_conn_index()
+struct kbd_link {
+    atomic_t inflight;      // A notification is queued on this link
+    uint16_t sent_seq;      // Snapshot the link last got
+    bool synced;            // sent_seq is valid
+};
+
+static struct kbd_link links[CONFIG_BT_MAX_CONN];
+
+static atomic_t notifies;
+static atomic_t coalesced;
+static atomic_t too_big;
+
+static void notify_work_handler(struct k_work *work);
+static K_WORK_DEFINE(notify_work, notify_work_handler);
+
+void kbd_state_set(uint8_t key, uint8_t vel)
+{
+    if (key >= NUM_KEYS) {
+        return;
+    }
+
+    uint8_t bit = BIT(key % 8);
+    bool down = vel != 0;
+
+    // Only the scan thread writes, so it may look without the lock
+    if (down == !!(state.held[key / 8] & bit) && (!down || state.velocity[key] == vel)) {
+        return;
+    }
+
+    k_spinlock_key_t lock = k_spin_lock(&state_lock);
+
+    if (down) {
+        state.held[key / 8] |= bit;
+    } else {
+        state.held[key / 8] &= ~bit;
+    }
+    state.velocity[key] = vel;
+    state.seq++;
+    k_spin_unlock(&state_lock, lock);
+
+    k_work_submit(&notify_work);
+}
+
+static void snapshot_get(struct kbd_snapshot *out)
+{
+    k_spinlock_key_t lock = k_spin_lock(&state_lock);
+
+    *out = state;
+    k_spin_unlock(&state_lock, lock);
+}
+
+static size_t encode(const struct kbd_snapshot *snap, uint8_t *buf)
+{
+    uint8_t *p = buf;
+
+    *p++ = KBD_STATE_VERSION;
+    sys_put_le16(snap->seq, p);
+    p += 2;
+    *p++ = NUM_KEYS;
+    memcpy(p, snap->held, sizeof(snap->held));
+    p += sizeof(snap->held);
+    for (int k = 0; k < NUM_KEYS; k++) {
+        if (snap->held[k / 8] & BIT(k % 8)) {
+            *p++ = snap->velocity[k];
+        }
+    }
+    return p - buf;
+}
+
+size_t kbd_state_encode(uint8_t *buf)
+{
+    struct kbd_snapshot snap;
+
+    snapshot_get(&snap);
+    return encode(&snap, buf);
+}
+
+uint16_t kbd_state_get(uint8_t *velocity)
+{
+    struct kbd_snapshot snap;
+
+    snapshot_get(&snap);
+    for (int k = 0; k < NUM_KEYS; k++) {
+        velocity[k] = (snap.held[k / 8] & BIT(k % 8)) ? snap.velocity[k] : 0;
+    }
+    return snap.seq;
+}
+
+// Runs when the controller has taken the notification, i.e. at the
+// connection event; the next snapshot may go out on the one after
+static void notify_complete(struct bt_conn *conn, void *user_data)
+{
+    atomic_clear(&links[bt_conn_index(conn)].inflight);
+    k_work_submit(&notify_work);
+}
+
+static void notify_link(struct bt_conn *conn, void *data)
+{
+    const struct bt_gatt_attr *attr = ble_config_key_state_attr();
+    struct kbd_link *link = &links[bt_conn_index(conn)];
+    struct kbd_snapshot snap;
+    uint8_t buf[KBD_STATE_MAX_LEN];
+
+    if (!bt_gatt_is_subscribed(conn, attr, BT_GATT_CCC_NOTIFY)) {
+        return;
+    }
+
+    snapshot_get(&snap);
+    uint16_t snap_seq = snap.seq;
+    size_t len = encode(&snap, buf);
+
+    if (link->synced && link->sent_seq == snap_seq) {
+        return;
+    }
+    if (len > bt_gatt_get_mtu(conn) - 3) {
+        // Retried after the MTU exchange; a read still gets it all
+        atomic_inc(&too_big);
+        return;
+    }
+    if (!atomic_cas(&link->inflight, 0, 1)) {
+        return;     // notify_complete() resubmits
+    }
+
+    struct bt_gatt_notify_params params = {
+        .attr = attr,
+        .data = buf,
+        .len = len,
+        .func = notify_complete,
+    };
+
+    if (bt_gatt_notify_cb(conn, &params)) {
+        atomic_clear(&link->inflight);
+        return;
+    }
+    if (link->synced) {
+        atomic_add(&coalesced, (uint16_t)(snap_seq - link->sent_seq - 1));
+    }
+    link->sent_seq = snap_seq;
+    link->synced = true;
+    atomic_inc(&notifies);
+}
+
+static void notify_work_handler(struct k_work *work)
+{
+    bt_conn_foreach(BT_CONN_TYPE_LE, notify_link, NULL);
+}
+
+void kbd_state_subscribed(bool enabled)
+{
+    if (enabled) {
+        k_work_submit(&notify_work);
+    }
+}
+
+static void link_reset(struct bt_conn *conn)
+{
+    struct kbd_link *link = &links[bt_conn_index(conn)];
+
+    atomic_clear(&link->inflight);
+    link->synced = false;
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (!err) {
+        link_reset(conn);
+    }
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    link_reset(conn);
+}
+
+BT_CONN_CB_DEFINE(kbd_state_conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+static void att_mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx)
+{
+    // A snapshot that did not fit may fit now
+    k_work_submit(&notify_work);
+}
+
+static struct bt_gatt_cb gatt_callbacks = {
+    .att_mtu_updated = att_mtu_updated,
+};
+
+void kbd_state_init(void)
+{
+    bt_gatt_cb_register(&gatt_callbacks);
+}
+
+void kbd_state_get_stats(struct kbd_state_stats *out)
+{
+    struct kbd_snapshot snap;
+
+    snapshot_get(&snap);
+    out->seq = snap.seq;
+    out->held = 0;
+    for (int i = 0; i < KBD_STATE_BITMAP; i++) {
+        out->held += POPCOUNT(snap.held[i]);
+    }
+
+    out->notifies = atomic_get(&notifies);
+    out->coalesced = atomic_get(&coalesced);
+    out->too_big = atomic_get(&too_big);
+}
@@ -0,0 +1,72 @@
+#ifndef KBD_STATE_H
+#define KBD_STATE_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include "keyboard.h"
+
+// ========== KEYBOARD STATE TELEMETRY ==========
+// A snapshot of which keys are down and the velocity each was struck
+// with, for the Keyboard State characteristic. The app reads it once after
+// connecting and then follows notifications, instead of rebuilding the
+// state from note events it may have missed.
+//
+// The scan thread only updates the snapshot and bumps its sequence number;
+// readers copy it under a short spinlock.
+// A work item sends it to subscribed centrals with at most one
+// notification in flight per link: while one is queued, further changes
+// are folded into the next snapshot, so a link gets at most one per
+// connection event and always ends on the latest state.
+//
+// Encoding (little-endian):
+//   [version u8 = 1][seq u16][key count u8]
+//   [held bitmap, (key count + 7) / 8 bytes, bit k = key k, LSB first]
+//   [velocity u8 per held key, in key order]
+
+#define KBD_STATE_VERSION   1
+#define KBD_STATE_BITMAP    ((NUM_KEYS + 7) / 8)
+#define KBD_STATE_MAX_LEN   (4 + KBD_STATE_BITMAP + NUM_KEYS)
+
+struct kbd_state_stats {
+    uint16_t seq;
+    uint8_t held;
+    uint32_t notifies;     // Notifications sent
+    uint32_t coalesced;    // Changes folded into a later notification
+    uint32_t too_big;      // Skipped: link ATT MTU smaller than the snapshot
+};
+
+/**
+ * @brief Register the link callbacks (after the GATT services exist)
+ */
+void kbd_state_init(void);
+
+/**
+ * @brief A key went down (velocity 1-127) or up (velocity 0) (scan thread)
+ */
+void kbd_state_set(uint8_t key, uint8_t velocity);
+
+/**
+ * @brief Encode the current snapshot
+ *
+ * @param buf Output, at least KBD_STATE_MAX_LEN bytes
+ * @return Encoded length
+ */
+size_t kbd_state_encode(uint8_t *buf);
+
+/**
+ * @brief Get the current state (any thread)
+ *
+ * @param velocity Output, NUM_KEYS entries: strike velocity, 0 = not held
+ * @return Sequence number of the snapshot
+ */
+uint16_t kbd_state_get(uint8_t *velocity);
+
+/**
+ * @brief Notifications were enabled or disabled on the characteristic
+ */
+void kbd_state_subscribed(bool enabled);
+
+/** @brief Get the telemetry counters */
+void kbd_state_get_stats(struct kbd_state_stats *out);
+
+#endif // KBD_STATE_H
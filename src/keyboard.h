@@ -0,0 +1,35 @@
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+
+// ========== MATRIX GEOMETRY (from devicetree) ==========
+// The matrix is described by the "superr,velocity-matrix" node aliased as
+// keyboard-matrix (see dts/bindings/superr,velocity-matrix.yaml). Sizes
+// below are compile-time constants, so scan tables and bitmaps are sized
+// for the board being built.
+#define MATRIX_NODE DT_ALIAS(keyboard_matrix)
+
+#define NUM_COLS DT_PROP_LEN(MATRIX_NODE, col_gpios)      // Shared columns
+#define NUM_ROWS DT_PROP_LEN(MATRIX_NODE, m1_row_gpios)   // Rows per matrix
+#define NUM_KEYS DT_PROP_OR(MATRIX_NODE, key_count, NUM_ROWS * NUM_COLS)
+
+// Keys populated in a row (only the last row can be partial)
+#define ROW_KEYS(row) MIN(NUM_COLS, NUM_KEYS - (row) * NUM_COLS)
+
+// ========== MIDI CONFIGURATION ==========
+#define MIDI_CHANNEL 0         // MIDI Channel 1 (0-indexed)
+#define BASE_MIDI_NOTE DT_PROP(MATRIX_NODE, base_note)  // Note of key 0
+
+// ========== VELOCITY SENSING PARAMETERS ==========
+#define MAX_VELOCITY_TIME_MS 100   // Max time for velocity calculation
+#define MIN_VELOCITY 20            // Minimum MIDI velocity (soft)
+#define MAX_VELOCITY 127           // Maximum MIDI velocity (hard)
+
+// ========== RELEASE VELOCITY PARAMETERS ==========
+// M2 release -> M1 release time, sent as the Note Off velocity
+#define MIN_RELEASE_VELOCITY 1         // Slow (lazy) release
+#define DEFAULT_RELEASE_VELOCITY 64    // MIDI default when timing is unusable
+
+#endif // KEYBOARD_H
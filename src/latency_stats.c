@@ -0,0 +1,72 @@
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "latency_stats.h"
+
+struct latency_hist {
+    uint32_t buckets[LATENCY_NUM_BUCKETS + 1]; // Last bucket = overflow
+    uint32_t count;
+    uint32_t max_us;
+};
+
+// Written by a single thread per span, read racily by the shell / GATT:
+// a reader may see one sample half-applied, which is fine for statistics
+static struct latency_hist hists[LATENCY_SPAN_COUNT];
+
+void latency_record(enum latency_span span, uint32_t capture_cyc)
+{
+    struct latency_hist *h = &hists[span];
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - capture_cyc);
+    uint32_t idx = us / LATENCY_BUCKET_US;
+
+    if (idx > LATENCY_NUM_BUCKETS) {
+        idx = LATENCY_NUM_BUCKETS;
+    }
+    h->buckets[idx]++;
+    h->count++;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+}
+
+// Upper edge of the bucket containing the given rank (1-based)
+static uint32_t percentile_us(const struct latency_hist *h, uint32_t rank)
+{
+    uint32_t seen = 0;
+
+    for (int i = 0; i <= LATENCY_NUM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            // Overflow bucket has no upper edge - report the exact max
+            if (i == LATENCY_NUM_BUCKETS) {
+                return h->max_us;
+            }
+            return MIN((uint32_t)(i + 1) * LATENCY_BUCKET_US, h->max_us);
+        }
+    }
+    return h->max_us;
+}
+
+void latency_get_summary(enum latency_span span, struct latency_summary *out)
+{
+    const struct latency_hist *h = &hists[span];
+
+    out->count = h->count;
+    out->max_us = h->max_us;
+    if (h->count == 0) {
+        out->p50_us = 0;
+        out->p99_us = 0;
+        return;
+    }
+    out->p50_us = percentile_us(h, (h->count + 1) / 2);
+    out->p99_us = percentile_us(h, h->count - h->count / 100);
+}
+
+void latency_get_histogram(enum latency_span span, uint32_t *buckets)
+{
+    memcpy(buckets, hists[span].buckets, sizeof(hists[span].buckets));
+}
+
+void latency_reset(void)
+{
+    memset(hists, 0, sizeof(hists));
+}
@@ -0,0 +1,53 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <zephyr/types.h>
+
+// ========== KEY-TO-NOTIFY LATENCY ==========
+// Every note is stamped when its contact is captured by the scan loop.
+// Two spans are measured from that stamp:
+//   LATENCY_QUEUE  - capture -> notification handed to the host stack
+//   LATENCY_NOTIFY - capture -> notification sent (bt_gatt_notify_cb done)
+// Each span keeps a fixed-bucket histogram in RAM; percentiles come from
+// the histogram (bucket resolution), the max is exact.
+enum latency_span {
+    LATENCY_QUEUE,
+    LATENCY_NOTIFY,
+    LATENCY_SPAN_COUNT
+};
+
+#define LATENCY_BUCKET_US    500  // Histogram bucket width
+#define LATENCY_NUM_BUCKETS  64   // 0 - 32 ms, plus one overflow bucket
+
+struct latency_summary {
+    uint32_t count;
+    uint32_t p50_us;  // Upper edge of the bucket holding the median
+    uint32_t p99_us;  // Upper edge of the bucket holding the 99th percentile
+    uint32_t max_us;
+};
+
+/**
+ * @brief Record one sample for a span
+ *
+ * Each span must only be recorded from one thread.
+ *
+ * @param capture_cyc Cycle stamp taken at contact capture (k_cycle_get_32)
+ */
+void latency_record(enum latency_span span, uint32_t capture_cyc);
+
+/**
+ * @brief Summarise a span (count, p50, p99, max)
+ */
+void latency_get_summary(enum latency_span span, struct latency_summary *out);
+
+/**
+ * @brief Copy a span's histogram (LATENCY_NUM_BUCKETS + 1 entries)
+ */
+void latency_get_histogram(enum latency_span span, uint32_t *buckets);
+
+/**
+ * @brief Clear all histograms
+ */
+void latency_reset(void);
+
+#endif // LATENCY_STATS_H
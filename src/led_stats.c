@@ -0,0 +1,40 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "led_stats.h"
+
+static atomic_t frames;
+static atomic_t renders;
+static atomic_t events;
+static atomic_t dropped;
+
+void led_stats_frame(bool rendered, uint32_t n_events)
+{
+    atomic_inc(&frames);
+    if (rendered) {
+        atomic_inc(&renders);
+    }
+    if (n_events) {
+        atomic_add(&events, n_events);
+    }
+}
+
+void led_stats_event_dropped(void)
+{
+    atomic_inc(&dropped);
+}
+
+void led_stats_get(struct led_stats *out)
+{
+    out->frames = atomic_get(&frames);
+    out->renders = atomic_get(&renders);
+    out->events = atomic_get(&events);
+    out->dropped = atomic_get(&dropped);
+}
+
+void led_stats_reset(void)
+{
+    atomic_clear(&frames);
+    atomic_clear(&renders);
+    atomic_clear(&events);
+    atomic_clear(&dropped);
+}
@@ -0,0 +1,30 @@
+#ifndef LED_STATS_H
+#define LED_STATS_H
+
+#include <zephyr/types.h>
+
+// ========== LED THREAD COUNTERS ==========
+// Plain atomic counters: the LED thread counts frames, the scan thread
+// counts key events the LED queue had no room for. Readers (shell) never
+// take a lock.
+
+struct led_stats {
+    uint32_t frames;        // LED loop iterations (~60 per second)
+    uint32_t renders;       // Frames actually pushed to the strip
+    uint32_t events;        // Key events drained from the LED queue
+    uint32_t dropped;       // Key events lost to a full LED queue
+};
+
+/** @brief Count one LED loop iteration (LED thread) */
+void led_stats_frame(bool rendered, uint32_t events);
+
+/** @brief Count a key event the LED queue refused (scan thread) */
+void led_stats_event_dropped(void);
+
+/** @brief Get the counters (any thread, lock-free) */
+void led_stats_get(struct led_stats *out);
+
+/** @brief Clear the counters */
+void led_stats_reset(void);
+
+#endif // LED_STATS_H
@@ -0,0 +1,275 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "led_stream.h"
+
+BUILD_ASSERT((LED_STREAM_SLOTS & (LED_STREAM_SLOTS - 1)) == 0, "Slot count must be 2^n");
+BUILD_ASSERT(LED_STREAM_PREFILL <= LED_STREAM_MAX_DEPTH &&
+             LED_STREAM_MAX_DEPTH < LED_STREAM_SLOTS, "Jitter buffer bounds");
+BUILD_ASSERT(NUM_KEYS <= 255, "Key index must fit the delta run header");
+
+// ========== FRAME RING ==========
+// SPSC: the BT RX context writes slot head and publishes it by bumping
+// head; the LED thread reads slot tail. The last published slot (head - 1)
+// is never written while it is the delta reference, because the producer
+// only ever writes slot head.
+static struct led_rgb slots[LED_STREAM_SLOTS][NUM_KEYS];
+static atomic_t head, tail;
+
+// Producer state (BT RX context)
+static bool synced;            // A keyframe has been decoded since connect
+static uint8_t last_seq;
+static atomic_t last_frame_ms;
+static struct led_stream_stats stats;
+
+// Consumer state (LED thread)
+static bool playing;
+static uint32_t underruns;
+static uint32_t skipped;
+
+// ========== DECODING ==========
+
+static int decode_keyframe(struct led_rgb *dst, const uint8_t *p, size_t len)
+{
+    if (len != NUM_KEYS * 3) {
+        return -EINVAL;
+    }
+    for (int k = 0; k < NUM_KEYS; k++, p += 3) {
+        dst[k].r = p[0];
+        dst[k].g = p[1];
+        dst[k].b = p[2];
+    }
+    return 0;
+}
+
+static int decode_rle(struct led_rgb *dst, const uint8_t *p, size_t len)
+{
+    int k = 0;
+
+    while (len >= 4) {
+        uint8_t count = p[0];
+        if (count == 0 || k + count > NUM_KEYS) {
+            return -EINVAL;
+        }
+        struct led_rgb c = { .r = p[1], .g = p[2], .b = p[3] };
+        while (count--) {
+            dst[k++] = c;
+        }
+        p += 4;
+        len -= 4;
+    }
+    return (len == 0 && k == NUM_KEYS) ? 0 : -EINVAL;
+}
+
+static int decode_delta(struct led_rgb *dst, const struct led_rgb *prev,
+                        const uint8_t *p, size_t len)
+{
+    memcpy(dst, prev, sizeof(slots[0]));
+
+    while (len >= 2) {
+        uint8_t first = p[0];
+        uint8_t count = p[1];
+        p += 2;
+        len -= 2;
+        if (count == 0 || first + count > NUM_KEYS || len < count * 3U) {
+            return -EINVAL;
+        }
+        for (int k = first; k < first + count; k++, p += 3) {
+            dst[k].r = p[0];
+            dst[k].g = p[1];
+            dst[k].b = p[2];
+        }
+        len -= count * 3U;
+    }
+    return len == 0 ? 0 : -EINVAL;
+}
+
+static void handle_frame(const uint8_t *data, size_t len)
+{
+    if (len < 2) {
+        stats.malformed++;
+        return;
+    }
+
+    uint8_t type = data[0];
+    uint8_t seq = data[1];
+    const uint8_t *p = data + 2;
+    size_t plen = len - 2;
+
+    if (type == LED_STREAM_DELTA && (!synced || seq != (uint8_t)(last_seq + 1))) {
+        // The frame it applies to is missing: wait for the next keyframe
+        stats.seq_gaps++;
+        synced = false;
+        return;
+    }
+
+    atomic_val_t h = atomic_get(&head);
+    if (h - atomic_get(&tail) >= LED_STREAM_SLOTS) {
+        // Playout stalled; later deltas would reference this lost frame
+        stats.overflows++;
+        synced = false;
+        return;
+    }
+
+    struct led_rgb *dst = slots[h & (LED_STREAM_SLOTS - 1)];
+    int err;
+
+    switch (type) {
+    case LED_STREAM_KEYFRAME:
+        err = decode_keyframe(dst, p, plen);
+        break;
+    case LED_STREAM_KEYFRAME_RLE:
+        err = decode_rle(dst, p, plen);
+        break;
+    case LED_STREAM_DELTA:
+        err = decode_delta(dst, slots[(h - 1) & (LED_STREAM_SLOTS - 1)], p, plen);
+        break;
+    default:
+        err = -EINVAL;
+        break;
+    }
+
+    if (err) {
+        stats.malformed++;
+        return;
+    }
+
+    if (type == LED_STREAM_DELTA) {
+        stats.deltas++;
+    } else {
+        stats.keyframes++;
+        synced = true;
+    }
+    last_seq = seq;
+    stats.frames++;
+    atomic_set(&last_frame_ms, (atomic_val_t)k_uptime_get_32());
+    atomic_set(&head, h + 1);   // Publish after the slot is written
+}
+
+// ========== L2CAP CHANNEL ==========
+// One stream at a time; SDUs larger than the link's MPS are reassembled
+// by the stack into buffers from sdu_pool.
+NET_BUF_POOL_FIXED_DEFINE(sdu_pool, 2, BT_L2CAP_SDU_BUF_SIZE(LED_STREAM_SDU_MAX),
+                          8, NULL);
+
+static struct bt_l2cap_le_chan stream_chan;
+static atomic_t chan_busy;
+
+static struct net_buf *stream_alloc_buf(struct bt_l2cap_chan *chan)
+{
+    return net_buf_alloc(&sdu_pool, K_NO_WAIT);
+}
+
+static int stream_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+    handle_frame(buf->data, buf->len);
+    return 0;
+}
+
+static void stream_connected(struct bt_l2cap_chan *chan)
+{
+    synced = false;
+    atomic_set(&last_frame_ms, (atomic_val_t)k_uptime_get_32());
+    stats.connected = true;
+    printk("[LED] Frame stream connected\n");
+}
+
+static void stream_disconnected(struct bt_l2cap_chan *chan)
+{
+    stats.connected = false;
+    atomic_clear(&chan_busy);
+    printk("[LED] Frame stream disconnected\n");
+}
+
+static const struct bt_l2cap_chan_ops stream_ops = {
+    .alloc_buf = stream_alloc_buf,
+    .recv = stream_recv,
+    .connected = stream_connected,
+    .disconnected = stream_disconnected,
+};
+
+static int stream_accept(struct bt_conn *conn, struct bt_l2cap_server *server,
+                         struct bt_l2cap_chan **chan)
+{
+    if (atomic_set(&chan_busy, 1)) {
+        return -ENOMEM;
+    }
+
+    memset(&stream_chan, 0, sizeof(stream_chan));
+    stream_chan.chan.ops = &stream_ops;
+    stream_chan.rx.mtu = LED_STREAM_SDU_MAX;
+    *chan = &stream_chan.chan;
+    return 0;
+}
+
+static struct bt_l2cap_server stream_server = {
+    .psm = LED_STREAM_PSM,
+    .sec_level = BT_SECURITY_L1,
+    .accept = stream_accept,
+};
+
+// ========== API ==========
+
+int led_stream_init(void)
+{
+    int err = bt_l2cap_server_register(&stream_server);
+    if (err) {
+        printk("[LED] L2CAP server registration failed (err %d)\n", err);
+        return err;
+    }
+    printk("[LED] Frame stream on PSM 0x%04x\n", LED_STREAM_PSM);
+    return 0;
+}
+
+bool led_stream_active(void)
+{
+    return stats.connected &&
+           (uint32_t)(k_uptime_get_32() - (uint32_t)atomic_get(&last_frame_ms)) < LED_STREAM_IDLE_MS;
+}
+
+bool led_stream_take(struct led_rgb out[NUM_KEYS])
+{
+    atomic_val_t t = atomic_get(&tail);
+    atomic_val_t depth = atomic_get(&head) - t;
+
+    if (!led_stream_active()) {
+        playing = false;
+        atomic_add(&tail, depth);   // Discard leftovers
+        return false;
+    }
+
+    if (!playing) {
+        if (depth < LED_STREAM_PREFILL) {
+            return false;
+        }
+        playing = true;
+    }
+
+    if (depth == 0) {
+        // Ran dry: hold the last frame and rebuffer
+        underruns++;
+        playing = false;
+        return false;
+    }
+
+    if (depth > LED_STREAM_MAX_DEPTH) {
+        skipped += depth - LED_STREAM_PREFILL;
+        t += depth - LED_STREAM_PREFILL;
+    }
+
+    memcpy(out, slots[t & (LED_STREAM_SLOTS - 1)], sizeof(slots[0]));
+    atomic_set(&tail, t + 1);   // Slot may be reused from here on
+    return true;
+}
+
+void led_stream_get_stats(struct led_stream_stats *out)
+{
+    *out = stats;
+    out->underruns = underruns;
+    out->skipped = skipped;
+    out->depth = (uint8_t)(atomic_get(&head) - atomic_get(&tail));
+}
@@ -0,0 +1,75 @@
+#ifndef LED_STREAM_H
+#define LED_STREAM_H
+
+#include <zephyr/types.h>
+#include <zephyr/drivers/led_strip.h>
+#include "keyboard.h"
+
+// ========== LED FRAME STREAM ==========
+// The app pushes whole light shows over an LE L2CAP connection-oriented
+// channel (one SDU per frame). Frames are decoded in the BT RX context
+// straight into a slot of a small frame ring; the LED thread plays one
+// slot per LED frame. The ring doubles as the jitter buffer: playout only
+// starts once LED_STREAM_PREFILL frames are queued, and if it runs deeper
+// than LED_STREAM_MAX_DEPTH the oldest frames are skipped, so added
+// latency stays bounded.
+//
+// SDU layout: [type][seq][payload], one pixel per key (sacrificial pixel
+// excluded), colours as r, g, b:
+//   LED_STREAM_KEYFRAME      NUM_KEYS x rgb
+//   LED_STREAM_KEYFRAME_RLE  runs of [count][r][g][b] covering NUM_KEYS
+//   LED_STREAM_DELTA         runs of [first key][count][count x rgb],
+//                            applied to the frame with sequence seq - 1
+// A delta that does not follow the last decoded frame is dropped, and
+// deltas stay dropped until the next keyframe.
+
+#define LED_STREAM_PSM        0x0081   // LE dynamic PSM
+#define LED_STREAM_SLOTS      8        // Frame ring (power of two)
+#define LED_STREAM_PREFILL    2        // Frames queued before playout starts
+#define LED_STREAM_MAX_DEPTH  4        // Deeper than this: skip to PREFILL
+#define LED_STREAM_IDLE_MS    500      // No frame for this long: stream ends
+
+#define LED_STREAM_KEYFRAME      0x00
+#define LED_STREAM_KEYFRAME_RLE  0x01
+#define LED_STREAM_DELTA         0x02
+
+// Worst case is a delta of single-key runs
+#define LED_STREAM_SDU_MAX    (2 + 5 * NUM_KEYS)
+
+struct led_stream_stats {
+    uint32_t frames;        // Decoded and queued
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t seq_gaps;      // Deltas dropped for a missing predecessor
+    uint32_t malformed;
+    uint32_t overflows;     // Frames dropped with the ring full
+    uint32_t underruns;     // Playout ran dry and rebuffered
+    uint32_t skipped;       // Frames skipped to bound latency
+    uint8_t depth;          // Frames queued now
+    bool connected;
+};
+
+/**
+ * @brief Register the L2CAP server (after bt_enable())
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int led_stream_init(void);
+
+/**
+ * @brief Take the frame to show this LED frame (LED thread only)
+ *
+ * @param out NUM_KEYS colours, written only when a frame is returned
+ * @return true if out holds a new frame
+ */
+bool led_stream_take(struct led_rgb out[NUM_KEYS]);
+
+/**
+ * @brief Whether a stream is playing (connected and not idle)
+ */
+bool led_stream_active(void);
+
+/** @brief Get the stream counters */
+void led_stream_get_stats(struct led_stream_stats *out);
+
+#endif // LED_STREAM_H
@@ -0,0 +1,70 @@
+// LED strip for the native_sim replay build: keeps the last frame and
+// hands every frame that differs from it to the LED capture (sim.h)
+#define DT_DRV_COMPAT superr_led_strip_sim
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <string.h>
+#include "sim.h"
+
+struct led_strip_sim_cfg {
+    size_t length;
+};
+
+struct led_strip_sim_data {
+    struct led_rgb *frame;      // Last frame shown (length pixels)
+    size_t shown;               // Pixels in it, 0 = none yet
+};
+
+static int led_strip_sim_update_rgb(const struct device *dev,
+                                    struct led_rgb *pixels, size_t num_pixels)
+{
+    const struct led_strip_sim_cfg *cfg = dev->config;
+    struct led_strip_sim_data *data = dev->data;
+
+    if (num_pixels > cfg->length) {
+        return -EINVAL;
+    }
+    if (num_pixels == data->shown &&
+        !memcmp(pixels, data->frame, num_pixels * sizeof(*pixels))) {
+        return 0;
+    }
+
+    memcpy(data->frame, pixels, num_pixels * sizeof(*pixels));
+    data->shown = num_pixels;
+    sim_led_capture(pixels, num_pixels);
+    return 0;
+}
+
+static size_t led_strip_sim_length(const struct device *dev)
+{
+    const struct led_strip_sim_cfg *cfg = dev->config;
+
+    return cfg->length;
+}
+
+static DEVICE_API(led_strip, led_strip_sim_api) = {
+    .update_rgb = led_strip_sim_update_rgb,
+    .length = led_strip_sim_length,
+};
+
+#define LED_STRIP_SIM_DEVICE(idx)                                           \
+    static struct led_rgb led_strip_sim_##idx##_frame[DT_INST_PROP(idx, chain_length)]; \
+                                                                            \
+    static struct led_strip_sim_data led_strip_sim_##idx##_data = {        \
+        .frame = led_strip_sim_##idx##_frame,                               \
+    };                                                                      \
+                                                                            \
+    static const struct led_strip_sim_cfg led_strip_sim_##idx##_cfg = {    \
+        .length = DT_INST_PROP(idx, chain_length),                          \
+    };                                                                      \
+                                                                            \
+    DEVICE_DT_INST_DEFINE(idx, NULL, NULL,                                  \
+                          &led_strip_sim_##idx##_data,                      \
+                          &led_strip_sim_##idx##_cfg,                       \
+                          POST_KERNEL,                                      \
+                          CONFIG_LED_STRIP_INIT_PRIORITY,                   \
+                          &led_strip_sim_api);
+
+DT_INST_FOREACH_STATUS_OKAY(LED_STRIP_SIM_DEVICE)
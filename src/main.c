@@ -6,14 +6,31 @@
 #include "midi_ble.h"
 #include <zephyr/drivers/led_strip.h>
 #include <math.h>
-#include <zephyr/drivers/led_strip.h>
-#include <math.h>
-#include <math.h>
-#include <math.h>
 #include <zephyr/drivers/watchdog.h>
+#if defined(CONFIG_SUPERR_SIM)
+#include "sim.h"
+#else
 #include <soc.h>
 #include <hal/nrf_regulators.h>
+#endif
 #include "ble_config_service.h"
+#include "config_snapshot.h"
+#include "config_store.h"
+#include "keyboard.h"
+#include "boot_timing.h"
+#include "trace.h"
+#include "scan_stats.h"
+#include "debounce.h"
+#include "midi_ble_rx.h"
+#include "led_stream.h"
+#include "recorder.h"
+#include "arp.h"
+#include "midi_clock.h"
+#include "pedals.h"
+#include "kbd_state.h"
+#include "led_stats.h"
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/timing/timing.h>
 
 // ========== RTOS CONFIGURATION ==========
 #define SCAN_STACK_SIZE 1024
@@ -42,69 +59,91 @@ struct led_event {
 // Queue can hold 50 events (buffer for rapid playing)
 K_MSGQ_DEFINE(led_msgq, sizeof(struct led_event), 50, 4);
 
-// ========== 24-KEY CONFIGURATION ==========
-#define NUM_COLS 4    // 4 columns (all active)
-#define NUM_ROWS 6    // 6 rows per matrix
-#define NUM_KEYS (NUM_COLS * NUM_ROWS)  // 24 keys total
-
-// ========== GPIO PIN ASSIGNMENTS (17 pins) ==========
+// ========== GPIO PIN ASSIGNMENTS (devicetree) ==========
 // STANDARD KEYBOARD MATRIX LOGIC:
 // HARDWARE: Diodes with cathode at switch, anode at row
 // Current flow when key pressed: Column (pull-up HIGH) → Switch → Diode → Row (scanning LOW)
 // LOGIC: Rows OUTPUT (default HIGH, scan LOW), Columns INPUT (pull-up, read LOW when pressed)
-
-// COLUMNS (INPUT with PULL-UP) - Moved to P0 (Safe Analog Inputs)
-#define COL1_PIN  4   // P0.04 (AIN0)
-#define COL2_PIN  5   // P0.05 (AIN1)
-#define COL3_PIN  6   // P0.06 (AIN2)
-#define COL4_PIN  7   // P0.07 (AIN3)
-
-// MATRIX 1 ROWS (OUTPUT) - Moved to P0 (Safe GPIOs & NFC pins)
-#define M1_ROW1_PIN  25  // P0.25 (Safe)
-#define M1_ROW2_PIN  26  // P0.26 (Safe)
-#define M1_ROW3_PIN  2   // P0.02 (NFC1 -> GPIO)
-#define M1_ROW4_PIN  3   // P0.03 (NFC2 -> GPIO)
-#define M1_ROW5_PIN  10  // P0.10 (Safe)
-#define M1_ROW6_PIN  11  // P0.11 (Safe)
-
-// MATRIX 2 ROWS (OUTPUT) - Use P1 pins
-#define M2_ROWa_PIN  10  // P1.10
-#define M2_ROWb_PIN  11  // P1.11
-#define M2_ROWc_PIN  12  // P1.12
-#define M2_ROWd_PIN  13  // P1.13
-#define M2_ROWe_PIN  14  // P1.14
-#define M2_ROWf_PIN  15  // P1.15
-
-
-
-// ========== MIDI CONFIGURATION ==========
-#define MIDI_CHANNEL 0         // MIDI Channel 1 (0-indexed)
-#define BASE_MIDI_NOTE 60      // C4 (Middle C) - Starting note
-
-// ========== VELOCITY SENSING PARAMETERS ==========
-#define MAX_VELOCITY_TIME_MS 100   // Max time for velocity calculation
-#define MIN_VELOCITY 20            // Minimum MIDI velocity (soft)
-#define MAX_VELOCITY 127           // Maximum MIDI velocity (hard)
+//
+// Pins come from the keyboard-matrix node (see keyboard.h); the 24-key
+// layout lives in nrf5340dk_nrf5340_cpuapp.overlay.
+
+#define COL_PORT_MATCHES(node_id, prop, idx) \
+    && DT_SAME_NODE(DT_GPIO_CTLR_BY_IDX(node_id, prop, idx), \
+                    DT_GPIO_CTLR_BY_IDX(node_id, prop, 0))
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS(MATRIX_NODE, okay),
+             "keyboard-matrix alias missing from devicetree");
+BUILD_ASSERT(DT_PROP_LEN(MATRIX_NODE, m2_row_gpios) == NUM_ROWS,
+             "Both matrices need the same number of rows");
+BUILD_ASSERT(NUM_COLS <= 32, "Column bitmaps are 32 bits wide");
+BUILD_ASSERT(NUM_KEYS <= NUM_ROWS * NUM_COLS, "key-count exceeds the matrix");
+BUILD_ASSERT(NUM_KEYS > (NUM_ROWS - 1) * NUM_COLS, "Matrix has unpopulated rows");
+BUILD_ASSERT(1 DT_FOREACH_PROP_ELEM(MATRIX_NODE, col_gpios, COL_PORT_MATCHES),
+             "All columns must be on one GPIO port (read in one access)");
 
 // ========== KEY STATE STRUCTURE ==========
 typedef struct {
-    bool matrix1_active;      // First contact made (key starts)
-    bool matrix2_active;      // Second contact made (key fully pressed)
+    struct debounce_contact m1; // First contact (key starts), edge times in us
+    struct debounce_contact m2; // Second contact (key fully pressed)
     bool note_playing;        // Note currently playing
-    uint32_t matrix1_time;    // Timestamp of first contact (milliseconds)
-    uint32_t matrix2_time;    // Timestamp of second contact (milliseconds)
     uint8_t velocity;         // Calculated MIDI velocity
-    uint32_t m1_latch_timer;  // Debounce latch
-    uint32_t m2_latch_timer;  // Debounce latch M2
+    uint8_t midi_note;        // Note sent with Note ON (Note OFF must match)
+    bool via_arp;             // Note went to the arpeggiator, not straight out
 } key_state_t;
 
 // ========== GLOBAL VARIABLES ==========
-static struct gpio_dt_spec cols[NUM_COLS];           // 4 columns
-static struct gpio_dt_spec matrix1_rows[NUM_ROWS];   // 6 rows for Matrix 1
-static struct gpio_dt_spec matrix2_rows[NUM_ROWS];   // 6 rows for Matrix 2
+static const struct gpio_dt_spec cols[NUM_COLS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, col_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
+static const struct gpio_dt_spec matrix1_rows[NUM_ROWS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, m1_row_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
+static const struct gpio_dt_spec matrix2_rows[NUM_ROWS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, m2_row_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
 
 static struct gpio_dt_spec ble_status_led = GPIO_DT_SPEC_GET(DT_ALIAS(ble_status_led), gpios);
-static key_state_t keys[NUM_KEYS];                   // 24 keys
+static key_state_t keys[NUM_KEYS];
+
+// ========== SCAN TIMING ==========
+// Scanning is driven by a periodic kernel timer. Each tick runs exactly one
+// pass, and all contact timestamps come from the tick grid rather than from
+// whenever the code happened to run, so velocity quantization is uniform.
+#define SCAN_PERIOD_US   CONFIG_SUPERR_SCAN_PERIOD_US
+// The timer runs in whole kernel ticks, so the real period can be a little
+// longer than SCAN_PERIOD_US (33 ticks = 1007 us at 32768 Hz for 1000)
+#define SCAN_PERIOD_TICKS k_us_to_ticks_ceil32(SCAN_PERIOD_US)
+#define WDT_FEED_TICKS   (1000000 / SCAN_PERIOD_US)  // ~1 second
+#define STUCK_CHECK_TICKS (500000 / SCAN_PERIOD_US)  // ~0.5 second
+
+K_TIMER_DEFINE(scan_timer, NULL, NULL);
+
+// Debounce windows per contact, in scan ticks (see debounce.h)
+static const struct debounce_cfg m1_debounce = {
+    .release_ticks = CONFIG_SUPERR_DEBOUNCE_M1_RELEASE_TICKS,
+    .rearm_ticks = CONFIG_SUPERR_DEBOUNCE_REARM_TICKS,
+    .hold_ticks = DIV_ROUND_UP(CONFIG_SUPERR_DEBOUNCE_M1_HOLD_MS * 1000, SCAN_PERIOD_US),
+};
+static const struct debounce_cfg m2_debounce = {
+    .release_ticks = CONFIG_SUPERR_DEBOUNCE_M2_RELEASE_TICKS,
+    .rearm_ticks = CONFIG_SUPERR_DEBOUNCE_REARM_TICKS,
+};
+
+static uint64_t scan_tick;       // Scan ticks since the timer started
+static uint32_t scan_time_us;    // Grid time of the current pass
+// When the current pass began, on the CPU cycle counter (timing API): the
+// kernel cycle counter is the 32768 Hz RTC, too coarse to time a row
+static timing_t pass_start_tm;
+
+// Focused sampling: once a key's M1 contact has closed, only its M2 contact
+// decides the velocity. After the full pass, while keys are in flight, the
+// rest of the period is spent re-sampling just the M2 rows holding those
+// keys, so a strike is timed to one row phase instead of one full pass. A
+// sample is only started if it ends this margin before the next tick (the
+// Note OFF sweep and the wake-up for the next full pass, which still looks
+// for new contacts).
+#define FOCUS_MARGIN_US  (SCAN_PERIOD_US / 10)
 
 // ========== POWER MANAGEMENT ==========
 static int64_t last_activity_time = 0;
@@ -113,96 +152,118 @@ static int64_t last_activity_time = 0;
 
 // ========== LED STRIP CONFIGURATION ==========
 #define STRIP_NODE DT_ALIAS(led_strip)
-#define SUB_STRIP_NUM_PIXELS 25
+#define SUB_STRIP_NUM_PIXELS DT_PROP(STRIP_NODE, chain_length)  // 1 sacrificial + keys
 
 static const struct device *const strip = DEVICE_DT_GET(STRIP_NODE);
 // VISUAL ENGINE STATE
 static struct led_rgb pixels[SUB_STRIP_NUM_PIXELS];         // Current Displayed Color
 static struct led_rgb target_pixels[SUB_STRIP_NUM_PIXELS];  // Target Color (Smoothing)
 
+// Colour layers composed into target_pixels, top layer wins:
+//   local  - keys the player is holding (velocity colour, pulsing on the
+//            beat while the host sends MIDI clock)
+//   guide  - keys the host wants pressed (Note On on the guide channel)
+//   stream - light show frames pushed by the app (led_stream.c)
+static struct led_rgb local_pixels[SUB_STRIP_NUM_PIXELS];
+static bool guide_keys[NUM_KEYS];
+static struct led_rgb stream_pixels[NUM_KEYS];
+static bool stream_shown;   // stream_pixels hold a frame of a live stream
+
+// Startup animation length (10 ms per step)
+#if defined(CONFIG_SUPERR_BOOT_DIAGNOSTICS)
+#define STARTUP_ANIM_STEPS 1500  // 15 seconds
+#define STARTUP_FADE_STEPS 200
+#else
+#define STARTUP_ANIM_STEPS 100   // 1 second
+#define STARTUP_FADE_STEPS 25
+#endif
+
+// Set in main() when this boot is a wake from System OFF (key press)
+static bool woke_from_sleep = false;
+
 // LED Colors (R, G, B) - scaled down for brightness safety
 // static const struct led_rgb color_on = { .r = 255, .g = 0, .b = 0 }; // Red
 // static const struct led_rgb color_off = { .r = 0, .g = 0, .b = 0 };  // Off
 
+// ========== BOOT LOGGING ==========
+// Verbose boot output costs real time on the UART console, so it is only
+// emitted when CONFIG_SUPERR_BOOT_DIAGNOSTICS is enabled. Errors always print.
+#if defined(CONFIG_SUPERR_BOOT_DIAGNOSTICS)
+#define boot_printk(...) printk(__VA_ARGS__)
+#else
+#define boot_printk(...) do { } while (0)
+#endif
+
 // ========== GPIO INITIALIZATION ==========
+static int init_row(const struct gpio_dt_spec *row, char matrix, int idx)
+{
+    int ret = gpio_pin_configure_dt(row, GPIO_OUTPUT);
+    if (ret < 0) {
+        printk("[ERROR] Failed to configure Matrix %c Row %d (%s.%02d)\n",
+               matrix, idx + 1, row->port->name, row->pin);
+        return ret;
+    }
+    // Set row HIGH by default (not scanning)
+    gpio_pin_set_dt(row, 1);
+    boot_printk("[OK] Matrix %c, Row %d: %s.%02d (OUTPUT -> set HIGH)\n",
+                matrix, idx + 1, row->port->name, row->pin);
+    return 0;
+}
+
 static int init_gpio(void)
 {
     int ret;
-    const struct device *gpio0 = DEVICE_DT_GET(DT_NODELABEL(gpio0));
-    const struct device *gpio1 = DEVICE_DT_GET(DT_NODELABEL(gpio1));
-    
-    if (!device_is_ready(gpio0)) {
-        printk("ERROR: GPIO0 device not ready\n");
-        return -1;
-    }
-    
-    if (!device_is_ready(gpio1)) {
-        printk("ERROR: GPIO1 device not ready\n");
-        return -1;
-    }
-    
-    printk("\n[GPIO] Initializing GPIO Pins (24 Keys, Diode-Protected Matrix):\n");
-    printk("==============================================\n");
-    printk("[INFO] Using P1 (GPIO1) port to avoid conflicts with board features\n\n");
+
+    boot_printk("\n[GPIO] Initializing GPIO Pins (%d Keys, %dx%d Diode-Protected Matrix):\n",
+                NUM_KEYS, NUM_ROWS, NUM_COLS);
+    boot_printk("==============================================\n");
     
     // ===== Initialize COLUMN pins (INPUT with PULL-UP - Standard Matrix Logic) =====
-    printk("[COLUMNS] INPUT with PULL-UP - Standard keyboard matrix:\n");
-    const uint8_t col_pins[] = {COL1_PIN, COL2_PIN, COL3_PIN, COL4_PIN};
+    // Pull-up comes from the devicetree flags
+    boot_printk("[COLUMNS] INPUT with PULL-UP - Standard keyboard matrix:\n");
     for (int i = 0; i < NUM_COLS; i++) {
-        cols[i].port = gpio0;  // MOVED TO GPIO0
-        cols[i].pin = col_pins[i];
-        cols[i].dt_flags = GPIO_ACTIVE_HIGH;
-        
-        ret = gpio_pin_configure(gpio0, col_pins[i], GPIO_INPUT | GPIO_PULL_UP);
+        if (!gpio_is_ready_dt(&cols[i])) {
+            printk("ERROR: %s device not ready\n", cols[i].port->name);
+            return -1;
+        }
+        ret = gpio_pin_configure_dt(&cols[i], GPIO_INPUT);
         if (ret < 0) {
-            printk("[ERROR] Failed to configure Column %d (P0.%02d)\n", i + 1, col_pins[i]);
+            printk("[ERROR] Failed to configure Column %d (%s.%02d)\n",
+                   i + 1, cols[i].port->name, cols[i].pin);
             return ret;
         }
-        printk("[OK] Column %d: P0.%02d (INPUT with pull-up, default HIGH)\n", i + 1, col_pins[i]);
+        boot_printk("[OK] Column %d: %s.%02d (INPUT with pull-up, default HIGH)\n",
+                    i + 1, cols[i].port->name, cols[i].pin);
     }
     
-
-    
-    // ===== Initialize MATRIX 1 row pins (OUTPUT - Drive for scanning) =====
-    printk("\n[MATRIX 1 ROWS] OUTPUT - Scanned LOW one at a time:\n");
-    const uint8_t m1_row_pins[] = {M1_ROW1_PIN, M1_ROW2_PIN, M1_ROW3_PIN, 
-                                     M1_ROW4_PIN, M1_ROW5_PIN, M1_ROW6_PIN};
+    // ===== Initialize row pins (OUTPUT - Drive for scanning) =====
+    boot_printk("\n[ROWS] OUTPUT - Scanned LOW one at a time:\n");
     for (int i = 0; i < NUM_ROWS; i++) {
-        matrix1_rows[i].port = gpio0;  // MOVED TO GPIO0
-        matrix1_rows[i].pin = m1_row_pins[i];
-        matrix1_rows[i].dt_flags = GPIO_ACTIVE_HIGH;
-        
-        ret = gpio_pin_configure(gpio0, m1_row_pins[i], GPIO_OUTPUT);
+        if (!gpio_is_ready_dt(&matrix1_rows[i]) || !gpio_is_ready_dt(&matrix2_rows[i])) {
+            printk("ERROR: Row %d GPIO device not ready\n", i + 1);
+            return -1;
+        }
+        ret = init_row(&matrix1_rows[i], '1', i);
         if (ret < 0) {
-            printk("[ERROR] Failed to configure Matrix 1 Row %d (P0.%02d)\n", i + 1, m1_row_pins[i]);
             return ret;
         }
-        // Set row HIGH by default (not scanning)
-        gpio_pin_set_dt(&matrix1_rows[i], 1);
-        printk("[OK] Matrix 1, Row %d: P0.%02d (OUTPUT -> set HIGH)\n", i + 1, m1_row_pins[i]);
-    }
-    
-    // ===== Initialize MATRIX 2 row pins (OUTPUT - Drive for scanning) =====
-    printk("\n[MATRIX 2 ROWS] OUTPUT - Scanned LOW one at a time:\n");
-    const uint8_t m2_row_pins[] = {M2_ROWa_PIN, M2_ROWb_PIN, M2_ROWc_PIN, 
-                                     M2_ROWd_PIN, M2_ROWe_PIN, M2_ROWf_PIN};
-    for (int i = 0; i < NUM_ROWS; i++) {
-        matrix2_rows[i].port = gpio1;  // Using GPIO1 port
-        matrix2_rows[i].pin = m2_row_pins[i];
-        matrix2_rows[i].dt_flags = GPIO_ACTIVE_HIGH;
-        
-        ret = gpio_pin_configure(gpio1, m2_row_pins[i], GPIO_OUTPUT);
+        ret = init_row(&matrix2_rows[i], '2', i);
         if (ret < 0) {
-            printk("[ERROR] Failed to configure Matrix 2 Row %c (P1.%02d)\n", 'a' + i, m2_row_pins[i]);
             return ret;
         }
-        // Set row HIGH by default (not scanning)
-        gpio_pin_set_dt(&matrix2_rows[i], 1);
-        printk("[OK] Matrix 2, Row %c: P1.%02d (OUTPUT -> set HIGH)\n", 'a' + i, m2_row_pins[i]);
     }
     
-    printk("==============================================\n");
+    boot_printk("==============================================\n");
     
+    // Pull-ups settle in well under a microsecond; the first scan's per-row
+    // settling delay covers the rest
+    return 0;
+}
+
+#if defined(CONFIG_SUPERR_BOOT_DIAGNOSTICS)
+// ========== GPIO SELF TEST (diagnostics builds only) ==========
+static void gpio_self_test(void)
+{
     // Wait for pins to stabilize - longer delay for P1 port
     printk("\n[WAIT] Waiting 50ms for GPIO pins to stabilize...\n");
     k_msleep(50);
@@ -212,7 +273,7 @@ static int init_gpio(void)
     printk("   Columns (should be HIGH):\n");
     for (int i = 0; i < NUM_COLS; i++) {
         int col_state = gpio_pin_get_dt(&cols[i]);
-        printk("     Col %d P0.%02d: %s\n", i + 1, cols[i].pin, 
+        printk("     Col %d %s.%02d: %s\n", i + 1, cols[i].port->name, cols[i].pin,
                col_state ? "HIGH [OK]" : "LOW [ERROR]");
     }
     
@@ -220,15 +281,18 @@ static int init_gpio(void)
     for (int i = 0; i < NUM_ROWS; i++) {
         int m1_state = gpio_pin_get_dt(&matrix1_rows[i]);
         int m2_state = gpio_pin_get_dt(&matrix2_rows[i]);
-        printk("     Row %d: M1=P0.%02d %s, M2=P1.%02d %s\n", 
-               i + 1, 
-               matrix1_rows[i].pin, m1_state ? "HIGH [OK]" : "LOW [ERROR]",
-               matrix2_rows[i].pin, m2_state ? "HIGH [OK]" : "LOW [ERROR]");
+        printk("     Row %d: M1=%s.%02d %s, M2=%s.%02d %s\n",
+               i + 1,
+               matrix1_rows[i].port->name, matrix1_rows[i].pin,
+               m1_state ? "HIGH [OK]" : "LOW [ERROR]",
+               matrix2_rows[i].port->name, matrix2_rows[i].pin,
+               m2_state ? "HIGH [OK]" : "LOW [ERROR]");
     }
     printk("\n");
     
     // ===== GPIO TEST: Blink Row 1 to verify GPIO is working =====
-    printk("[TEST] Blinking Matrix 1 Row 1 (P0.25) 5 times...\n");
+    printk("[TEST] Blinking Matrix 1 Row 1 (%s.%02d) 5 times...\n",
+           matrix1_rows[0].port->name, matrix1_rows[0].pin);
     printk("   Use multimeter to verify pin toggles HIGH/LOW\n");
     for (int i = 0; i < 5; i++) {
         gpio_pin_set_dt(&matrix1_rows[0], 0);  // Set LOW
@@ -240,14 +304,18 @@ static int init_gpio(void)
         k_msleep(500);
     }
     printk("[OK] GPIO test complete!\n\n");
-    
-    return 0;
 }
+#endif
 
 // ========== POWER MANAGEMENT HELPER ==========
 void enter_deep_sleep(void) {
     printk("[POWER] Entering Deep Sleep (System OFF)...\n");
     
+    // 0. Make sure pending setting changes (and the recording, if it
+    //    spills to flash) survive System OFF
+    config_store_flush();
+    recorder_sync();
+
     // 1. Turn off LEDs (Black)
     memset(pixels, 0, sizeof(pixels));
     led_strip_update_rgb(strip, pixels, SUB_STRIP_NUM_PIXELS);
@@ -275,6 +343,9 @@ void enter_deep_sleep(void) {
     printk("[POWER] Goodnight. Press any key to wake.\n");
     k_sleep(K_MSEC(100)); // Compose output
     
+#if defined(CONFIG_SUPERR_SIM)
+    sim_power_off();
+#else
     // Force System OFF (Deep Sleep) - Manual Register Write
     // nRF5340 Application Core
     #if defined(NRF_REGULATORS)
@@ -288,51 +359,67 @@ void enter_deep_sleep(void) {
     
     // Safety barrier
     while(1) { __WFE(); }
+#endif
 }
 
 // Calculate velocity from time difference (inverse relationship)
-static uint8_t calculate_velocity(uint32_t time_diff_ms) {
-    if (time_diff_ms == 0) return MAX_VELOCITY;
-    if (time_diff_ms > MAX_VELOCITY_TIME_MS) return MIN_VELOCITY;
-    
-    // Linear interpolation
-    // Fast (small time) -> High Velocity
-    // Slow (large time) -> Low Velocity
-    uint8_t raw_vel = MAX_VELOCITY - ((time_diff_ms * (MAX_VELOCITY - MIN_VELOCITY)) / MAX_VELOCITY_TIME_MS);
-
-    // Apply Sensitivity Scaling (Global Setting)
-    // g_sensitivity: 50 = 1.0x (Normal)
-    // 100 = 2.0x (Super Sensitive)
-    // 0 = 0.0x (Off)
-    float scale = (float)g_sensitivity / 50.0f;
-    int scaled_vel = (int)((float)raw_vel * scale);
-    
-    if (scaled_vel > 127) scaled_vel = 127;
-    if (scaled_vel < 0) scaled_vel = 0;
-    
-    return (uint8_t)scaled_vel;
+// The curve (including sensitivity scaling) is precomputed in the snapshot.
+// Curves are tabulated per ms, so interpolate between neighbouring entries
+// to keep the sub-ms resolution of the contact timestamps
+static uint8_t curve_lookup(const uint8_t *curve, uint32_t time_diff_us, uint8_t slowest) {
+    uint32_t ms = time_diff_us / 1000;
+    if (ms >= MAX_VELOCITY_TIME_MS) {
+        return (ms == MAX_VELOCITY_TIME_MS && time_diff_us % 1000 == 0)
+               ? curve[MAX_VELOCITY_TIME_MS] : slowest;
+    }
+    int32_t v0 = curve[ms];
+    int32_t v1 = curve[ms + 1];
+    return (uint8_t)(v0 + (v1 - v0) * (int32_t)(time_diff_us % 1000) / 1000);
+}
+
+// Strike velocity from the M1->M2 press time (us)
+static uint8_t calculate_velocity(const struct config_snapshot *cfg, uint32_t time_diff_us) {
+    return curve_lookup(cfg->velocity_curve, time_diff_us, MIN_VELOCITY);
+}
+
+// Release velocity from the M2->M1 release edges. M1 opening first (or
+// together with M2) gives no usable timing, so fall back to the default.
+static uint8_t calculate_release_velocity(const struct config_snapshot *cfg,
+                                          const key_state_t *key) {
+    int32_t time_diff = (int32_t)(key->m1.edge_us - key->m2.edge_us);
+    if (time_diff <= 0) {
+        return DEFAULT_RELEASE_VELOCITY;
+    }
+    return curve_lookup(cfg->release_curve, (uint32_t)time_diff, MIN_RELEASE_VELOCITY);
+}
+
+// Every note leaves the scan thread here: logged by the recorder and
+// queued for the BLE MIDI TX thread
+static void emit_note(uint8_t status, uint8_t note, uint8_t velocity, uint32_t capture_cyc)
+{
+    recorder_log(status, note, velocity);
+    ble_midi_send_event(status, note, velocity, capture_cyc);
 }
 
 // ========== FORCE RESET ALL KEYS (Debug Helper) ==========
+// Runs on the scan thread - diagnostics go to the deferred trace ring
 static void force_reset_all_keys(void)
 {
-    printk("\n[WARN] FORCE RESET: Clearing all stuck keys!\n");
     for (int i = 0; i < NUM_KEYS; i++) {
         if (keys[i].note_playing) {
-            uint8_t midi_note = BASE_MIDI_NOTE + i;
-            uint8_t midi_packet[5];
-            int len = midi_ble_note_off(midi_note, 0, MIDI_CHANNEL,
-                                       midi_packet, sizeof(midi_packet));
-            if (len > 0) {
-                ble_midi_send(midi_packet, len);
+            uint8_t midi_note = keys[i].midi_note;
+            if (keys[i].via_arp) {
+                arp_note_off(midi_note);
+            } else {
+                emit_note(MIDI_BLE_NOTE_OFF | MIDI_CHANNEL, midi_note, 0, 0);
             }
-            printk("   Reset Key %d (Note %d)\n", i, midi_note);
+            TRACE(TRACE_FORCE_RESET, i, midi_note);
         }
-        keys[i].matrix1_active = false;
-        keys[i].matrix2_active = false;
+        debounce_reset(&keys[i].m1);
+        debounce_reset(&keys[i].m2);
         keys[i].note_playing = false;
+        kbd_state_set(i, 0);
     }
-    printk("[OK] All keys reset!\n\n");
 }
 
 // ========== MATRIX SCANNING WITH VELOCITY SENSING ==========
@@ -345,36 +432,10 @@ static void force_reset_all_keys(void)
 
 
 // Helper: Map Velocity (0-127) to Thermal Color Gradient (Blue -> Purple -> Red)
-static struct led_rgb get_velocity_color(uint8_t velocity) {
-    struct led_rgb color = {0};
-    
-    // Clamp velocity
-    if (velocity < MIN_VELOCITY) velocity = MIN_VELOCITY;
+// The palette for the active theme is precomputed in the snapshot.
+static struct led_rgb get_velocity_color(const struct config_snapshot *cfg, uint8_t velocity) {
     if (velocity > MAX_VELOCITY) velocity = MAX_VELOCITY;
-    
-    // Normalize to 0.0 - 1.0 range based on min/max
-    float t = (float)(velocity - MIN_VELOCITY) / (float)(MAX_VELOCITY - MIN_VELOCITY);
-    
-    // THEME 0: AURORA (Blue -> Purple -> Pink)
-    if (g_led_theme == 0) {
-        color.r = (uint8_t)(t * 255.0f);
-        color.b = (uint8_t)((1.0f - t) * 255.0f);
-        if (t > 0.8f) color.g = (uint8_t)((t - 0.8f) * 150.0f); // Hot Pop
-    }
-    // THEME 1: FIRE (Red -> Orange -> White)
-    else if (g_led_theme == 1) {
-        color.r = 255;
-        color.g = (uint8_t)(t * 200.0f); // Add Green to make Orange/Yellow
-        color.b = (uint8_t)(t > 0.8f ? (t - 0.8f) * 255.0f : 0); // White hot tip
-    }
-    // THEME 2: MATRIX (Dim Green -> Bright Green -> White)
-    else {
-        color.r = (uint8_t)(t > 0.9f ? (t - 0.9f) * 2550.0f : 0); // Flash white at max (clamped)
-        color.g = (uint8_t)(50 + t * 205.0f);
-        color.b = 0;
-    }
-    
-    return color;
+    return cfg->palette[velocity];
 }
 
 // Helper: Linear Interpolation for Smooth Fades
@@ -388,15 +449,116 @@ static uint8_t lerp_uint8(uint8_t current, uint8_t target, float factor) {
     return (uint8_t)(current + diff * factor);
 }
 
+static bool rgb_is_off(const struct led_rgb *c)
+{
+    return !(c->r | c->g | c->b);
+}
+
+static struct led_rgb rgb_scale(struct led_rgb c, uint8_t gain)
+{
+    c.r = c.r * gain / 255;
+    c.g = c.g * gain / 255;
+    c.b = c.b * gain / 255;
+    return c;
+}
+
+// Drain the BLE MIDI receive ring into the guide layer. Returns true if a
+// guide key changed; those keys are flagged in changed[] so they can skip
+// the fade and show up this frame.
+static bool apply_host_notes(const struct config_snapshot *cfg, bool changed[NUM_KEYS])
+{
+    struct midi_rx_event ev;
+    bool any = false;
+
+    while (midi_ble_rx_get(&ev)) {
+        uint8_t type = ev.status & 0xF0;
+
+        // Ring is drained even with guide lighting off so that turning it
+        // on never replays stale notes
+        if (!cfg->guide_channel || ev.status >= 0xF0 ||
+            (ev.status & 0x0F) != cfg->guide_channel - 1) {
+            continue;
+        }
+
+        if (type == MIDI_BLE_CONTROL_CHANGE && (ev.data1 == 120 || ev.data1 == 123)) {
+            // All Sound Off / All Notes Off clear the whole layer
+            for (int k = 0; k < NUM_KEYS; k++) {
+                if (guide_keys[k]) {
+                    guide_keys[k] = false;
+                    changed[k] = any = true;
+                }
+            }
+            continue;
+        }
+        if (type != MIDI_BLE_NOTE_ON && type != MIDI_BLE_NOTE_OFF) {
+            continue;
+        }
+
+        uint8_t key = cfg->key_for_note[ev.data1 & 0x7F];
+        if (key == NO_KEY) {
+            continue;
+        }
+
+        bool on = (type == MIDI_BLE_NOTE_ON && ev.data2 > 0);
+        if (guide_keys[key] != on) {
+            guide_keys[key] = on;
+            changed[key] = any = true;
+        }
+    }
+
+    // Real-time ring (clock goes to midi_clock.c): System Reset from the
+    // host clears the lesson like All Notes Off
+    struct midi_rx_realtime rt;
+    while (midi_ble_rx_get_realtime(&rt)) {
+        if (rt.status != 0xFF) {
+            continue;
+        }
+        for (int k = 0; k < NUM_KEYS; k++) {
+            if (guide_keys[k]) {
+                guide_keys[k] = false;
+                changed[k] = any = true;
+            }
+        }
+    }
+
+    // SysEx: nothing acts on it yet, but the slot holds one message, so
+    // take it each frame or every later one would be dropped
+    static uint8_t sysex[MIDI_RX_SYSEX_MAX];
+    int sysex_len = midi_ble_rx_get_sysex(sysex, sizeof(sysex));
+    if (sysex_len > 0) {
+        printk("[MIDI] SysEx from host: %d bytes, ID %02x\n", sysex_len, sysex[0]);
+    }
+
+    if (!cfg->guide_channel) {
+        // Guide lighting switched off: drop whatever the host left lit
+        for (int k = 0; k < NUM_KEYS; k++) {
+            if (guide_keys[k]) {
+                guide_keys[k] = false;
+                changed[k] = any = true;
+            }
+        }
+    }
+
+    return any;
+}
+
 // RTOS: LED Thread (Handles Animation & Events)
 void led_thread_entry(void *p1, void *p2, void *p3) {
     printk("[RTOS] LED Thread Started\n");
     
     // 1. Run Startup Animation
-    printk("[Start] Running Premium Aurora Effect...\n");
-    int steps = 1500; // 15 seconds
+    // Skipped on wake from deep sleep (the player pressed a key and wants it
+    // lit, not a light show) and cut short as soon as a key is played.
+    int steps = woke_from_sleep ? 0 : STARTUP_ANIM_STEPS;
+    if (steps) {
+        printk("[Start] Running Premium Aurora Effect...\n");
+    }
     
     for (int t = 0; t < steps; t++) {
+        if (k_msgq_num_used_get(&led_msgq) > 0) {
+            break;
+        }
+
         float time_val = (float)t * 0.05f;
         for (int i = 0; i < SUB_STRIP_NUM_PIXELS; i++) {
             float pos_val = (float)i * 0.3f;
@@ -409,8 +571,8 @@ void led_thread_entry(void *p1, void *p2, void *p3) {
             int b = (int)(wave3 * 80.0f + 20.0f); 
 
             float brightness = 1.0f;
-            if (t < 200) brightness = (float)t / 200.0f;
-            if (t > steps - 200) brightness = (float)(steps - t) / 200.0f;
+            if (t < STARTUP_FADE_STEPS) brightness = (float)t / STARTUP_FADE_STEPS;
+            if (t > steps - STARTUP_FADE_STEPS) brightness = (float)(steps - t) / STARTUP_FADE_STEPS;
 
             pixels[i].r = (uint8_t)(r * brightness);
             pixels[i].g = (uint8_t)(g * brightness);
@@ -427,33 +589,119 @@ void led_thread_entry(void *p1, void *p2, void *p3) {
     // Clear Strip
     memset(pixels, 0, sizeof(pixels));
     memset(target_pixels, 0, sizeof(target_pixels));
+    memset(local_pixels, 0, sizeof(local_pixels));
     led_strip_update_rgb(strip, pixels, SUB_STRIP_NUM_PIXELS);
     printk("[App] Ready. Entering LED Loop.\n");
 
     // 2. Main LED Loop (60 FPS Game Loop)
     struct led_event evt;
     bool led_is_off = false;
+    uint32_t composed_generation = 0;
+    bool beat_shown = false;
+    int32_t last_beat = 0;
     
     while(1) {
+        // One consistent config view for the whole frame
+        const struct config_snapshot *cfg = config_snapshot_get();
+
         // A. Input Phase (Drain Queue)
         // Check for new notes (non-blocking)
+        bool layers_changed = false;
+        uint32_t n_events = 0;
         while (k_msgq_get(&led_msgq, &evt, K_NO_WAIT) == 0) {
+            n_events++;
             led_is_off = false; // Wake up on event
             int led_idx = evt.key_index + 1; // +1 for sacrificial
             
             if (led_idx < SUB_STRIP_NUM_PIXELS) {
                 if (evt.is_on) {
-                     // Set TARGET to the new color
-                     target_pixels[led_idx] = get_velocity_color(evt.velocity);
+                     // Set local layer to the new color
+                     local_pixels[led_idx] = get_velocity_color(cfg, evt.velocity);
+                } else {
+                     // Set local layer to Black (OFF)
+                     memset(&local_pixels[led_idx], 0, sizeof(struct led_rgb));
+                }
+                layers_changed = true;
+            }
+        }
+
+        // Host notes (guide mode). Received since the last frame, so they
+        // are drawn at most one frame after they arrived.
+        bool guide_changed[NUM_KEYS] = {0};
+        if (apply_host_notes(cfg, guide_changed)) {
+            led_is_off = false;
+            last_activity_time = k_uptime_get(); // A lesson in progress is activity
+            layers_changed = true;
+        }
+
+        // Streamed light show: one frame per LED frame from the jitter
+        // buffer; the layer is dropped once the stream ends
+        bool stream_changed = led_stream_take(stream_pixels);
+        if (stream_changed) {
+            stream_shown = true;
+            led_is_off = false;
+            last_activity_time = k_uptime_get();
+            layers_changed = true;
+        } else if (stream_shown && !led_stream_active()) {
+            stream_shown = false;
+            stream_changed = true;
+            layers_changed = true;
+        }
+
+        // MIDI clock from the host: held keys pulse on its beat, full
+        // brightness on the beat fading to half by the next one. The phase
+        // comes from the tempo tracker, so the pulse does not wobble with
+        // BLE packet timing.
+        uint8_t beat_gain = 255;
+        bool on_beat = false;
+        int64_t beats_q16;
+        if (midi_clock_position(k_uptime_ticks(), &beats_q16) && beats_q16 >= 0) {
+            int32_t beat = (int32_t)(beats_q16 >> 16);
+
+            beat_gain = 255 - (uint8_t)((beats_q16 & 0xFFFF) >> 9);
+            on_beat = (beat != last_beat);
+            last_beat = beat;
+            beat_shown = true;
+            layers_changed = true;
+        } else if (beat_shown) {
+            beat_shown = false;
+            layers_changed = true;
+        }
+
+        // Compose layers into the smoothing targets (again after a theme
+        // change, which recolours the guide layer)
+        if (cfg->generation != composed_generation) {
+            composed_generation = cfg->generation;
+            layers_changed = true;
+        }
+        if (layers_changed) {
+            for (int k = 0; k < NUM_KEYS && k + 1 < SUB_STRIP_NUM_PIXELS; k++) {
+                int led_idx = k + 1;
+
+                if (!rgb_is_off(&local_pixels[led_idx])) {
+                    target_pixels[led_idx] = rgb_scale(local_pixels[led_idx], beat_gain);
+                    if (on_beat) {
+                        pixels[led_idx] = target_pixels[led_idx];
+                    }
+                } else if (guide_keys[k]) {
+                    target_pixels[led_idx] = cfg->guide_color;
+                } else if (stream_shown) {
+                    target_pixels[led_idx] = stream_pixels[k];
                 } else {
-                     // Set TARGET to Black (OFF)
-                     memset(&target_pixels[led_idx], 0, sizeof(struct led_rgb));
+                    memset(&target_pixels[led_idx], 0, sizeof(struct led_rgb));
+                }
+
+                // Guide and stream changes skip the fade so they are
+                // visible this frame (the app animates streams itself)
+                bool shows_stream = !guide_keys[k] && rgb_is_off(&local_pixels[led_idx]);
+                if (guide_changed[k] || (stream_changed && shows_stream)) {
+                    pixels[led_idx] = target_pixels[led_idx];
                 }
             }
         }
         
         // B. Update Phase (Smoothing / Physics)
-        bool needs_update = false;
+        bool needs_update = layers_changed;
         
         // Only run physics if not in "Dim Mode"
         if (!led_is_off) {
@@ -482,6 +730,7 @@ void led_thread_entry(void *p1, void *p2, void *p3) {
                 led_strip_update_rgb(strip, pixels, SUB_STRIP_NUM_PIXELS);
             }
         }
+        led_stats_frame(!led_is_off && needs_update, n_events);
         
         // D. Housekeeping
         // Feed Watchdog (Every 1s at least) - Logic simplified for loop
@@ -494,21 +743,322 @@ void led_thread_entry(void *p1, void *p2, void *p3) {
              printk("[POWER] Auto-Dim: Turning off LEDs\n");
              memset(pixels, 0, sizeof(pixels));
              memset(target_pixels, 0, sizeof(target_pixels)); // Ensure target also off
+             memset(local_pixels, 0, sizeof(local_pixels));
              led_strip_update_rgb(strip, pixels, SUB_STRIP_NUM_PIXELS);
              led_is_off = true;
         }
         
+        config_snapshot_put(cfg);
+
         // E. Frame Limiter (60 FPS = ~16ms)
         k_msleep(16);
     }
 }
 
+static uint32_t elapsed_us(timing_t *from, timing_t *to)
+{
+    return (uint32_t)(timing_cycles_to_ns(timing_cycles_get(from, to)) / 1000U);
+}
+
+// Time since the current pass began
+static inline uint32_t pass_elapsed_us(void)
+{
+    timing_t now = timing_counter_get();
+
+    return elapsed_us(&pass_start_tm, &now);
+}
+
+// Time of a row read: grid time of the pass plus the time since it began
+static inline uint32_t row_time_us(void)
+{
+    return scan_time_us + pass_elapsed_us();
+}
+
+// Settling delay after driving a row, accounted in the scan statistics
+static inline void settle_wait(uint32_t us)
+{
+    scan_stats_busy_wait(us);
+#if defined(CONFIG_SUPERR_SIM)
+    sim_settle_wait(us);    // Kept out of the replay build's scan work
+#else
+    k_busy_wait(us);
+#endif
+}
+
+// ========== COLUMN SETTLING CALIBRATION ==========
+// Every row starts at the devicetree floor after it is driven (the old
+// fixed 100us, plus the 50us gap before a Matrix 2 row). With every key up
+// the columns never change, so settling can only be measured under load:
+// when a row read finds a contact that was also closed on the previous
+// pass (held, not bouncing), the row is released and driven again and the
+// columns are polled until they stop changing. The first such measurement
+// replaces the floor with the slower of the two times plus a margin; later
+// ones only lengthen it, so a row keeps the slowest column it has shown.
+// A cheap double read on every row phase catches reads that still had not
+// settled and lengthens that row's delay.
+#define SETTLE_FLOOR_US      DT_PROP(MATRIX_NODE, settle_floor_us)
+#define SETTLE_GAP_US        DT_PROP(MATRIX_NODE, matrix_gap_us)
+#define SETTLE_MIN_US        2    // Added to the measured time
+#define SETTLE_MAX_US        250  // Never wait longer (fits the uint8_t)
+#define SETTLE_MARGIN        2    // Delay = measured * margin + SETTLE_MIN_US
+#define SETTLE_STABLE_READS  8    // Identical consecutive reads = settled
+#define SETTLE_RECHECK_READS 1000 // Loaded reads between measurements of a row
+
+BUILD_ASSERT(SETTLE_FLOOR_US + SETTLE_GAP_US <= SETTLE_MAX_US,
+             "settle-floor-us + matrix-gap-us must be at most 250");
+BUILD_ASSERT(NUM_ROWS * (2 * SETTLE_FLOOR_US + SETTLE_GAP_US) < SCAN_PERIOD_US,
+             "Row settle floors alone do not fit in the scan period");
+
+// Per row phase: the last column read and the loaded calibration state
+struct row_settle {
+    uint32_t last_cols;    // Columns closed on the previous pass
+    uint16_t recheck;      // Loaded reads until the next measurement
+    bool loaded;           // Measured with a contact held at least once
+};
+
+static uint8_t m1_settle_us[NUM_ROWS];
+static uint8_t m2_settle_us[NUM_ROWS];
+static struct row_settle m1_cal[NUM_ROWS];
+static struct row_settle m2_cal[NUM_ROWS];
+
+// All columns share one port: read them with a single port access.
+// Returns a bitmask of columns reading LOW (bit n = column n pressed).
+static inline uint32_t read_columns(void)
+{
+    gpio_port_value_t levels = 0;
+    uint32_t pressed = 0;
+
+#if defined(CONFIG_SUPERR_SIM)
+    sim_matrix_sample();    // Trace-driven contacts on the emulated GPIOs
+#endif
+    gpio_port_get_raw(cols[0].port, &levels);
+    for (int col = 0; col < NUM_COLS; col++) {
+        if (!(levels & BIT(cols[col].pin))) {
+            pressed |= BIT(col);
+        }
+    }
+    return pressed;
+}
+
+// Read the columns after the row's settle delay. If a second read
+// disagrees, the first one was taken too early: count it, lengthen this
+// row's delay for future passes and use the later value.
+static uint32_t read_columns_checked(uint8_t *settle_us)
+{
+    uint32_t first = read_columns();
+    uint32_t second = read_columns();
+
+    if (first != second) {
+        scan_stats_unsettled_read();
+        if (*settle_us < SETTLE_MAX_US) {
+            *settle_us = MIN(*settle_us + 1 + *settle_us / 4, SETTLE_MAX_US);
+            scan_stats_set_settle(m1_settle_us, m2_settle_us);
+        }
+        return read_columns();
+    }
+    return second;
+}
+
+// Time until the column reads stop changing (SETTLE_MAX_US if they never do)
+static uint32_t measure_settle_us(void)
+{
+    timing_t start = timing_counter_get();
+    timing_t last_change = start;
+    uint32_t last = read_columns();
+    int stable = 1;
+
+    while (1) {
+        uint32_t val = read_columns();
+        timing_t now = timing_counter_get();
+
+        if (val != last) {
+            last = val;
+            last_change = now;
+            stable = 1;
+        } else if (++stable >= SETTLE_STABLE_READS) {
+            return elapsed_us(&start, &last_change);
+        }
+
+        if (elapsed_us(&start, &now) >= SETTLE_MAX_US) {
+            return SETTLE_MAX_US;
+        }
+    }
+}
+
+// Called with the row still driven, right after its columns were read.
+// A contact closed on this pass and the previous one puts a real load on
+// its column; measure the row under it (see above).
+static void calibrate_loaded(const struct gpio_dt_spec *row_pin, uint8_t *settle_us,
+                             struct row_settle *cal, uint32_t cols)
+{
+    uint32_t held = cols & cal->last_cols;
+
+    cal->last_cols = cols;
+    if (!held) {
+        return;
+    }
+    if (cal->recheck) {
+        cal->recheck--;
+        return;
+    }
+    cal->recheck = SETTLE_RECHECK_READS;
+
+    // Release: the columns recover before the next row phase is driven
+    gpio_pin_set_dt(row_pin, 1);
+    uint32_t release_us = measure_settle_us();
+    gpio_pin_set_dt(row_pin, 0);
+    uint32_t drive_us = measure_settle_us();
+
+    // A read that never settles is a contact moving, not settling
+    if (release_us >= SETTLE_MAX_US || drive_us >= SETTLE_MAX_US) {
+        return;
+    }
+
+    uint32_t delay = MIN(MAX(drive_us, release_us) * SETTLE_MARGIN + SETTLE_MIN_US,
+                         SETTLE_MAX_US);
+    if (!cal->loaded || delay > *settle_us) {
+        *settle_us = (uint8_t)delay;
+        cal->loaded = true;
+        scan_stats_set_settle(m1_settle_us, m2_settle_us);
+    }
+}
+
+// Until a row has been measured under load it waits the devicetree floor
+static void init_settling(void)
+{
+    for (int row = 0; row < NUM_ROWS; row++) {
+        m1_settle_us[row] = SETTLE_FLOOR_US;
+        m2_settle_us[row] = SETTLE_FLOOR_US + SETTLE_GAP_US;
+    }
+    scan_stats_set_settle(m1_settle_us, m2_settle_us);
+}
+
+// ========== SECOND CONTACT / FOCUSED SAMPLING ==========
+// M2 contact just turned on (debounced press edge): if the key was in
+// flight, send Note ON with the velocity from the M1->M2 edge times.
+// Shared by the full pass and the focused samples.
+static void m2_contact(const struct config_snapshot *cfg, int key_idx)
+{
+    key_state_t *key = &keys[key_idx];
+    uint32_t capture_cyc = k_cycle_get_32(); // Latency stamp
+
+    TRACE(TRACE_M2_CONTACT, key_idx, BASE_MIDI_NOTE + key_idx);
+
+    // The key is down: M1 needs no press hold any more, and an M1 press
+    // its re-arm window ignored (a fast repeat) was a real one
+    debounce_confirm_press(&key->m1, &m1_debounce);
+    debounce_end_hold(&key->m1);
+
+    // Calculate velocity and send Note ON
+    if (key->m1.active && !key->note_playing) {
+        uint32_t time_diff = key->m2.edge_us - key->m1.edge_us;
+        key->velocity = calculate_velocity(cfg, time_diff);
+        // Note comes from the snapshot's map (transpose applied) and is
+        // remembered so the matching Note OFF survives a transpose change
+        uint8_t midi_note = cfg->note_map[key_idx];
+        key->midi_note = midi_note;
+
+        // Arpeggiator / note repeat: the key only joins the held notes and
+        // the scheduler plays it on the beat grid
+        key->via_arp = (cfg->arp_mode != ARP_OFF);
+        if (key->via_arp) {
+            arp_note_on(midi_note, key->velocity);
+        } else {
+            emit_note(MIDI_BLE_NOTE_ON | MIDI_CHANNEL, midi_note,
+                      key->velocity, capture_cyc);
+        }
+
+        key->note_playing = true;
+        kbd_state_set(key_idx, key->velocity);
+
+        // Send Event to LED Thread
+        struct led_event e = {
+            .key_index = key_idx,
+            .velocity = key->velocity,
+            .is_on = true
+        };
+        if (k_msgq_put(&led_msgq, &e, K_NO_WAIT)) {
+            led_stats_event_dropped();
+        }
+
+    } else if (!key->m1.active) {
+        TRACE(TRACE_M2_WITHOUT_M1, key_idx, 0);
+    }
+}
+
+// Keys between M1 and M2 contact in this row (bit per column)
+static uint32_t inflight_columns(int row)
+{
+    uint32_t mask = 0;
+
+    for (int col = 0; col < ROW_KEYS(row); col++) {
+        const key_state_t *key = &keys[row * NUM_COLS + col];
+        if (key->m1.active && !key->m2.active && !key->note_playing) {
+            mask |= BIT(col);
+        }
+    }
+    return mask;
+}
+
+// Re-sample only the M2 rows holding in-flight keys until they all land or
+// the next sample would run into the end of the period
+static void focus_inflight_keys(const struct config_snapshot *cfg)
+{
+    uint32_t inflight[NUM_ROWS];
+    bool any = false;
+
+    for (int row = 0; row < NUM_ROWS; row++) {
+        inflight[row] = inflight_columns(row);
+        any |= (inflight[row] != 0);
+    }
+    if (!any) {
+        return;
+    }
+
+    scan_stats_phase_begin(SCAN_PHASE_FOCUS);
+    bool time_left = true;
+    while (any && time_left) {
+        any = false;
+        for (int row = 0; row < NUM_ROWS; row++) {
+            if (!inflight[row]) {
+                continue;
+            }
+            if (pass_elapsed_us() + m2_settle_us[row] + FOCUS_MARGIN_US > SCAN_PERIOD_US) {
+                time_left = false;
+                break;
+            }
+
+            gpio_pin_set_dt(&matrix2_rows[row], 0);
+            settle_wait(m2_settle_us[row]);
+            uint32_t m2_cols = read_columns_checked(&m2_settle_us[row]);
+            uint32_t m2_time = row_time_us();
+            gpio_pin_set_dt(&matrix2_rows[row], 1);
+            scan_stats_focus_sample();
+
+            uint32_t landed = m2_cols & inflight[row];
+            for (int col = 0; col < NUM_COLS; col++) {
+                int key_idx = row * NUM_COLS + col;
+                if ((landed & BIT(col)) &&
+                    debounce_press(&keys[key_idx].m2, &m2_debounce, m2_time) == DEBOUNCE_PRESS) {
+                    m2_contact(cfg, key_idx);
+                    scan_stats_focus_strike();
+                }
+            }
+            inflight[row] &= ~landed;
+            any |= (inflight[row] != 0);
+        }
+    }
+    scan_stats_phase_end(SCAN_PHASE_FOCUS);
+}
+
 // #if 0
 static void scan_matrix(void)
 {
     static uint32_t debug_counter = 0;
     static uint32_t stuck_counter = 0;
-    uint32_t current_time = k_uptime_get_32();
+    uint32_t current_time = scan_time_us;
+    // One consistent config view for the whole pass
+    const struct config_snapshot *cfg = config_snapshot_get();
     
     // OPTIMIZED KEYBOARD MATRIX SCANNING WITH TWO MATRICES:
     // Both matrices share the same 4 columns but have separate row sets
@@ -517,143 +1067,93 @@ static void scan_matrix(void)
     
     for (int row = 0; row < NUM_ROWS; row++) {
         // ===== SCAN MATRIX 1 (First Contact) =====
+        scan_stats_phase_begin(SCAN_PHASE_M1);
         // Set current Matrix 1 row LOW (active scan)
         gpio_pin_set_dt(&matrix1_rows[row], 0);
-        k_busy_wait(100);  // Increased to 100us for better signal settling
+        settle_wait(m1_settle_us[row]);  // Per row, see calibration
 
-        // Debug: Show we're scanning (every 1000 scans = ~5 seconds)
-        // if (debug_counter % 1000 == 0 && row == 0) {
-        //    printk("[SCAN] Scanning active (Row set LOW, should read columns)\n");
-        // }
+        // Read all columns at once: LOW = key pressed (pulled down through
+        // switch and diode to LOW row)
+        uint32_t m1_cols = read_columns_checked(&m1_settle_us[row]);
+        uint32_t m1_time = row_time_us();
+        calibrate_loaded(&matrix1_rows[row], &m1_settle_us[row], &m1_cal[row], m1_cols);
+
+        // Set Matrix 1 row back to HIGH
+        gpio_pin_set_dt(&matrix1_rows[row], 1);
         
-        // Read all columns for Matrix 1
-        for (int col = 0; col < NUM_COLS; col++) {
+        for (int col = 0; col < ROW_KEYS(row); col++) {
             int key_idx = row * NUM_COLS + col;
             key_state_t *key = &keys[key_idx];
-            // uint8_t midi_note = BASE_MIDI_NOTE + key_idx; // Removed unused var
             
-            // Read column: LOW = key pressed (pulled down through switch and diode to LOW row)
-            int col_state = gpio_pin_get_dt(&cols[col]);
-            bool m1_pressed = (col_state == 0);  // LOW = pressed
+            bool m1_pressed = (m1_cols & BIT(col)) != 0;
             
             // Activity Detected?
             if (m1_pressed) {
                last_activity_time = k_uptime_get();
             }
 
-            // ===== Handle            // First contact made
-            if (m1_pressed && !key->matrix1_active) {
-                key->matrix1_active = true;
-                key->matrix1_time = current_time;
-                key->m1_latch_timer = current_time; // Start latch timer
-                // printk dropped for performance
-            } else if (!m1_pressed && key->matrix1_active) {
-                // First contact released - SMART DEBOUNCE
-                // CASE A: Note NOT playing yet? We are in the "Press" phase.
-                //    - User might be pressing slowly, or switch is bouncing.
-                //    - We MUST hold M1 active for a long window (250ms) to wait for M2.
-                //    - This preserves the "Start Time" so we can get TRUE VELOCITY.
-                // CASE B: Note IS playing? We are in the "Release" phase.
-                //    - User is letting go. We want snappy release.
-                //    - Use short debounce (50ms) just to filter noise.
-                
-                uint32_t hold_time = key->note_playing ? 50 : 250;
-
-                if (k_uptime_get_32() - key->m1_latch_timer > hold_time && !key->matrix2_active) {
-                     key->matrix1_active = false;
-                }
-            }
+            // ===== Handle Matrix 1 (First Contact) =====
+            // Eager-on: the press edge is timed at the first closed sample,
+            // which starts the velocity measurement. Until M2 lands the
+            // contact is held on (slow presses chatter); after that release
+            // bounce is integrated by the debounce engine.
+            debounce_sample(&key->m1, &m1_debounce, m1_pressed, m1_time);
         }
         
-        // Set Matrix 1 row back to HIGH
-        gpio_pin_set_dt(&matrix1_rows[row], 1);
-        
-        // Add settling time between Matrix 1 and Matrix 2 scans to prevent interference
-        k_busy_wait(50); // Safe guard delay between matrix scans
+        scan_stats_phase_end(SCAN_PHASE_M1);
         
         // ===== SCAN MATRIX 2 (Second Contact) =====
+        // Until measured, the delay includes matrix-gap-us for the columns
+        // to recover from the Matrix 1 row that was just released
+        scan_stats_phase_begin(SCAN_PHASE_M2);
         // Set current Matrix 2 row LOW (active scan)
         gpio_pin_set_dt(&matrix2_rows[row], 0);
-        k_busy_wait(100);  // Increased to 100us for better signal settling
+        settle_wait(m2_settle_us[row]);  // Per row, see calibration
+        
+        uint32_t m2_cols = read_columns_checked(&m2_settle_us[row]);
+        uint32_t m2_time = row_time_us();
+        calibrate_loaded(&matrix2_rows[row], &m2_settle_us[row], &m2_cal[row], m2_cols);
+
+        // Set Matrix 2 row back to HIGH
+        gpio_pin_set_dt(&matrix2_rows[row], 1);
         
-        // Read all columns for Matrix 2
-        for (int col = 0; col < NUM_COLS; col++) {
+        for (int col = 0; col < ROW_KEYS(row); col++) {
             int key_idx = row * NUM_COLS + col;
             key_state_t *key = &keys[key_idx];
-            uint8_t midi_note = BASE_MIDI_NOTE + key_idx;
             
-            // Read column: LOW = key pressed (pulled down through switch and diode to LOW row)
-            int col_state = gpio_pin_get_dt(&cols[col]);
-            bool m2_pressed = (col_state == 0);  // LOW = pressed
+            bool m2_pressed = (m2_cols & BIT(col)) != 0;
             
             // ===== Handle Matrix 2 (Second Contact) =====
-            if (m2_pressed && !key->matrix2_active) {
-                // Second contact made
-                key->matrix2_active = true;
-                key->matrix2_time = current_time;
-                key->m2_latch_timer = current_time; // Start latch
-                
-                printk("[M2] Key[R%d,C%d]: Matrix 2 SECOND contact detected (Note %d)\n",  
-                       row + 1, col + 1, midi_note);
-                
-                // Calculate velocity and send Note ON
-                if (key->matrix1_active && !key->note_playing) {
-                    uint32_t time_diff = key->matrix2_time - key->matrix1_time;
-                    key->velocity = calculate_velocity(time_diff);
-                    // Send MIDI Note ON
-                    // Re-calculate note with current transpose (in case it changed mid-press)
-                    uint8_t midi_note = BASE_MIDI_NOTE + key_idx + g_transpose;
-                    
-                    uint8_t midi_packet[5];
-                    int len = midi_ble_note_on(midi_note, key->velocity, MIDI_CHANNEL, 
-                                              midi_packet, sizeof(midi_packet));
-                    if (len > 0) {
-                        ble_midi_send(midi_packet, len);
-                    }
-
-                    key->note_playing = true;
-                    
-                    // Send Event to LED Thread
-                    struct led_event e = {
-                        .key_index = key_idx,
-                        .velocity = key->velocity,
-                        .is_on = true
-                    };
-                    k_msgq_put(&led_msgq, &e, K_NO_WAIT);
-                    
-                } else if (!key->matrix1_active) {
-                    printk("[WARN] Key[R%d,C%d]: M2 contact but M1 not active!\n", 
-                           row + 1, col + 1);
-                }
-            } else if (!m2_pressed && key->matrix2_active) {
-                // Second contact released - DEBOUNCE
-                if (k_uptime_get_32() - key->m2_latch_timer > 50) {
-                     key->matrix2_active = false;
-                }
+            if (debounce_sample(&key->m2, &m2_debounce, m2_pressed, m2_time) == DEBOUNCE_PRESS) {
+                m2_contact(cfg, key_idx);
             }
         }
         
-        // Set Matrix 2 row back to HIGH
-        gpio_pin_set_dt(&matrix2_rows[row], 1);
+        scan_stats_phase_end(SCAN_PHASE_M2);
     }
+
+    // ===== Spend the rest of the budget on keys mid-stroke =====
+    focus_inflight_keys(cfg);
     
     // ===== Handle Note OFF for ALL keys after scanning =====
+    scan_stats_phase_begin(SCAN_PHASE_NOTE_OFF);
     // Check all keys to see if both contacts are released
     for (int i = 0; i < NUM_KEYS; i++) {
         key_state_t *key = &keys[i];
-        if (!key->matrix1_active && !key->matrix2_active && key->note_playing) {
-            // Both contacts released, send Note OFF
-            uint8_t midi_note = BASE_MIDI_NOTE + i + g_transpose;
-            uint8_t midi_packet[5];
-            int len = midi_ble_note_off(midi_note, 0, MIDI_CHANNEL, 
-                                       midi_packet, sizeof(midi_packet));
-            if (len > 0) {
-                ble_midi_send(midi_packet, len);
+        if (!key->m1.active && !key->m2.active && key->note_playing) {
+            // Both contacts released, send Note OFF with release velocity
+            uint32_t capture_cyc = k_cycle_get_32(); // Latency stamp
+            uint8_t midi_note = key->midi_note;
+            uint8_t release_velocity = calculate_release_velocity(cfg, key);
+            if (key->via_arp) {
+                arp_note_off(midi_note);
+            } else {
+                emit_note(MIDI_BLE_NOTE_OFF | MIDI_CHANNEL, midi_note,
+                          release_velocity, capture_cyc);
             }
             
             key->note_playing = false;
-            int row = i / NUM_COLS;
-            int col = i % NUM_COLS;
+            kbd_state_set(i, 0);
             
             // Send Event to LED Thread
             struct led_event e = {
@@ -661,14 +1161,16 @@ static void scan_matrix(void)
                 .velocity = 0,
                 .is_on = false
             };
-            k_msgq_put(&led_msgq, &e, K_NO_WAIT);
+            if (k_msgq_put(&led_msgq, &e, K_NO_WAIT)) {
+                led_stats_event_dropped();
+            }
 
-            printk("[NOTE OFF] Key[R%d,C%d]\n", row + 1, col + 1);
+            TRACE(TRACE_NOTE_OFF, i, midi_note);
         }
     }
     
-    // Debug output every 200 scans (~1 time per second at 200Hz)
-    if (debug_counter++ % 200 == 0) {
+    // Stuck-key check every ~0.5 s of scan ticks
+    if (debug_counter++ % STUCK_CHECK_TICKS == 0) {
 
         
         int active_keys = 0;
@@ -679,40 +1181,38 @@ static void scan_matrix(void)
         }
         if (active_keys > 0) {
             stuck_counter++;
-            printk("\n[DEBUG] %d keys stuck! (Count: %u) Details:\n", active_keys, stuck_counter);
+            TRACE(TRACE_STUCK_KEYS, active_keys, stuck_counter);
             for (int i = 0; i < NUM_KEYS; i++) {
                 if (keys[i].note_playing) {
-                    int r = i / NUM_COLS;
-                    int c = i % NUM_COLS;
-                    printk("   Key[R%d,C%d] Note %d: M1=%d M2=%d Playing=%d\n",
-                           r + 1, c + 1, BASE_MIDI_NOTE + i,
-                           keys[i].matrix1_active, keys[i].matrix2_active, 
-                           keys[i].note_playing);
+                    TRACE(TRACE_STUCK_KEY, i,
+                          TRACE_KEY_FLAGS(keys[i].m1.active, keys[i].m2.active,
+                                          keys[i].note_playing));
                 }
             }
             
             // Auto-reset if stuck for more than 5 seconds (10 consecutive checks)
             if (stuck_counter > 10) {
-                printk("[WARN] Keys stuck for >5 seconds, forcing reset...\n");
+                TRACE(TRACE_STUCK_RESET, 0, 0);
                 force_reset_all_keys();
                 stuck_counter = 0;
             }
         } else {
             stuck_counter = 0;  // Reset stuck counter when all keys are OK
-            if (debug_counter % 1000 == 0) {
-                printk("[DEBUG] All keys OFF (OK), Time: %u ms\n", current_time);
-                
+            // Every 5th check (~2.5 s); debug_counter was already advanced
+            if ((debug_counter - 1) % (5 * STUCK_CHECK_TICKS) == 0) {
                 // Verify columns are HIGH (check all columns)
-                int c1 = gpio_pin_get_dt(&cols[0]);
-                int c2 = gpio_pin_get_dt(&cols[1]);
-                int c3 = gpio_pin_get_dt(&cols[2]);
-                int c4 = gpio_pin_get_dt(&cols[3]);
-                printk("   Columns check: C1=%s C2=%s C3=%s C4=%s (should all be HIGH)\n",
-                       c1 ? "HIGH" : "LOW", c2 ? "HIGH" : "LOW",
-                       c3 ? "HIGH" : "LOW", c4 ? "HIGH" : "LOW");
+                uint32_t col_levels = 0;
+                for (int c = 0; c < NUM_COLS; c++) {
+                    if (gpio_pin_get_dt(&cols[c])) {
+                        col_levels |= BIT(c);
+                    }
+                }
+                TRACE(TRACE_IDLE_CHECK, col_levels, current_time / 1000);
             }
         }
     }
+    scan_stats_phase_end(SCAN_PHASE_NOTE_OFF);
+    config_snapshot_put(cfg);
 }
 
 
@@ -723,9 +1223,35 @@ void scan_thread_entry(void *p1, void *p2, void *p3) {
     printk("[RTOS] Scan Thread Started\n");
     last_activity_time = k_uptime_get(); // Init timer
     
+    // Grid time is derived from the timer's real period (whole kernel
+    // ticks), not the requested one, so it never drifts from the timer
+    const uint32_t period_ticks = SCAN_PERIOD_TICKS;
     int loop_count = 0;
+
+    // First pass right away, then one per period
+    k_timer_start(&scan_timer, K_NO_WAIT, K_TICKS(period_ticks));
+
     while (1) {
+        // Blocks until the next tick; more than one expiry means the
+        // previous pass (or preemption) overran and ticks were skipped
+        uint32_t expiries = k_timer_status_sync(&scan_timer);
+        if (expiries > 1) {
+            scan_stats_overrun(expiries - 1);
+        }
+        scan_tick += expiries;
+        scan_time_us = (uint32_t)k_ticks_to_us_floor64(scan_tick * period_ticks);
+
+        pass_start_tm = timing_counter_get();
+#if defined(CONFIG_SUPERR_SIM)
+        sim_scan_pass_begin();
+#endif
+        scan_stats_pass_begin();
         scan_matrix();
+        scan_stats_pass_end();
+#if defined(CONFIG_SUPERR_SIM)
+        sim_scan_pass_end();
+#endif
+        boot_timing_mark(BOOT_PHASE_FIRST_SCAN);
         
         // Power Management Check
         int64_t now = k_uptime_get();
@@ -733,10 +1259,8 @@ void scan_thread_entry(void *p1, void *p2, void *p3) {
             enter_deep_sleep();
         }
 
-        k_usleep(100); // Sleep 100us (0.1ms) to release CPU to lower priority threads (LEDs)
-
-        // Feed Watchdog every 1000 loops (~1 sec)
-        if (++loop_count >= 1000) {
+        // Feed Watchdog every ~1 sec
+        if (++loop_count >= WDT_FEED_TICKS) {
             if (wdt) wdt_feed(wdt, wdt_chan_scan);
             loop_count = 0;
         }
@@ -786,19 +1310,41 @@ static void test_led_pattern(void)
 
 // #endif
 
+// ========== WAKE DETECTION ==========
+// True when this boot is a wake from System OFF (triggered by a key press)
+static bool detect_wake_from_sleep(void)
+{
+    uint32_t cause = 0;
+
+    if (hwinfo_get_reset_cause(&cause) < 0) {
+        return false;
+    }
+    // Reset reasons are sticky on nRF - clear so the next boot is accurate
+    hwinfo_clear_reset_cause();
+
+    return (cause & RESET_LOW_POWER_WAKE) != 0;
+}
+
 // ========== MAIN FUNCTION ==========
+// Boot order is chosen to get the keyboard playable as early as possible:
+// pins, saved settings and the watchdog first, then the scan/LED threads,
+// and only then Bluetooth, which takes the longest and comes up while the
+// keys are already being scanned.
 int main(void)
 {
     int ret;
 
-    printk("\n");
-    printk("==============================================\n");
-    printk("   Superr Velocity MIDI Keyboard v3.0\n");
-    printk("   6x4 Diode-Protected Dual Matrix\n");
-    printk("   24 Velocity-Sensitive Keys\n");
-    printk("   BLE MIDI Controller with Test Pin\n");
-    printk("==============================================\n");
-    printk("\n");
+    boot_timing_mark(BOOT_PHASE_MAIN);
+    woke_from_sleep = detect_wake_from_sleep();
+
+    boot_printk("\n");
+    boot_printk("==============================================\n");
+    boot_printk("   Superr Velocity MIDI Keyboard v3.0\n");
+    boot_printk("   6x4 Diode-Protected Dual Matrix\n");
+    boot_printk("   24 Velocity-Sensitive Keys\n");
+    boot_printk("   BLE MIDI Controller with Test Pin\n");
+    boot_printk("==============================================\n");
+    boot_printk("\n");
     
     // Initialize all key states to zero
     memset(keys, 0, sizeof(keys));
@@ -813,7 +1359,7 @@ int main(void)
         printk("[ERROR] Failed to configure BLE Status LED\n");
         return 0;
     }
-    printk("[OK] BLE Status LED configured\n");
+    boot_printk("[OK] BLE Status LED configured\n");
     
     // ========== Initialize GPIO Pins ==========
     ret = init_gpio();
@@ -821,13 +1367,31 @@ int main(void)
         printk("\n[ERROR] GPIO initialization failed!\n");
         return 0;
     }
+#if defined(CONFIG_SUPERR_BOOT_DIAGNOSTICS)
+    gpio_self_test();
+#endif
+    boot_timing_mark(BOOT_PHASE_GPIO);
+
+    // ========== Restore Settings ==========
+    // Saved settings must be in place, and the first config snapshot
+    // published, before any thread reads it
+    ret = config_store_init();
+    if (ret) {
+        printk("[WARN] Saved settings unavailable, using defaults\n");
+    }
+    config_snapshot_init();
+    recorder_init();
+    boot_timing_mark(BOOT_PHASE_SETTINGS);
+
+    scan_stats_init(k_ticks_to_us_floor32(SCAN_PERIOD_TICKS));
+    init_settling();
 
     // ========== Initialize LED Strip ==========
     if (device_is_ready(strip)) {
-        printk("[OK] Found LED strip device %s\n", strip->name);
+        boot_printk("[OK] Found LED strip device %s\n", strip->name);
         memset(pixels, 0, sizeof(pixels)); // Force clear all LEDs
         led_strip_update_rgb(strip, pixels, SUB_STRIP_NUM_PIXELS);
-        printk("[OK] Cleared LED strip to OFF\n");
+        boot_printk("[OK] Cleared LED strip to OFF\n");
     } else {
         printk("[ERROR] LED strip device not ready!\n");
     }
@@ -839,21 +1403,10 @@ int main(void)
     }
     */
 
-    // ========== Initialize BLE MIDI ==========
-    printk("\n[BLE] Initializing BLE MIDI...\n");
-    ret = ble_midi_init(&ble_status_led);
-    if (ret) {
-        printk("[ERROR] BLE MIDI initialization failed (err %d)\n", ret);
-        return 0;
-    }
-    
-    // ========== Initialize Config Service ==========
-    ret = ble_config_init();
-    if (ret) {
-        printk("[WARN] BLE Config initialization failed\n");
-    }
-
     // ========== Initialize Watchdog ==========
+    // Armed before the threads start so their first feeds are valid.
+    // Builds without one (native_sim) leave wdt NULL and skip the feeds.
+#if defined(CONFIG_WATCHDOG)
     wdt = DEVICE_DT_GET(DT_ALIAS(watchdog0));
     if (!device_is_ready(wdt)) {
         printk("[CRITICAL] Watchdog not ready! System unsafe.\n");
@@ -880,52 +1433,83 @@ int main(void)
         printk("[ERROR] WDT setup failed\n");
         return 0;
     }
-    printk("[OK] Watchdog Armed! (5s timeout)\n");
+    boot_printk("[OK] Watchdog Armed! (5s timeout)\n");
+#endif
+    boot_timing_mark(BOOT_PHASE_WATCHDOG);
 
-    printk("\n");
-    printk("==============================================\n");
-    printk("   SYSTEM READY - 24 KEYS + TEST PIN\n");
-    printk("==============================================\n");
-    printk("   Hardware: 17 GPIO Pins (P1 port)\n");
-    printk("   - 4 Columns (P1.00-P1.03) -> INPUT\n");
-    printk("   - 6 Matrix 1 Rows (P1.04-P1.09) -> OUT\n");
-    printk("   - 6 Matrix 2 Rows (P1.10-P1.15) -> OUT\n");
-    printk("   - 1 Test Pin (P0.27) -> 3.3V Detect\n");
-    printk("\n");
-    printk("   Matrix Configuration:\n");
-    printk("   - 24 velocity-sensitive keys (6x4)\n");
-    printk("   - Diode-protected matrix\n");
-    printk("   - Standard keyboard matrix logic\n");
-    printk("   - No conflicts with board features\n");
-    printk("\n");
-    printk("   MIDI Configuration:\n");
-    printk("   - Notes: %d - %d\n", 
-           BASE_MIDI_NOTE, BASE_MIDI_NOTE + NUM_KEYS - 1);
-    printk("   - Velocity: %d-%d (dynamic)\n", 
-           MIN_VELOCITY, MAX_VELOCITY);
-    printk("   - Channel: %d\n", MIDI_CHANNEL + 1);
-    printk("==============================================\n");
-    printk("\n");
-    printk("[READY] Ready to play!\n");
-    printk("[INFO] HARDWARE: Column -> Switch -> Diode -> Row\n");
-    printk("   Columns (P1.00-03) INPUT with PULL-UP -> default HIGH\n");
-    printk("   Rows (P1.04-15) OUTPUT -> scan by setting LOW\n");
-    printk("   When key pressed -> Column reads LOW\n");
-    printk("[TEST] Touch P0.27 to 3.3V to test connectivity\n");
-    printk("[SCAN] Scanning 24 keys for velocity sensitivity\n\n");
-    
     // ========== Start RTOS Threads ==========
+    // Scanning starts here; notes played before BLE is up are simply not sent
     k_thread_create(&scan_thread_data, scan_stack,
                     K_THREAD_STACK_SIZEOF(scan_stack),
                     scan_thread_entry, NULL, NULL, NULL,
                     SCAN_PRIORITY, 0, K_NO_WAIT);
-                    
+    k_thread_name_set(&scan_thread_data, "scan");
+
     k_thread_create(&led_thread_data, led_stack,
                     K_THREAD_STACK_SIZEOF(led_stack),
                     led_thread_entry, NULL, NULL, NULL,
                     LED_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&led_thread_data, "led");
+#if defined(CONFIG_SUPERR_PEDALS)
+    pedals_start();
+#endif
+    boot_timing_mark(BOOT_PHASE_THREADS);
 
-
+    // ========== Initialize BLE MIDI ==========
+    // Runs in parallel with scanning: bt_enable() blocks this thread while
+    // the network core starts, which leaves the CPU to the scan thread
+    boot_printk("\n[BLE] Initializing BLE MIDI...\n");
+    ret = ble_midi_init(&ble_status_led);
+    if (ret) {
+        printk("[ERROR] BLE MIDI initialization failed (err %d)\n", ret);
+    } else {
+        if (led_stream_init()) {
+            printk("[WARN] LED frame stream unavailable\n");
+        }
+        if (recorder_download_init()) {
+            printk("[WARN] Recording download unavailable\n");
+        }
+    }
+    
+    // ========== Initialize Config Service ==========
+    ret = ble_config_init();
+    if (ret) {
+        printk("[WARN] BLE Config initialization failed\n");
+    }
+    kbd_state_init();
+
+    boot_printk("\n");
+    boot_printk("==============================================\n");
+    boot_printk("   SYSTEM READY - %d KEYS\n", NUM_KEYS);
+    boot_printk("==============================================\n");
+    boot_printk("   Hardware: %d GPIO Pins (devicetree keyboard-matrix)\n",
+                NUM_COLS + 2 * NUM_ROWS);
+    boot_printk("   - %d Columns -> INPUT\n", NUM_COLS);
+    boot_printk("   - %d Matrix 1 Rows -> OUT\n", NUM_ROWS);
+    boot_printk("   - %d Matrix 2 Rows -> OUT\n", NUM_ROWS);
+    boot_printk("\n");
+    boot_printk("   Matrix Configuration:\n");
+    boot_printk("   - %d velocity-sensitive keys (%dx%d)\n", NUM_KEYS, NUM_ROWS, NUM_COLS);
+    boot_printk("   - Diode-protected matrix\n");
+    boot_printk("   - Standard keyboard matrix logic\n");
+    boot_printk("   - No conflicts with board features\n");
+    boot_printk("\n");
+    boot_printk("   MIDI Configuration:\n");
+    boot_printk("   - Notes: %d - %d\n", 
+           BASE_MIDI_NOTE, BASE_MIDI_NOTE + NUM_KEYS - 1);
+    boot_printk("   - Velocity: %d-%d (dynamic)\n", 
+           MIN_VELOCITY, MAX_VELOCITY);
+    boot_printk("   - Channel: %d\n", MIDI_CHANNEL + 1);
+    boot_printk("==============================================\n");
+    boot_printk("\n");
+    printk("[READY] Ready to play!%s\n", woke_from_sleep ? " (wake from deep sleep)" : "");
+    boot_printk("[INFO] HARDWARE: Column -> Switch -> Diode -> Row\n");
+    boot_printk("   Columns INPUT with PULL-UP -> default HIGH\n");
+    boot_printk("   Rows OUTPUT -> scan by setting LOW\n");
+    boot_printk("   When key pressed -> Column reads LOW\n");
+    boot_printk("[SCAN] Scanning %d keys for velocity sensitivity\n\n", NUM_KEYS);
+
+    boot_timing_report();
 
     // Main thread becomes idle or handles BLE management
     while (1) {
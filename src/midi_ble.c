@@ -99,3 +99,35 @@ int midi_ble_control_change(uint8_t cc_num, uint8_t value, uint8_t channel,
     return midi_ble_encode(&ump, buf, buf_len);
 }
 
+// ========== MULTI-MESSAGE PACKETS ==========
+
+void midi_ble_packet_init(struct midi_ble_packet *pkt, uint8_t *buf, size_t cap)
+{
+    pkt->buf = buf;
+    pkt->cap = cap;
+    pkt->len = 0;
+    pkt->first_ms = 0;
+}
+
+int midi_ble_packet_add(struct midi_ble_packet *pkt, uint32_t ts_ms,
+                        uint8_t status, uint8_t data1, uint8_t data2)
+{
+    size_t need = MIDI_BLE_MSG_SIZE + (pkt->len ? 0 : MIDI_BLE_HEADER_SIZE);
+
+    if (pkt->len + need > pkt->cap) {
+        return -ENOSPC;
+    }
+
+    if (pkt->len == 0) {
+        pkt->first_ms = ts_ms & 0x1FFF;
+        pkt->buf[pkt->len++] = 0x80 | ((ts_ms >> 7) & 0x3F);
+    } else if (((ts_ms - pkt->first_ms) & 0x1FFF) > 127) {
+        return -ERANGE;
+    }
+
+    pkt->buf[pkt->len++] = 0x80 | (ts_ms & 0x7F);
+    pkt->buf[pkt->len++] = status;
+    pkt->buf[pkt->len++] = data1 & 0x7F;
+    pkt->buf[pkt->len++] = data2 & 0x7F;
+    return 0;
+}
@@ -55,5 +55,44 @@ int midi_ble_note_off(uint8_t note, uint8_t velocity, uint8_t channel,
 int midi_ble_control_change(uint8_t cc_num, uint8_t value, uint8_t channel,
                              uint8_t *buf, size_t buf_len);
 
+// ========== MULTI-MESSAGE PACKETS ==========
+// A BLE MIDI packet carries one header byte (timestamp bits 12-7) followed
+// by any number of [timestamp bits 6-0][status][data1][data2] messages.
+// Timestamps are 13-bit milliseconds; the receiver treats a low byte that
+// goes backwards as a wrap, so one packet may span up to 127 ms.
+
+#define MIDI_BLE_NOTE_OFF        0x80
+#define MIDI_BLE_NOTE_ON         0x90
+#define MIDI_BLE_CONTROL_CHANGE  0xB0
+
+#define MIDI_BLE_HEADER_SIZE     1
+#define MIDI_BLE_MSG_SIZE        4   // Timestamp + 3-byte channel message
+
+struct midi_ble_packet {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;         // 0 until the first message is added
+    uint16_t first_ms;  // Timestamp of the first message
+};
+
+/**
+ * @brief Start an empty packet in buf
+ */
+void midi_ble_packet_init(struct midi_ble_packet *pkt, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Append a 3-byte channel message with its own timestamp
+ *
+ * @param pkt Packet being built
+ * @param ts_ms Message time (ms, any 32-bit clock; 13 bits are used)
+ * @param status Status byte (type | channel)
+ * @param data1 First data byte
+ * @param data2 Second data byte
+ * @return 0 on success, -ENOSPC if the packet is full, -ERANGE if the
+ *         message is too far from the first one for this packet
+ */
+int midi_ble_packet_add(struct midi_ble_packet *pkt, uint32_t ts_ms,
+                        uint8_t status, uint8_t data1, uint8_t data2);
+
 #endif // MIDI_BLE_H
 
@@ -0,0 +1,326 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+#include "midi_ble_rx.h"
+#include "midi_clock.h"
+
+// ========== RINGS ==========
+// Power-of-two SPSC rings: the producer (BT RX) only writes head, the
+// consumer only writes tail. A full ring drops the new record.
+#define EVENT_RING_LEN     64
+#define REALTIME_RING_LEN  32
+
+BUILD_ASSERT((EVENT_RING_LEN & (EVENT_RING_LEN - 1)) == 0, "Ring length must be 2^n");
+BUILD_ASSERT((REALTIME_RING_LEN & (REALTIME_RING_LEN - 1)) == 0, "Ring length must be 2^n");
+
+static struct midi_rx_event event_ring[EVENT_RING_LEN];
+static atomic_t event_head, event_tail;
+static struct midi_rx_realtime realtime_ring[REALTIME_RING_LEN];
+static atomic_t realtime_head, realtime_tail;
+
+// Published SysEx: one slot, owned by the consumer while sysex_ready is set
+static uint8_t sysex_out[MIDI_RX_SYSEX_MAX];
+static size_t sysex_out_len;
+static atomic_t sysex_ready;
+
+static struct midi_ble_rx_stats stats;   // Written by the producer only
+
+// ========== PER-LINK PARSER STATE ==========
+struct rx_parser {
+    uint8_t status;          // Message being collected (0 = none)
+    bool running;            // status may be reused (channel messages)
+    uint8_t need;            // Data bytes the status takes
+    uint8_t have;
+    uint8_t data[2];
+    uint16_t time;           // Timestamp of the message being collected
+    bool timed;              // time set for it (running status: not yet)
+    uint16_t ts_high;        // Timestamp bits 12-7 (plus wraps in packet)
+    uint8_t ts_low;
+    bool in_sysex;
+    bool sysex_overflow;
+    uint16_t sysex_time;     // Latest timestamp inside the running SysEx
+    size_t sysex_len;
+    uint8_t sysex[MIDI_RX_SYSEX_MAX];
+};
+
+static struct rx_parser parsers[MIDI_RX_MAX_SOURCES];
+
+static inline uint16_t parser_time(const struct rx_parser *p)
+{
+    return ((p->ts_high << 7) | p->ts_low) & 0x1FFF;
+}
+
+static void push_event(uint8_t source, const struct rx_parser *p)
+{
+    atomic_val_t head = atomic_get(&event_head);
+
+    if (head - atomic_get(&event_tail) >= EVENT_RING_LEN) {
+        stats.dropped++;
+        return;
+    }
+
+    struct midi_rx_event *e = &event_ring[head & (EVENT_RING_LEN - 1)];
+    e->time_ms = p->time;
+    e->source = source;
+    e->status = p->status;
+    e->data1 = p->need > 0 ? p->data[0] : 0;
+    e->data2 = p->need > 1 ? p->data[1] : 0;
+    atomic_set(&event_head, head + 1);   // Publish after the record is written
+    stats.events++;
+}
+
+static void push_realtime(uint8_t source, const struct rx_parser *p, uint8_t status)
+{
+    atomic_val_t head = atomic_get(&realtime_head);
+
+    if (head - atomic_get(&realtime_tail) >= REALTIME_RING_LEN) {
+        stats.dropped++;
+        return;
+    }
+
+    struct midi_rx_realtime *r = &realtime_ring[head & (REALTIME_RING_LEN - 1)];
+    r->time_ms = parser_time(p);
+    r->source = source;
+    r->status = status;
+    atomic_set(&realtime_head, head + 1);
+    stats.realtime++;
+}
+
+static void publish_sysex(struct rx_parser *p)
+{
+    if (p->sysex_overflow) {
+        stats.sysex_overflow++;
+        return;
+    }
+    if (atomic_get(&sysex_ready)) {
+        // Consumer has not taken the previous one yet
+        stats.dropped++;
+        return;
+    }
+    memcpy(sysex_out, p->sysex, p->sysex_len);
+    sysex_out_len = p->sysex_len;
+    atomic_set(&sysex_ready, 1);
+    stats.sysex++;
+}
+
+// Data bytes taken by a status byte (channel voice and system common)
+static uint8_t data_len(uint8_t status)
+{
+    switch (status & 0xF0) {
+    case 0xC0:  // Program Change
+    case 0xD0:  // Channel Pressure
+        return 1;
+    case 0xF0:
+        switch (status) {
+        case 0xF1:  // MTC quarter frame
+        case 0xF3:  // Song select
+            return 1;
+        case 0xF2:  // Song position
+            return 2;
+        default:    // F6 tune request and undefined F4/F5
+            return 0;
+        }
+    default:
+        return 2;
+    }
+}
+
+static void handle_status(uint8_t source, struct rx_parser *p, uint8_t b)
+{
+    if (b >= 0xF8) {
+        // Real-time: may sit anywhere, leaves every other state alone.
+        // Clock and transport go to the tempo tracker right away, with
+        // the time they arrived.
+        if (b == 0xF8 || (b >= 0xFA && b <= 0xFC)) {
+            midi_clock_input(source, b, parser_time(p), k_uptime_ticks());
+            stats.realtime++;
+        } else {
+            push_realtime(source, p, b);
+        }
+        return;
+    }
+
+    if (b == 0xF7) {
+        if (p->in_sysex) {
+            publish_sysex(p);
+            p->in_sysex = false;
+        } else {
+            stats.malformed++;
+        }
+        return;
+    }
+
+    if (p->in_sysex) {
+        // Any other status ends an unterminated SysEx
+        p->in_sysex = false;
+        stats.malformed++;
+    }
+
+    if (b == 0xF0) {
+        p->in_sysex = true;
+        p->sysex_overflow = false;
+        p->sysex_time = parser_time(p);
+        p->sysex_len = 0;
+        p->status = 0;
+        p->running = false;
+        return;
+    }
+
+    p->status = b;
+    p->running = (b < 0xF0);   // System common cancels running status
+    p->need = data_len(b);
+    p->have = 0;
+    // Real-time bytes inside the message carry their own timestamps
+    p->time = parser_time(p);
+    p->timed = true;
+
+    if (p->need == 0) {
+        push_event(source, p);
+        p->status = 0;
+    }
+}
+
+static void handle_data(uint8_t source, struct rx_parser *p, uint8_t b)
+{
+    if (p->in_sysex) {
+        if (p->sysex_len < sizeof(p->sysex)) {
+            p->sysex[p->sysex_len++] = b;
+        } else {
+            p->sysex_overflow = true;
+        }
+        return;
+    }
+
+    if (!p->status) {
+        stats.malformed++;
+        return;
+    }
+
+    if (!p->timed) {
+        // Running status: the message starts at its first data byte
+        p->time = parser_time(p);
+        p->timed = true;
+    }
+    p->data[p->have++] = b;
+    if (p->have == p->need) {
+        push_event(source, p);
+        p->have = 0;
+        p->timed = false;
+        if (!p->running) {
+            p->status = 0;
+        }
+    }
+}
+
+// ========== API ==========
+
+void midi_ble_rx_reset(uint8_t source)
+{
+    if (source < MIDI_RX_MAX_SOURCES) {
+        memset(&parsers[source], 0, sizeof(parsers[source]));
+    }
+}
+
+int midi_ble_rx_parse(uint8_t source, const uint8_t *data, size_t len)
+{
+    if (source >= MIDI_RX_MAX_SOURCES || len < 2 || (data[0] & 0xC0) != 0x80) {
+        stats.malformed++;
+        return -EINVAL;
+    }
+
+    struct rx_parser *p = &parsers[source];
+    bool after_ts = false;   // Previous byte was a timestamp
+    bool have_ts = false;    // A timestamp was seen in this packet
+
+    stats.packets++;
+    p->ts_high = data[0] & 0x3F;
+
+    for (size_t i = 1; i < len; i++) {
+        uint8_t b = data[i];
+
+        if (!(b & 0x80)) {
+            // Data byte: running status, SysEx payload or continuation
+            after_ts = false;
+            handle_data(source, p, b);
+        } else if (!after_ts) {
+            // A high-bit byte not preceded by a timestamp is a timestamp.
+            // Low 7 bits going backwards mean bits 12-7 advanced.
+            uint8_t low = b & 0x7F;
+            if (have_ts) {
+                if (low < p->ts_low) {
+                    p->ts_high++;
+                }
+            } else if (p->in_sysex) {
+                // First timestamp of a SysEx continuation packet: it cannot
+                // be earlier than the SysEx's last one, so if it is, the low
+                // bits wrapped after the header was stamped
+                uint16_t t = ((p->ts_high << 7) | low) & 0x1FFF;
+                uint16_t behind = (p->sysex_time - t) & 0x1FFF;
+                if (behind > 0 && behind < 0x1000) {
+                    p->ts_high++;
+                }
+            }
+            p->ts_low = low;
+            if (p->in_sysex) {
+                p->sysex_time = parser_time(p);
+            }
+            have_ts = true;
+            after_ts = true;
+        } else {
+            after_ts = false;
+            handle_status(source, p, b);
+        }
+    }
+
+    // A message cannot span packets (only SysEx can); drop a partial one
+    if (p->have) {
+        p->have = 0;
+        p->timed = false;
+        stats.malformed++;
+    }
+    return 0;
+}
+
+bool midi_ble_rx_get(struct midi_rx_event *out)
+{
+    atomic_val_t tail = atomic_get(&event_tail);
+
+    if (tail == atomic_get(&event_head)) {
+        return false;
+    }
+    *out = event_ring[tail & (EVENT_RING_LEN - 1)];
+    atomic_set(&event_tail, tail + 1);
+    return true;
+}
+
+bool midi_ble_rx_get_realtime(struct midi_rx_realtime *out)
+{
+    atomic_val_t tail = atomic_get(&realtime_tail);
+
+    if (tail == atomic_get(&realtime_head)) {
+        return false;
+    }
+    *out = realtime_ring[tail & (REALTIME_RING_LEN - 1)];
+    atomic_set(&realtime_tail, tail + 1);
+    return true;
+}
+
+int midi_ble_rx_get_sysex(uint8_t *buf, size_t cap)
+{
+    if (!atomic_get(&sysex_ready)) {
+        return 0;
+    }
+    if (sysex_out_len > cap) {
+        return -ENOSPC;
+    }
+
+    size_t len = sysex_out_len;
+    memcpy(buf, sysex_out, len);
+    atomic_set(&sysex_ready, 0);
+    return (int)len;
+}
+
+void midi_ble_rx_get_stats(struct midi_ble_rx_stats *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,90 @@
+#ifndef MIDI_BLE_RX_H
+#define MIDI_BLE_RX_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+// ========== BLE MIDI RECEIVE ==========
+// Streaming parser for packets written to the MIDI I/O characteristic.
+// It runs in the BT RX callback, reads the GATT buffer in place and only
+// writes fixed-size records into bounded single-producer/single-consumer
+// rings, so the BT RX thread does nothing beyond parsing:
+// - channel voice and system common messages -> event ring
+// - real-time bytes, even when they are interleaved inside another message
+//   or a SysEx: clock, Start, Continue and Stop -> tempo tracker
+//   (midi_clock.c), the others (Active Sensing, Reset) -> real-time ring
+// - SysEx is reassembled across packets in a bounded per-link buffer and
+//   published whole into one slot (taken by the LED thread, which logs
+//   it); longer messages are counted and discarded
+// Parser state (running status, partial message, SysEx) is kept per link,
+// so several centrals can send at once.
+
+#define MIDI_RX_MAX_SOURCES  CONFIG_BT_MAX_CONN
+#define MIDI_RX_SYSEX_MAX    128   // Bytes between F0 and F7
+
+struct midi_rx_event {
+    uint16_t time_ms;   // 13-bit BLE MIDI timestamp of the message
+    uint8_t source;     // Link slot it came from
+    uint8_t status;     // Status byte (running status resolved)
+    uint8_t data1;
+    uint8_t data2;      // 0 for one-byte messages
+};
+
+struct midi_rx_realtime {
+    uint16_t time_ms;
+    uint8_t source;
+    uint8_t status;     // 0xF9, 0xFD - 0xFF
+};
+
+struct midi_ble_rx_stats {
+    uint32_t packets;
+    uint32_t events;           // Channel voice / system common decoded
+    uint32_t realtime;         // Including clock / transport
+    uint32_t sysex;            // Complete SysEx messages published
+    uint32_t dropped;          // Records lost to a full ring / SysEx slot not yet taken
+    uint32_t malformed;        // Bad headers and stray data bytes
+    uint32_t sysex_overflow;   // SysEx longer than MIDI_RX_SYSEX_MAX
+};
+
+/**
+ * @brief Forget any partial message / SysEx of a link (on (dis)connect)
+ */
+void midi_ble_rx_reset(uint8_t source);
+
+/**
+ * @brief Parse one BLE MIDI packet (BT RX context)
+ *
+ * @param source Link slot the packet came from
+ * @param data Packet as written by the central
+ * @param len Packet length
+ * @return 0 on success, -EINVAL if the packet header is invalid
+ */
+int midi_ble_rx_parse(uint8_t source, const uint8_t *data, size_t len);
+
+/**
+ * @brief Take the oldest decoded message (single consumer)
+ *
+ * @return true if out was filled
+ */
+bool midi_ble_rx_get(struct midi_rx_event *out);
+
+/**
+ * @brief Take the oldest real-time message (single consumer)
+ *
+ * @return true if out was filled
+ */
+bool midi_ble_rx_get_realtime(struct midi_rx_realtime *out);
+
+/**
+ * @brief Take the last complete SysEx message (single consumer)
+ *
+ * @param buf Output, without the F0/F7 framing
+ * @param cap Size of buf
+ * @return Bytes copied, 0 if none is waiting, -ENOSPC if buf is too small
+ */
+int midi_ble_rx_get_sysex(uint8_t *buf, size_t cap);
+
+/** @brief Get the receive counters */
+void midi_ble_rx_get_stats(struct midi_ble_rx_stats *out);
+
+#endif // MIDI_BLE_RX_H
@@ -0,0 +1,228 @@
+#include <zephyr/kernel.h>
+#include <stdlib.h>
+#include "midi_clock.h"
+
+// Loop gains as shifts: each clock moves the phase by err/8 and the period
+// by err/64. Critically damped enough to settle within ~20 clocks (under
+// a second at 120 BPM) while averaging 1 ms timestamp steps down to a
+// tempo wobble of a few hundredths of a BPM.
+#define PLL_PHASE_SHIFT     3
+#define PLL_PERIOD_SHIFT    6
+
+#define MIN_PERIOD_US       (60000000 / (300 * MIDI_CLOCK_PPQN))   // 300 BPM
+#define MAX_PERIOD_US       (60000000 / (20 * MIDI_CLOCK_PPQN))    // 20 BPM
+#define MAX_BRIDGED         4    // Lost clocks bridged before relocking
+#define MAX_OUTLIERS        4    // Clocks off by > 1/4 period in a row: relock
+#define OFFSET_LEAK_US      4    // Per clock; follows up to ~200 ppm drift
+
+static struct k_spinlock clock_lock;
+
+// Loop state (clock_lock)
+static uint8_t clock_source;
+static bool have_ref;            // One clock seen, no period yet
+static bool locked;              // Period known
+static bool started;
+static uint16_t last_ts;         // 13-bit timestamp of the last clock
+static int64_t sender_ms;        // Sender time of the last clock, unwrapped
+static int64_t est_us;           // Loop's sender time of the last clock
+static int64_t count;            // Number of the last clock since Start (0 = first)
+static int32_t period_q8;        // us per clock, 24.8 fixed point
+static int64_t offset_us;        // Local time - sender time, smallest seen
+static int64_t last_rx;          // Local tick the last clock arrived on
+static uint8_t outliers;
+static int32_t jitter_q4;        // Mean |err| in us, 28.4 fixed point
+
+static struct midi_clock_status stats;   // Counters only
+
+static bool fresh(int64_t now)
+{
+    return (have_ref || locked) &&
+           now - last_rx < k_ms_to_ticks_ceil64(MIDI_CLOCK_TIMEOUT_MS);
+}
+
+static void relock(void)
+{
+    if (locked) {
+        stats.relocks++;
+    }
+    have_ref = false;
+    locked = false;
+    outliers = 0;
+}
+
+// ========== PHASE-LOCKED LOOP ==========
+// Call with clock_lock held
+static void track_clock(uint16_t ts_ms, int64_t rx_ticks)
+{
+    int64_t rx_us = (int64_t)k_ticks_to_us_floor64(rx_ticks);
+
+    sender_ms += (ts_ms - last_ts) & 0x1FFF;
+    last_ts = ts_ms;
+
+    int64_t meas_us = sender_ms * 1000;
+
+    if (!have_ref && !locked) {
+        have_ref = true;
+        est_us = meas_us;
+        offset_us = rx_us - meas_us;
+        return;
+    }
+
+    // Smallest transport delay wins; leak upwards so drift is followed
+    offset_us = MIN(offset_us + OFFSET_LEAK_US, rx_us - meas_us);
+
+    if (!locked) {
+        int64_t d = meas_us - est_us;
+
+        est_us = meas_us;
+        if (d >= MIN_PERIOD_US && d <= MAX_PERIOD_US) {
+            period_q8 = (int32_t)(d << 8);
+            locked = true;
+            have_ref = false;
+        }
+        return;
+    }
+
+    int32_t period = period_q8 >> 8;
+    int64_t pred = est_us + period;
+    int64_t err = meas_us - pred;
+
+    // A clock landing a whole number of periods late means some were lost
+    // on the way (a dropped packet); step over them instead of dragging
+    // the loop. Only while in lock: an error growing clock by clock is a
+    // tempo change and passes through whole periods too.
+    int64_t lost = (err + period / 2) / period;
+
+    if (lost > 0 && outliers == 0 && llabs(err - lost * period) <= period / 4) {
+        count += lost;
+        if (lost > MAX_BRIDGED) {
+            relock();
+            have_ref = true;
+            est_us = meas_us;
+            return;
+        }
+        pred += lost * period;
+        err = meas_us - pred;
+        stats.missed += (uint32_t)lost;
+    }
+
+    if (llabs(err) > period / 4) {
+        if (++outliers >= MAX_OUTLIERS) {
+            // Tempo jumped further than the loop can follow quickly
+            relock();
+            have_ref = true;
+            est_us = meas_us;
+            return;
+        }
+    } else {
+        outliers = 0;
+    }
+    err = CLAMP(err, -(int64_t)period / 2, (int64_t)period / 2);
+
+    est_us = pred + err / (1 << PLL_PHASE_SHIFT);
+    period_q8 = CLAMP(period_q8 + (int32_t)(err * 256 / (1 << PLL_PERIOD_SHIFT)),
+                      MIN_PERIOD_US << 8, MAX_PERIOD_US << 8);
+
+    jitter_q4 += ((int32_t)llabs(err) * 16 - jitter_q4) / 16;
+}
+
+void midi_clock_input(uint8_t source, uint8_t status, uint16_t ts_ms, int64_t rx_ticks)
+{
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+
+    if (source != clock_source) {
+        if (fresh(rx_ticks)) {
+            // Someone else is driving the clock
+            k_spin_unlock(&clock_lock, key);
+            return;
+        }
+        clock_source = source;
+        relock();
+        started = false;
+    }
+
+    switch (status) {
+    case 0xF8:
+        if (!fresh(rx_ticks)) {
+            relock();
+        }
+        stats.ticks++;
+        count++;   // Song position counts every clock, locked or not
+        track_clock(ts_ms, rx_ticks);
+        last_rx = rx_ticks;
+        break;
+    case 0xFA:   // Start: the next clock is beat 0
+        started = true;
+        count = -1;
+        stats.starts++;
+        break;
+    case 0xFB:   // Continue from where Stop left the position
+        started = true;
+        stats.starts++;
+        break;
+    case 0xFC:   // Stop
+        started = false;
+        break;
+    default:
+        break;
+    }
+    k_spin_unlock(&clock_lock, key);
+}
+
+// ========== QUERIES ==========
+
+// Position in clocks (16.16) at a local time. Call with clock_lock held
+// and the loop locked.
+static int64_t clock_position_q16(int64_t at)
+{
+    int64_t dt = (int64_t)k_ticks_to_us_floor64(at) - offset_us - est_us;
+
+    return count * 65536 + dt * (1 << 24) / period_q8;
+}
+
+bool midi_clock_position(int64_t at, int64_t *beats_q16)
+{
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+    bool running = started && locked && fresh(k_uptime_ticks());
+
+    if (running) {
+        *beats_q16 = clock_position_q16(at) / MIDI_CLOCK_PPQN;
+    }
+    k_spin_unlock(&clock_lock, key);
+    return running;
+}
+
+int64_t midi_clock_time_of(int64_t beats_q16)
+{
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+    int64_t clocks_q16 = beats_q16 * MIDI_CLOCK_PPQN - count * 65536;
+    int64_t dt = clocks_q16 * period_q8;
+
+    // Round up so that the position at the returned time is >= beats_q16
+    dt = dt >= 0 ? (dt + (1 << 24) - 1) / (1 << 24) : dt / (1 << 24);
+    int64_t local_us = est_us + offset_us + dt;
+
+    k_spin_unlock(&clock_lock, key);
+    return (int64_t)k_us_to_ticks_ceil64(MAX(local_us, 0));
+}
+
+void midi_clock_get_status(struct midi_clock_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+    int64_t now = k_uptime_ticks();
+
+    *out = stats;
+    out->locked = locked && fresh(now);
+    out->running = out->locked && started;
+    out->jitter_us = jitter_q4 >> 4;
+    if (out->locked) {
+        int64_t beats_q16 = clock_position_q16(now) / MIDI_CLOCK_PPQN;
+
+        out->period_us = period_q8 >> 8;
+        out->tempo_x100 = (uint16_t)((6000000000ULL << 8) /
+                                     ((uint64_t)period_q8 * MIDI_CLOCK_PPQN));
+        out->beat = (int32_t)(beats_q16 >> 16);      // Floor, also below 0
+        out->phase = (uint16_t)(beats_q16 & 0xFFFF);
+    }
+    k_spin_unlock(&clock_lock, key);
+}
@@ -0,0 +1,75 @@
+#ifndef MIDI_CLOCK_H
+#define MIDI_CLOCK_H
+
+#include <zephyr/types.h>
+
+// ========== MIDI CLOCK FOLLOWER ==========
+// Clock (0xF8), Start, Continue and Stop written to MIDI I/O are handed
+// over straight from the receive parser, together with their BLE MIDI
+// timestamp and the tick they arrived on.
+//
+// Tempo and phase are tracked by a second-order phase-locked loop on the
+// sender's timestamps: each clock is compared with where the loop expected
+// it, and the error nudges both the phase and the period. Timestamps carry
+// the sender's timing, so connection-interval batching never reaches the
+// loop; what is left is 1 ms timestamp quantization, which the loop
+// averages out. Sender time is mapped to local time with the smallest
+// transport delay seen (slowly leaking upwards to follow crystal drift),
+// i.e. a clock is placed where it would have landed on the fastest link.
+//
+// Consumers ask for the song position at a local time, or the local time
+// of a song position, so generated notes and effects stay on the sender's
+// beat without reacting to individual packets. Only one central is
+// followed at a time; another one takes over once it goes quiet.
+
+#define MIDI_CLOCK_PPQN        24
+#define MIDI_CLOCK_TIMEOUT_MS  500   // No clock for this long: stopped
+
+struct midi_clock_status {
+    bool running;           // Started, locked and ticking
+    bool locked;            // Tempo known (ticking, started or not)
+    uint16_t tempo_x100;    // BPM x 100, 0 while unlocked
+    uint32_t period_us;     // Smoothed clock period
+    int32_t beat;           // Beats since Start (negative before the first clock)
+    uint16_t phase;         // Position in the beat, 0 - 65535
+    uint32_t jitter_us;     // Mean |phase error| of recent clocks
+    uint32_t ticks;         // Clocks received
+    uint32_t missed;        // Clocks bridged over (lost packets)
+    uint32_t relocks;       // Lock lost and regained from scratch
+    uint32_t starts;        // Start / Continue received
+};
+
+/**
+ * @brief Feed a clock message (BT RX context)
+ *
+ * @param source Link slot it came from
+ * @param status 0xF8, 0xFA, 0xFB or 0xFC
+ * @param ts_ms 13-bit BLE MIDI timestamp of the message
+ * @param rx_ticks Local time it arrived (k_uptime_ticks())
+ */
+void midi_clock_input(uint8_t source, uint8_t status, uint16_t ts_ms, int64_t rx_ticks);
+
+/**
+ * @brief Song position at a local time
+ *
+ * @param at Local time (k_uptime_ticks() / scheduler_now() based)
+ * @param beats_q16 Output: beats since Start, 16.16 fixed point; negative
+ *        before the first clock after Start
+ * @return true if the clock is running, false otherwise (out untouched)
+ */
+bool midi_clock_position(int64_t at, int64_t *beats_q16);
+
+/**
+ * @brief Local time a song position is reached, rounded up
+ *
+ * Only meaningful while midi_clock_position() reports running.
+ *
+ * @param beats_q16 Beats since Start, 16.16 fixed point
+ * @return Local time in kernel ticks
+ */
+int64_t midi_clock_time_of(int64_t beats_q16);
+
+/** @brief Get the tracked tempo, phase and counters */
+void midi_clock_get_status(struct midi_clock_status *out);
+
+#endif // MIDI_CLOCK_H
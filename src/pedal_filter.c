@@ -0,0 +1,77 @@
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include "pedal_filter.h"
+
+#define STEP_Q4      16                  // One 7-bit step in 1/16 units
+#define TRAVEL_Q4    (127 * STEP_Q4)
+#define SWITCH_ON    (TRAVEL_Q4 * 5 / 8)
+#define SWITCH_OFF   (TRAVEL_Q4 * 3 / 8)
+
+void pedal_filter_init(struct pedal_filter *f)
+{
+    f->value = 0;
+    f->reported = PEDAL_NONE;
+    f->average = 0;
+}
+
+// Pedal travel in 1/16 steps, 0..TRAVEL_Q4
+static int32_t travel_q4(const struct pedal_filter_cfg *cfg, int32_t raw)
+{
+    int32_t span = cfg->raw_max - cfg->raw_min;
+
+    if (span == 0) {
+        return 0;
+    }
+    return CLAMP((raw - cfg->raw_min) * TRAVEL_Q4 / span, 0, TRAVEL_Q4);
+}
+
+bool pedal_filter_batch(struct pedal_filter *f, const struct pedal_filter_cfg *cfg,
+                        const int16_t *samples, size_t count, size_t stride,
+                        uint8_t *out)
+{
+    int32_t sum = 0;
+
+    if (count == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i * stride];
+    }
+    f->average = (int16_t)(sum / (int32_t)count);
+
+    int32_t pos = travel_q4(cfg, f->average);
+
+    if (cfg->is_switch) {
+        if (pos >= SWITCH_ON) {
+            f->value = 127;
+        } else if (pos <= SWITCH_OFF) {
+            f->value = 0;
+        }
+    } else if (pos <= STEP_Q4) {
+        // End stops snap, so noise or a pot that stops short of the rail
+        // cannot hold the pedal one step away from fully off / on
+        f->value = 0;
+    } else if (pos >= TRAVEL_Q4 - STEP_Q4) {
+        f->value = 127;
+    } else {
+        int32_t centre = f->value * STEP_Q4;
+        int32_t band = STEP_Q4 / 2 + cfg->hysteresis;
+
+        if (f->reported == PEDAL_NONE || pos > centre + band || pos < centre - band) {
+            f->value = (uint8_t)((pos + STEP_Q4 / 2) / STEP_Q4);
+        }
+    }
+
+    if (f->value == f->reported) {
+        return false;
+    }
+    if (f->reported != PEDAL_NONE && !cfg->is_switch &&
+        f->value != 0 && f->value != 127 &&
+        abs(f->value - f->reported) < MAX(cfg->threshold, 1)) {
+        return false;
+    }
+
+    f->reported = f->value;
+    *out = f->value;
+    return true;
+}
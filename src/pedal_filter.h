@@ -0,0 +1,62 @@
+#ifndef PEDAL_FILTER_H
+#define PEDAL_FILTER_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+// ========== PEDAL FILTER ==========
+// Turns one batch of raw ADC samples of a pedal into at most one 7-bit
+// controller value, so a noisy pot produces a CC only when it really moved:
+// - Decimation: the batch is averaged, which cancels pot noise and hum
+//   above the batch rate.
+// - Calibration: raw_min..raw_max map to 0..127 (swap them to invert).
+//   The last step at each end snaps to 0 / 127, so a worn pot that stops
+//   short of the rail still turns the controller fully off and on.
+// - Hysteresis: a continuous pedal leaves its current step only when the
+//   average is more than half a step plus `hysteresis` away from it, so a
+//   value sitting on a step boundary does not toggle.
+// - Switch mode (sustain): Schmitt trigger at 5/8 and 3/8 of the travel,
+//   output 127 / 0.
+// - Change threshold: a new value is reported only when it is at least
+//   `threshold` steps from the last reported one, or reaches an end stop,
+//   so a slowly creeping pedal is sent in coarser steps but always settles
+//   fully on or off.
+// Pure logic, no hardware access.
+
+#define PEDAL_NONE  0xFF   // Nothing reported yet
+
+struct pedal_filter_cfg {
+    int16_t raw_min;        // Raw count at heel / released
+    int16_t raw_max;        // Raw count at toe / pressed
+    uint8_t hysteresis;     // Continuous: extra dead band, 1/16 step units
+    uint8_t threshold;      // Continuous: smallest reported change (>= 1)
+    bool is_switch;         // On/off pedal (sustain)
+};
+
+struct pedal_filter {
+    uint8_t value;          // Current filtered value
+    uint8_t reported;       // Last value handed out, PEDAL_NONE at start
+    int16_t average;        // Last batch average (raw counts)
+};
+
+/**
+ * @brief Reset a filter; the next batch always reports
+ */
+void pedal_filter_init(struct pedal_filter *f);
+
+/**
+ * @brief Filter one batch of samples
+ *
+ * @param f Filter state
+ * @param cfg Pedal calibration and thresholds
+ * @param samples First sample of this pedal in the batch
+ * @param count Number of samples of this pedal
+ * @param stride Distance between them (channels per sampling)
+ * @param out Controller value to send, set when true is returned
+ * @return true if the value should be sent
+ */
+bool pedal_filter_batch(struct pedal_filter *f, const struct pedal_filter_cfg *cfg,
+                        const int16_t *samples, size_t count, size_t stride,
+                        uint8_t *out);
+
+#endif // PEDAL_FILTER_H
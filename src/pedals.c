@@ -0,0 +1,180 @@
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/adc.h>
+#include "pedals.h"
+#include "pedal_filter.h"
+#include "ble_midi_service.h"
+#include "recorder.h"
+#include "midi_ble.h"
+#include "keyboard.h"
+
+#define PEDALS_NODE DT_ALIAS(pedals)
+
+#define PEDAL_RETRY_MS   100    // After a failed ADC read
+#define CC_SUSTAIN       64
+#define CC_EXPRESSION    11
+
+struct pedal {
+    const char *name;
+    uint8_t cc;
+    struct adc_dt_spec adc;
+    struct pedal_filter_cfg cfg;
+    struct pedal_filter filter;
+    uint8_t slot;           // Position of this channel in each sampling
+    uint32_t sent;
+};
+
+#define PEDAL_RANGE(name, idx) DT_PROP_BY_IDX(PEDALS_NODE, name##_range, idx)
+
+static struct pedal pedals[] = {
+#if DT_PROP_HAS_NAME(PEDALS_NODE, io_channels, sustain)
+    {
+        .name = "sustain",
+        .cc = CC_SUSTAIN,
+        .adc = ADC_DT_SPEC_GET_BY_NAME(PEDALS_NODE, sustain),
+        .cfg = {
+            .raw_min = PEDAL_RANGE(sustain, 0),
+            .raw_max = PEDAL_RANGE(sustain, 1),
+            .is_switch = true,
+        },
+    },
+#endif
+#if DT_PROP_HAS_NAME(PEDALS_NODE, io_channels, expression)
+    {
+        .name = "expression",
+        .cc = CC_EXPRESSION,
+        .adc = ADC_DT_SPEC_GET_BY_NAME(PEDALS_NODE, expression),
+        .cfg = {
+            .raw_min = PEDAL_RANGE(expression, 0),
+            .raw_max = PEDAL_RANGE(expression, 1),
+            .hysteresis = DT_PROP(PEDALS_NODE, expression_hysteresis),
+            .threshold = DT_PROP(PEDALS_NODE, expression_threshold),
+        },
+    },
+#endif
+};
+
+BUILD_ASSERT(ARRAY_SIZE(pedals) > 0, "pedals node names no sustain/expression channel");
+BUILD_ASSERT(ARRAY_SIZE(pedals) <= PEDAL_MAX);
+
+// One batch: PEDAL_BATCH samplings of every channel, interleaved in
+// channel-number order (the order the ADC writes them)
+static int16_t batch[PEDAL_BATCH * ARRAY_SIZE(pedals)];
+
+static struct k_spinlock pedals_lock;
+static uint32_t batches;
+static uint32_t errors;
+
+static const struct adc_sequence_options seq_opts = {
+    .interval_us = PEDAL_SAMPLE_US,
+    .extra_samplings = PEDAL_BATCH - 1,
+};
+
+static int pedals_setup(struct adc_sequence *seq)
+{
+    const struct device *dev = pedals[0].adc.dev;
+    uint32_t channels = 0;
+
+    for (int i = 0; i < ARRAY_SIZE(pedals); i++) {
+        struct pedal *p = &pedals[i];
+
+        if (p->adc.dev != dev || !adc_is_ready_dt(&p->adc)) {
+            printk("[PEDAL] %s: ADC not ready\n", p->name);
+            return -ENODEV;
+        }
+        int err = adc_channel_setup_dt(&p->adc);
+        if (err) {
+            printk("[PEDAL] %s: channel setup failed (err %d)\n", p->name, err);
+            return err;
+        }
+        channels |= BIT(p->adc.channel_id);
+        pedal_filter_init(&p->filter);
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(pedals); i++) {
+        // Samples of lower-numbered channels come first
+        pedals[i].slot = POPCOUNT(channels & (BIT(pedals[i].adc.channel_id) - 1));
+    }
+
+    adc_sequence_init_dt(&pedals[0].adc, seq);
+    seq->options = &seq_opts;
+    seq->channels = channels;
+    seq->buffer = batch;
+    seq->buffer_size = sizeof(batch);
+    // Hardware oversampling only works on a single channel; the batch
+    // average does the decimation instead
+    seq->oversampling = 0;
+    return 0;
+}
+
+static void send_cc(struct pedal *p, uint8_t value)
+{
+    uint8_t status = MIDI_BLE_CONTROL_CHANGE | MIDI_CHANNEL;
+
+    recorder_log(status, p->cc, value);
+    ble_midi_send_event(status, p->cc, value, 0);
+    p->sent++;
+}
+
+// RTOS: Pedal thread. adc_read() sleeps while the driver takes the batch.
+static void pedals_thread_entry(void *p1, void *p2, void *p3)
+{
+    struct adc_sequence seq;
+
+    if (pedals_setup(&seq)) {
+        return;
+    }
+    printk("[PEDAL] %d pedal(s), %d us sampling, %d samples per batch\n",
+           (int)ARRAY_SIZE(pedals), PEDAL_SAMPLE_US, PEDAL_BATCH);
+
+    while (1) {
+        int err = adc_read(pedals[0].adc.dev, &seq);
+
+        k_spinlock_key_t key = k_spin_lock(&pedals_lock);
+        if (err) {
+            errors++;
+            k_spin_unlock(&pedals_lock, key);
+            k_msleep(PEDAL_RETRY_MS);
+            continue;
+        }
+        batches++;
+
+        for (int i = 0; i < ARRAY_SIZE(pedals); i++) {
+            struct pedal *p = &pedals[i];
+            uint8_t value;
+
+            if (pedal_filter_batch(&p->filter, &p->cfg, &batch[p->slot], PEDAL_BATCH,
+                                   ARRAY_SIZE(pedals), &value)) {
+                send_cc(p, value);
+            }
+        }
+        k_spin_unlock(&pedals_lock, key);
+    }
+}
+
+// Started by main() once the recorder and BLE MIDI queue exist
+K_THREAD_DEFINE(pedals_thread, 1024, pedals_thread_entry, NULL, NULL, NULL,
+                6, 0, SYS_FOREVER_MS);
+
+void pedals_start(void)
+{
+    k_thread_start(pedals_thread);
+}
+
+void pedals_get_stats(struct pedals_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&pedals_lock);
+
+    out->batches = batches;
+    out->errors = errors;
+    out->count = ARRAY_SIZE(pedals);
+    for (int i = 0; i < ARRAY_SIZE(pedals); i++) {
+        out->pedal[i] = (struct pedal_status){
+            .name = pedals[i].name,
+            .cc = pedals[i].cc,
+            .value = pedals[i].filter.value,
+            .raw = pedals[i].filter.average,
+            .sent = pedals[i].sent,
+        };
+    }
+    k_spin_unlock(&pedals_lock, key);
+}
@@ -0,0 +1,42 @@
+#ifndef PEDALS_H
+#define PEDALS_H
+
+#include <zephyr/types.h>
+
+// ========== SUSTAIN / EXPRESSION PEDALS ==========
+// Built only when the devicetree has a "superr,pedals" node aliased as
+// pedals (CONFIG_SUPERR_PEDALS, see pedals.overlay). A dedicated thread
+// has the ADC driver sample every pedal channel at PEDAL_SAMPLE_US into
+// one batch buffer (the SAADC writes each sampling over EasyDMA), then
+// runs the batch through pedal_filter.c. Sustain is sent as CC64 and
+// expression as CC11 on the keyboard channel, and only when the filtered
+// value moves, so a noisy pot cannot flood the BLE MIDI queue.
+
+#define PEDAL_SAMPLE_US  1000   // Sampling interval (all pedals at once)
+#define PEDAL_BATCH      16     // Samplings per batch: a CC at most every 16 ms
+#define PEDAL_MAX        2
+
+struct pedal_status {
+    const char *name;
+    uint8_t cc;
+    uint8_t value;          // Filtered value, 0-127
+    int16_t raw;            // Last batch average (raw counts)
+    uint32_t sent;          // CCs sent
+};
+
+struct pedals_stats {
+    uint32_t batches;
+    uint32_t errors;        // Failed ADC reads
+    uint8_t count;          // Entries used in pedal[]
+    struct pedal_status pedal[PEDAL_MAX];
+};
+
+/**
+ * @brief Start sampling the pedals
+ */
+void pedals_start(void);
+
+/** @brief Get the pedal values and counters */
+void pedals_get_stats(struct pedals_stats *out);
+
+#endif // PEDALS_H
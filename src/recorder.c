@@ -0,0 +1,575 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "recorder.h"
+
+#if defined(CONFIG_SUPERR_RECORDER_FLASH)
+#include <zephyr/storage/flash_map.h>
+#if FIXED_PARTITION_EXISTS(recording_partition)
+#define REC_FLASH 1
+#else
+#warning "CONFIG_SUPERR_RECORDER_FLASH needs a recording_partition; recording to RAM only"
+#endif
+#endif
+
+// ========== RAM RING ==========
+// Blocks are numbered by seq; block seq lives in ram[seq % RAM_BLOCKS].
+// Closed blocks are [ram_first, next_seq), the open block is next_seq.
+// Everything below is guarded by rec_lock; the scan thread only holds it
+// while it encodes one event.
+#define RAM_BLOCKS     CONFIG_SUPERR_RECORDER_RAM_BLOCKS
+#define REC_EVENT_MAX  8   // 5-byte delta + status + 2 data bytes
+
+static uint8_t ram[RAM_BLOCKS][REC_BLOCK_SIZE] __aligned(4);
+static struct k_spinlock rec_lock;
+static uint32_t ram_first;
+static uint32_t next_seq;
+static uint16_t open_len;     // 0 = open block not started yet
+static uint32_t last_ms;      // Time of the previous event in the block
+static uint8_t last_status;   // Running status within the block
+static uint16_t session;
+static uint32_t spill_seq;    // Next block to spill (blocks below are in flash)
+static struct recorder_stats stats;
+
+static inline struct rec_block_hdr *ram_hdr(uint32_t seq)
+{
+    return (struct rec_block_hdr *)ram[seq % RAM_BLOCKS];
+}
+
+static inline size_t block_bytes(const struct rec_block_hdr *h)
+{
+    return sizeof(*h) + h->len;
+}
+
+// Standard MIDI File variable-length quantity, most significant group first
+static int put_vlq(uint8_t *p, uint32_t v)
+{
+    uint8_t tmp[5];
+    int n = 0;
+
+    do {
+        tmp[n++] = v & 0x7F;
+        v >>= 7;
+    } while (v);
+
+    for (int i = 0; i < n; i++) {
+        p[i] = tmp[n - 1 - i] | (i < n - 1 ? 0x80 : 0);
+    }
+    return n;
+}
+
+static inline bool has_data2(uint8_t status)
+{
+    uint8_t type = status & 0xF0;
+    return type != 0xC0 && type != 0xD0;
+}
+
+// Call with rec_lock held
+static void open_block(uint32_t now)
+{
+    struct rec_block_hdr *h = ram_hdr(next_seq);
+
+    h->magic = REC_BLOCK_MAGIC;
+    h->version = REC_FORMAT_VERSION;
+    h->len = 0;
+    h->seq = next_seq;
+    h->start_ms = now;
+    h->session = session;
+    h->reserved = 0;
+    last_ms = now;
+    last_status = 0;
+}
+
+// Call with rec_lock held and open_len > 0
+static void close_block(void)
+{
+    ram_hdr(next_seq)->len = open_len;
+    open_len = 0;
+    next_seq++;
+    stats.blocks++;
+
+    // The next open block reuses the oldest closed block's slot
+    if (next_seq - ram_first >= RAM_BLOCKS) {
+        if (ram_first >= spill_seq) {
+            stats.lost_blocks++;
+        }
+        ram_first++;
+    }
+}
+
+// ========== FLASH SPILL ==========
+#if defined(REC_FLASH)
+// Closed blocks are appended to the partition as a circular log. The page
+// ahead of the write position is erased before its first block, which
+// drops the oldest page of the log. Slot counters are monotonic; a block
+// is stored at slot count % flash_slots. All flash access runs on the
+// system workqueue.
+#define FLASH_PAGE_SIZE   4096   // nRF5340 application core erase unit
+#define BLOCKS_PER_PAGE   (FLASH_PAGE_SIZE / REC_BLOCK_SIZE)
+
+static const struct flash_area *fa;
+static uint32_t flash_slots;
+static uint32_t flash_tail, flash_head;
+static uint8_t spill_buf[REC_BLOCK_SIZE] __aligned(4);
+
+static int flash_append(const uint8_t *blk)
+{
+    uint32_t slot = flash_head % flash_slots;
+    int err;
+
+    if (slot % BLOCKS_PER_PAGE == 0) {
+        err = flash_area_erase(fa, slot * REC_BLOCK_SIZE, FLASH_PAGE_SIZE);
+        if (err) {
+            return err;
+        }
+        if (flash_head + BLOCKS_PER_PAGE > flash_tail + flash_slots) {
+            flash_tail = flash_head + BLOCKS_PER_PAGE - flash_slots;
+        }
+    }
+
+    err = flash_area_write(fa, slot * REC_BLOCK_SIZE, blk, REC_BLOCK_SIZE);
+    if (err) {
+        return err;
+    }
+    flash_head++;
+    return 0;
+}
+
+static bool flash_read_hdr(uint32_t slot, struct rec_block_hdr *h)
+{
+    return flash_area_read(fa, slot * REC_BLOCK_SIZE, h, sizeof(*h)) == 0 &&
+           h->magic == REC_BLOCK_MAGIC && h->version == REC_FORMAT_VERSION &&
+           h->len <= REC_PAYLOAD_SIZE;
+}
+
+// Rebuild the log bounds after boot: the newest block is the one with the
+// highest seq, the log runs back from it until an erased/invalid slot
+static void flash_recover(void)
+{
+    struct rec_block_hdr h;
+    bool any = false;
+    uint32_t max_seq = 0, max_slot = 0;
+    uint16_t max_session = 0;
+
+    for (uint32_t slot = 0; slot < flash_slots; slot++) {
+        if (!flash_read_hdr(slot, &h)) {
+            continue;
+        }
+        if (!any || h.seq > max_seq) {
+            max_seq = h.seq;
+            max_slot = slot;
+            max_session = h.session;
+        }
+        any = true;
+    }
+
+    if (!any) {
+        return;
+    }
+
+    uint32_t n = 0;
+    while (n < flash_slots &&
+           flash_read_hdr((max_slot + flash_slots - n) % flash_slots, &h)) {
+        n++;
+    }
+
+    flash_head = flash_slots + max_slot + 1;   // Keeps tail from underflowing
+    flash_tail = flash_head - n;
+    next_seq = ram_first = spill_seq = max_seq + 1;
+    session = max_session + 1;
+}
+
+static void spill_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    for (;;) {
+        k_spinlock_key_t key = k_spin_lock(&rec_lock);
+        if (spill_seq < ram_first) {
+            spill_seq = ram_first;
+        }
+        if (spill_seq >= next_seq) {
+            k_spin_unlock(&rec_lock, key);
+            break;
+        }
+        memcpy(spill_buf, ram[spill_seq % RAM_BLOCKS], REC_BLOCK_SIZE);
+        k_spin_unlock(&rec_lock, key);
+
+        if (flash_append(spill_buf)) {
+            // Retried when the next block closes
+            stats.flash_errors++;
+            break;
+        }
+
+        key = k_spin_lock(&rec_lock);
+        spill_seq++;
+        stats.spilled++;
+        k_spin_unlock(&rec_lock, key);
+    }
+}
+
+static K_WORK_DEFINE(spill_work, spill_work_handler);
+#endif // REC_FLASH
+
+static void spill_kick(void)
+{
+#if defined(REC_FLASH)
+    if (fa) {
+        k_work_submit(&spill_work);
+    }
+#endif
+}
+
+// ========== LOGGING ==========
+
+void recorder_log(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    uint32_t now = k_uptime_get_32();
+    bool closed = false;
+    k_spinlock_key_t key = k_spin_lock(&rec_lock);
+
+    if (open_len + REC_EVENT_MAX > REC_PAYLOAD_SIZE) {
+        close_block();
+        closed = true;
+    }
+    if (open_len == 0) {
+        open_block(now);
+    }
+
+    // Encoded in place, straight into the open block
+    uint8_t *start = ram[next_seq % RAM_BLOCKS] + sizeof(struct rec_block_hdr) + open_len;
+    uint8_t *p = start;
+
+    p += put_vlq(p, now - last_ms);
+    if (status != last_status) {
+        *p++ = status;
+        last_status = status;
+    }
+    *p++ = data1 & 0x7F;
+    if (has_data2(status)) {
+        *p++ = data2 & 0x7F;
+    }
+
+    open_len += p - start;
+    ram_hdr(next_seq)->len = open_len;
+    last_ms = now;
+    stats.events++;
+    stats.bytes += p - start;
+    k_spin_unlock(&rec_lock, key);
+
+    if (closed) {
+        spill_kick();
+    }
+}
+
+// Close the open block so that it is downloaded / spilled
+static void close_open_block(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&rec_lock);
+    if (open_len) {
+        close_block();
+    }
+    k_spin_unlock(&rec_lock, key);
+}
+
+void recorder_sync(void)
+{
+#if defined(REC_FLASH)
+    struct k_work_sync sync;
+
+    if (!fa) {
+        return;
+    }
+    close_open_block();
+    k_work_submit(&spill_work);
+    k_work_flush(&spill_work, &sync);
+#endif
+}
+
+// System workqueue
+static void clear_all(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&rec_lock);
+    open_len = 0;
+    ram_first = spill_seq = next_seq;
+    k_spin_unlock(&rec_lock, key);
+
+#if defined(REC_FLASH)
+    if (fa) {
+        if (flash_area_erase(fa, 0, flash_slots * REC_BLOCK_SIZE)) {
+            stats.flash_errors++;
+        }
+        flash_tail = flash_head = 0;
+    }
+#endif
+    printk("[REC] Recording cleared\n");
+}
+
+static void clear_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    clear_all();
+}
+
+static K_WORK_DEFINE(clear_work, clear_work_handler);
+
+// ========== DOWNLOAD CHANNEL ==========
+// One central at a time. A dump streams every stored block, oldest first:
+// flash log, then RAM blocks not spilled yet. Up to DL_BUFS SDUs are in
+// flight; the next one is queued from the sent callback, so the transfer
+// runs as fast as the link hands out credits.
+#define DL_BUFS  3
+
+NET_BUF_POOL_FIXED_DEFINE(dl_pool, DL_BUFS, BT_L2CAP_SDU_BUF_SIZE(REC_SDU_MAX),
+                          CONFIG_BT_CONN_TX_USER_DATA_SIZE, NULL);
+
+static struct bt_l2cap_le_chan dl_chan;
+static atomic_t dl_busy;      // Channel connected
+static atomic_t dl_active;    // Dump in progress
+static atomic_t dl_cmd;       // Pending command
+
+// Dump cursor (system workqueue only)
+static uint32_t dl_flash, dl_flash_end;
+static uint32_t dl_seq, dl_end;
+static uint32_t dl_sent, dl_lost;
+static uint8_t dl_status;     // 0xFF = blocks still to send
+
+static void dl_work_handler(struct k_work *work);
+static K_WORK_DEFINE(dl_work, dl_work_handler);
+
+static void dl_start(void)
+{
+    close_open_block();
+
+    k_spinlock_key_t key = k_spin_lock(&rec_lock);
+    dl_seq = ram_first;
+    dl_end = next_seq;
+    k_spin_unlock(&rec_lock, key);
+
+    dl_flash = dl_flash_end = 0;
+#if defined(REC_FLASH)
+    if (fa) {
+        dl_flash = flash_tail;
+        dl_flash_end = flash_head;
+        // RAM copies of spilled blocks are skipped
+        key = k_spin_lock(&rec_lock);
+        dl_seq = MAX(dl_seq, spill_seq);
+        k_spin_unlock(&rec_lock, key);
+    }
+#endif
+
+    dl_sent = dl_lost = 0;
+    dl_status = (dl_chan.tx.mtu < REC_SDU_MAX) ? REC_STATUS_MTU : 0xFF;
+    atomic_set(&dl_active, 1);
+    stats.downloads++;
+}
+
+// Append the next block to buf; false once everything was sent
+static bool dl_next_block(struct net_buf *buf)
+{
+    struct rec_block_hdr *h = net_buf_tail(buf);
+
+#if defined(REC_FLASH)
+    while (fa && dl_flash < dl_flash_end) {
+        if (dl_flash < flash_tail) {
+            // Erased by the spill while the dump was running
+            dl_lost += flash_tail - dl_flash;
+            dl_flash = flash_tail;
+            continue;
+        }
+        uint32_t slot = dl_flash++ % flash_slots;
+        if (flash_area_read(fa, slot * REC_BLOCK_SIZE, h, REC_BLOCK_SIZE) ||
+            h->magic != REC_BLOCK_MAGIC || h->len > REC_PAYLOAD_SIZE) {
+            dl_lost++;
+            continue;
+        }
+        net_buf_add(buf, block_bytes(h));
+        return true;
+    }
+#endif
+
+    while (dl_seq < dl_end) {
+        k_spinlock_key_t key = k_spin_lock(&rec_lock);
+        bool present = dl_seq >= ram_first;
+        if (present) {
+            memcpy(h, ram[dl_seq % RAM_BLOCKS], block_bytes(ram_hdr(dl_seq)));
+        }
+        k_spin_unlock(&rec_lock, key);
+
+        dl_seq++;
+        if (!present) {
+            // Overwritten by new playing while the dump was running
+            dl_lost++;
+            continue;
+        }
+        net_buf_add(buf, block_bytes(h));
+        return true;
+    }
+    return false;
+}
+
+static void dl_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    if (!atomic_get(&dl_busy)) {
+        atomic_clear(&dl_active);
+        return;
+    }
+
+    atomic_val_t cmd = atomic_clear(&dl_cmd);
+    if (!atomic_get(&dl_active)) {
+        if (cmd == REC_CMD_CLEAR) {
+            clear_all();
+        } else if (cmd == REC_CMD_DUMP) {
+            dl_start();
+        }
+    }
+
+    while (atomic_get(&dl_active)) {
+        struct net_buf *buf = net_buf_alloc(&dl_pool, K_NO_WAIT);
+        if (!buf) {
+            return;   // Resumed from the sent callback
+        }
+        net_buf_reserve(buf, BT_L2CAP_SDU_CHAN_SEND_RESERVE);
+
+        uint8_t *type = net_buf_add(buf, 1);
+        if (dl_status == 0xFF && dl_next_block(buf)) {
+            *type = REC_SDU_BLOCK;
+            dl_sent++;
+        } else {
+            *type = REC_SDU_END;
+            net_buf_add_u8(buf, dl_status == 0xFF ? REC_STATUS_OK : dl_status);
+            net_buf_add_le32(buf, dl_sent);
+            net_buf_add_le32(buf, dl_lost);
+            atomic_clear(&dl_active);
+            printk("[REC] Download done: %u blocks, %u lost\n", dl_sent, dl_lost);
+        }
+
+        int err = bt_l2cap_chan_send(&dl_chan.chan, buf);
+        if (err < 0) {
+            net_buf_unref(buf);
+            atomic_clear(&dl_active);
+            printk("[REC] Download aborted (err %d)\n", err);
+            return;
+        }
+    }
+}
+
+static int dl_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+    if (buf->len >= 1) {
+        atomic_set(&dl_cmd, buf->data[0]);
+        k_work_submit(&dl_work);
+    }
+    return 0;
+}
+
+static void dl_sent_cb(struct bt_l2cap_chan *chan)
+{
+    k_work_submit(&dl_work);
+}
+
+static void dl_connected(struct bt_l2cap_chan *chan)
+{
+    printk("[REC] Download channel connected\n");
+}
+
+static void dl_disconnected(struct bt_l2cap_chan *chan)
+{
+    atomic_clear(&dl_busy);
+    k_work_submit(&dl_work);   // Ends a dump in progress
+}
+
+static const struct bt_l2cap_chan_ops dl_ops = {
+    .recv = dl_recv,
+    .sent = dl_sent_cb,
+    .connected = dl_connected,
+    .disconnected = dl_disconnected,
+};
+
+static int dl_accept(struct bt_conn *conn, struct bt_l2cap_server *server,
+                     struct bt_l2cap_chan **chan)
+{
+    if (atomic_get(&dl_active) || atomic_set(&dl_busy, 1)) {
+        return -ENOMEM;
+    }
+
+    memset(&dl_chan, 0, sizeof(dl_chan));
+    dl_chan.chan.ops = &dl_ops;
+    dl_chan.rx.mtu = BT_L2CAP_LE_MIN_MTU;   // Commands are one byte
+    *chan = &dl_chan.chan;
+    return 0;
+}
+
+static struct bt_l2cap_server dl_server = {
+    .psm = REC_DOWNLOAD_PSM,
+    .sec_level = BT_SECURITY_L1,
+    .accept = dl_accept,
+};
+
+// ========== API ==========
+
+int recorder_init(void)
+{
+#if defined(REC_FLASH)
+    int err = flash_area_open(FIXED_PARTITION_ID(recording_partition), &fa);
+    if (err) {
+        printk("[REC] Flash area open failed (err %d), RAM only\n", err);
+        fa = NULL;
+        return err;
+    }
+
+    flash_slots = (fa->fa_size / FLASH_PAGE_SIZE) * BLOCKS_PER_PAGE;
+    if (flash_slots < 2 * BLOCKS_PER_PAGE) {
+        printk("[REC] recording_partition too small, RAM only\n");
+        fa = NULL;
+        return -ENOSPC;
+    }
+
+    flash_recover();
+    printk("[REC] Flash log: %u blocks, next block %u (session %u)\n",
+           flash_head - flash_tail, next_seq, session);
+#endif
+    return 0;
+}
+
+int recorder_download_init(void)
+{
+    int err = bt_l2cap_server_register(&dl_server);
+    if (err) {
+        printk("[REC] L2CAP server registration failed (err %d)\n", err);
+    }
+    return err;
+}
+
+int recorder_clear(void)
+{
+    if (atomic_get(&dl_active)) {
+        return -EBUSY;
+    }
+
+    // Runs on the workqueue, after any spill in progress
+    k_work_submit(&clear_work);
+    return 0;
+}
+
+void recorder_get_stats(struct recorder_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&rec_lock);
+    *out = stats;
+    out->session = session;
+    out->ram_blocks = (uint8_t)(next_seq - ram_first);
+    k_spin_unlock(&rec_lock, key);
+
+    out->flash_blocks = 0;
+    out->flash = false;
+#if defined(REC_FLASH)
+    out->flash = (fa != NULL);
+    out->flash_blocks = (uint16_t)(flash_head - flash_tail);
+#endif
+}
@@ -0,0 +1,111 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <zephyr/types.h>
+#include <zephyr/toolchain.h>
+
+// ========== PERFORMANCE RECORDER ==========
+// Every note the keyboard plays is logged, whether or not a central is
+// connected. Events are packed into fixed-size blocks:
+//
+//   [struct rec_block_hdr][events ...]
+//   event = [delta ms, variable-length quantity][status, omitted if
+//            unchanged][data]
+//
+// i.e. the Standard MIDI File event encoding with 1 ms ticks, so a
+// typical note event takes 3 bytes. The delta of a block's first event
+// is relative to start_ms and running status restarts in every block,
+// so each block decodes on its own.
+//
+// Blocks live in a RAM ring (oldest dropped when full). With
+// CONFIG_SUPERR_RECORDER_FLASH they are also spilled to the
+// recording_partition flash area, which survives System OFF and resets.
+// Recordings are downloaded over an L2CAP channel one block per SDU, at
+// whatever rate the link's credits allow; tools/rec2smf.py turns them
+// into a Standard MIDI File.
+
+#define REC_BLOCK_SIZE       256
+#define REC_BLOCK_MAGIC      0xA5
+#define REC_FORMAT_VERSION   1
+#define REC_DOWNLOAD_PSM     0x0083   // LE dynamic PSM
+
+struct rec_block_hdr {
+    uint8_t magic;       // REC_BLOCK_MAGIC (0xFF = erased flash)
+    uint8_t version;     // REC_FORMAT_VERSION
+    uint16_t len;        // Event bytes after the header
+    uint32_t seq;        // Block number, increasing across reboots
+    uint32_t start_ms;   // Uptime of the first event
+    uint16_t session;    // Boot count (uptime restarts with it)
+    uint16_t reserved;
+} __packed;
+
+#define REC_PAYLOAD_SIZE  (REC_BLOCK_SIZE - sizeof(struct rec_block_hdr))
+
+// Download channel: the central sends one command byte, the keyboard
+// answers with REC_SDU_BLOCK SDUs ([type][block]) and one REC_SDU_END
+// ([type][status u8][blocks u32][lost u32], little-endian)
+#define REC_CMD_DUMP     0x01
+#define REC_CMD_CLEAR    0x02
+#define REC_SDU_BLOCK    0x01
+#define REC_SDU_END      0x02
+#define REC_SDU_MAX      (1 + REC_BLOCK_SIZE)
+
+#define REC_STATUS_OK         0
+#define REC_STATUS_MTU        1   // Central's MTU is below REC_SDU_MAX
+#define REC_STATUS_ERROR      2
+
+struct recorder_stats {
+    uint32_t events;
+    uint32_t bytes;          // Encoded event bytes
+    uint32_t blocks;         // Blocks closed since boot
+    uint32_t lost_blocks;    // Dropped from RAM before they were kept
+    uint32_t spilled;        // Blocks written to flash
+    uint32_t flash_errors;
+    uint32_t downloads;
+    uint16_t session;
+    uint8_t ram_blocks;      // Closed blocks in RAM
+    uint16_t flash_blocks;   // Blocks in the flash log
+    bool flash;              // Flash spill available
+};
+
+/**
+ * @brief Recover the flash log, if any
+ *
+ * Call before the scan thread starts.
+ *
+ * @return 0 on success, negative error code otherwise (RAM-only then)
+ */
+int recorder_init(void);
+
+/**
+ * @brief Register the download channel (after bt_enable())
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int recorder_download_init(void);
+
+/**
+ * @brief Log one MIDI message (scan thread)
+ *
+ * Takes a spinlock for a few bytes of encoding; never blocks.
+ */
+void recorder_log(uint8_t status, uint8_t data1, uint8_t data2);
+
+/**
+ * @brief Close the open block and spill everything to flash now
+ *
+ * For use before System OFF. No-op without flash spill.
+ */
+void recorder_sync(void);
+
+/**
+ * @brief Discard the recording (RAM and flash)
+ *
+ * @return 0 on success, -EBUSY while a download is running
+ */
+int recorder_clear(void);
+
+/** @brief Get the recorder counters */
+void recorder_get_stats(struct recorder_stats *out);
+
+#endif // RECORDER_H
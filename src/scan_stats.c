@@ -0,0 +1,186 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/timing/timing.h>
+#include <string.h>
+#include "scan_stats.h"
+
+static struct scan_stats stats;
+static atomic_t stats_seq;          // Odd while the scan thread is updating
+static atomic_t reset_requested;
+
+// Scan-thread private state
+static timing_t pass_start;
+static timing_t last_pass_start;
+static bool have_last_pass;
+static timing_t phase_start;
+static uint32_t pass_phase_us[SCAN_PHASE_COUNT];
+static uint32_t pass_busy_us;
+
+static uint32_t elapsed_us(timing_t *from, timing_t *to)
+{
+    uint64_t cycles = timing_cycles_get(from, to);
+    return (uint32_t)(timing_cycles_to_ns(cycles) / 1000U);
+}
+
+static void stat_add(struct scan_timing_stat *st, uint32_t us, bool first)
+{
+    if (first || us < st->min_us) {
+        st->min_us = us;
+    }
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+    st->sum_us += us;
+}
+
+static int jitter_bucket(uint32_t jitter_us)
+{
+    uint32_t edge = SCAN_JITTER_BASE_US;
+
+    for (int i = 0; i < SCAN_JITTER_BUCKETS - 1; i++) {
+        if (jitter_us < edge) {
+            return i;
+        }
+        edge <<= 1;
+    }
+    return SCAN_JITTER_BUCKETS - 1;
+}
+
+void scan_stats_init(uint32_t period_us)
+{
+    timing_init();
+    timing_start();
+    stats.target_period_us = period_us;
+    stats.miss_slack_us = MAX(k_ticks_to_us_ceil32(1), period_us / 10);
+}
+
+void scan_stats_pass_begin(void)
+{
+    pass_start = timing_counter_get();
+    memset(pass_phase_us, 0, sizeof(pass_phase_us));
+    pass_busy_us = 0;
+}
+
+void scan_stats_phase_begin(enum scan_phase phase)
+{
+    ARG_UNUSED(phase);
+    phase_start = timing_counter_get();
+}
+
+void scan_stats_phase_end(enum scan_phase phase)
+{
+    timing_t now = timing_counter_get();
+    pass_phase_us[phase] += elapsed_us(&phase_start, &now);
+}
+
+void scan_stats_overrun(uint32_t missed_ticks)
+{
+    // Single writer - counted outside the sequence lock like the other
+    // per-pass scratch values; a reader may see it one pass early
+    stats.overruns += missed_ticks;
+}
+
+void scan_stats_busy_wait(uint32_t us)
+{
+    pass_busy_us += us;
+}
+
+void scan_stats_focus_sample(void)
+{
+    stats.focus_samples++;
+}
+
+void scan_stats_focus_strike(void)
+{
+    stats.focus_strikes++;
+}
+
+void scan_stats_unsettled_read(void)
+{
+    stats.unsettled_reads++;
+}
+
+void scan_stats_set_settle(const uint8_t *m1_us, const uint8_t *m2_us)
+{
+    atomic_inc(&stats_seq);
+    memcpy(stats.m1_settle_us, m1_us, sizeof(stats.m1_settle_us));
+    memcpy(stats.m2_settle_us, m2_us, sizeof(stats.m2_settle_us));
+    atomic_inc(&stats_seq);
+}
+
+void scan_stats_pass_end(void)
+{
+    timing_t now = timing_counter_get();
+    uint32_t duration = elapsed_us(&pass_start, &now);
+    uint32_t period = 0;
+    bool has_period = have_last_pass;
+
+    if (has_period) {
+        period = elapsed_us(&last_pass_start, &pass_start);
+    }
+    last_pass_start = pass_start;
+    have_last_pass = true;
+
+    atomic_inc(&stats_seq);
+
+    if (atomic_cas(&reset_requested, 1, 0)) {
+        uint32_t target = stats.target_period_us;
+        uint32_t slack = stats.miss_slack_us;
+        uint8_t m1_settle[NUM_ROWS], m2_settle[NUM_ROWS];
+
+        memcpy(m1_settle, stats.m1_settle_us, sizeof(m1_settle));
+        memcpy(m2_settle, stats.m2_settle_us, sizeof(m2_settle));
+        memset(&stats, 0, sizeof(stats));
+        stats.target_period_us = target;
+        stats.miss_slack_us = slack;
+        memcpy(stats.m1_settle_us, m1_settle, sizeof(m1_settle));
+        memcpy(stats.m2_settle_us, m2_settle, sizeof(m2_settle));
+    }
+
+    bool first = (stats.passes == 0);
+    stats.passes++;
+    stat_add(&stats.duration, duration, first);
+    stats.busy_wait_us += pass_busy_us;
+
+    for (int i = 0; i < SCAN_PHASE_COUNT; i++) {
+        stats.phase_us[i] += pass_phase_us[i];
+        if (pass_phase_us[i] > stats.phase_max_us[i]) {
+            stats.phase_max_us[i] = pass_phase_us[i];
+        }
+    }
+
+    if (has_period) {
+        bool first_period = (stats.periods == 0);
+        uint32_t target = stats.target_period_us;
+        uint32_t jitter = (period > target) ? period - target : target - period;
+
+        stat_add(&stats.period, period, first_period);
+        stats.periods++;
+        stats.jitter_hist[jitter_bucket(jitter)]++;
+        if (period > target + stats.miss_slack_us) {
+            stats.deadline_misses++;
+        }
+    }
+
+    atomic_inc(&stats_seq);
+}
+
+void scan_stats_get(struct scan_stats *out)
+{
+    atomic_val_t before, after;
+
+    do {
+        before = atomic_get(&stats_seq);
+        if (before & 1) {
+            k_yield();
+            continue;
+        }
+        memcpy(out, &stats, sizeof(*out));
+        after = atomic_get(&stats_seq);
+    } while ((before & 1) || before != after);
+}
+
+void scan_stats_reset(void)
+{
+    atomic_set(&reset_requested, 1);
+}
@@ -0,0 +1,109 @@
+#ifndef SCAN_STATS_H
+#define SCAN_STATS_H
+
+#include <zephyr/types.h>
+#include "keyboard.h"
+
+// ========== SCAN-LOOP TIMING TELEMETRY ==========
+// The scan thread is the only writer. It stamps each pass with the CPU
+// cycle counter (timing API) and accumulates duration, period, busy-wait
+// share, a per-phase breakdown and a jitter histogram. Readers (shell)
+// take a consistent copy through a sequence counter, so reading never
+// blocks or slows the scan thread.
+
+enum scan_phase {
+    SCAN_PHASE_M1,        // Matrix 1 row phases (drive, settle, read)
+    SCAN_PHASE_M2,        // Matrix 2 row phases
+    SCAN_PHASE_FOCUS,     // Extra M2 samples of keys mid-stroke
+    SCAN_PHASE_NOTE_OFF,  // Note-off sweep + housekeeping
+    SCAN_PHASE_COUNT
+};
+
+// Jitter = |period - target period|, log2 buckets starting at 25 us:
+// <25, <50, <100, <200, <400, <800, <1600, >=1600
+#define SCAN_JITTER_BUCKETS   8
+#define SCAN_JITTER_BASE_US   25
+
+struct scan_timing_stat {
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+};
+
+struct scan_stats {
+    uint32_t passes;
+    uint32_t periods;                           // Period samples (passes - 1)
+    uint32_t target_period_us;                  // Real timer period
+    uint32_t miss_slack_us;                     // Lateness tolerated as on time
+    uint32_t deadline_misses;                   // Period > target + slack
+    uint32_t overruns;                          // Scan timer ticks skipped
+    uint32_t unsettled_reads;                   // Column double-read mismatches
+    uint32_t focus_samples;                     // Focused M2 row samples
+    uint32_t focus_strikes;                     // M2 contacts caught by them
+    struct scan_timing_stat duration;           // Start -> end of one pass
+    struct scan_timing_stat period;             // Start -> start
+    uint64_t busy_wait_us;                      // Total requested settle time
+    uint64_t phase_us[SCAN_PHASE_COUNT];        // Total time per phase
+    uint32_t phase_max_us[SCAN_PHASE_COUNT];    // Worst single pass per phase
+    uint32_t jitter_hist[SCAN_JITTER_BUCKETS];
+    uint8_t m1_settle_us[NUM_ROWS];             // Current per-row settle delays
+    uint8_t m2_settle_us[NUM_ROWS];             // (kept across reset)
+};
+
+/**
+ * @brief Start the cycle counter (call once before the scan thread starts)
+ *
+ * A period counts as a deadline miss only when it exceeds the target by
+ * more than one kernel tick or 10 % of it, whichever is larger: wake-up
+ * latency moves single pass starts by about that much without the scan
+ * falling behind (that shows up as overruns).
+ *
+ * @param period_us Period the scan timer really runs at (whole ticks)
+ */
+void scan_stats_init(uint32_t period_us);
+
+/** @brief Mark the start of a scan pass (scan thread only) */
+void scan_stats_pass_begin(void);
+
+/** @brief Mark the end of a scan pass (scan thread only) */
+void scan_stats_pass_end(void);
+
+/** @brief Start timing a phase (scan thread only) */
+void scan_stats_phase_begin(enum scan_phase phase);
+
+/** @brief Stop timing the phase started last (scan thread only) */
+void scan_stats_phase_end(enum scan_phase phase);
+
+/** @brief Record scan timer ticks that were skipped (scan thread only) */
+void scan_stats_overrun(uint32_t missed_ticks);
+
+/** @brief Account a k_busy_wait() in the current pass (scan thread only) */
+void scan_stats_busy_wait(uint32_t us);
+
+/** @brief Count one focused M2 row sample (scan thread only) */
+void scan_stats_focus_sample(void);
+
+/** @brief Count an M2 contact caught by a focused sample (scan thread only) */
+void scan_stats_focus_strike(void);
+
+/** @brief Count a column read that changed on re-read (scan thread only) */
+void scan_stats_unsettled_read(void);
+
+/**
+ * @brief Publish the current per-row settle delays
+ *
+ * Called at boot and whenever a row's delay is measured or lengthened.
+ */
+void scan_stats_set_settle(const uint8_t *m1_us, const uint8_t *m2_us);
+
+/**
+ * @brief Get a consistent copy of the statistics (any thread, lock-free)
+ */
+void scan_stats_get(struct scan_stats *out);
+
+/**
+ * @brief Clear the statistics (applied by the scan thread on its next pass)
+ */
+void scan_stats_reset(void);
+
+#endif // SCAN_STATS_H
@@ -0,0 +1,237 @@
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "scheduler.h"
+#include "ble_midi_service.h"
+#include "recorder.h"
+
+enum sched_type {
+    SCHED_MIDI,
+    SCHED_CALL,
+};
+
+struct sched_event {
+    int64_t due;
+    uint32_t order;      // Post order: equal due times fire FIFO
+    uint8_t type;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    sched_fn fn;
+};
+
+static struct sched_event heap[SCHED_MAX_EVENTS];
+static int heap_len;
+static uint32_t post_order;
+static struct k_spinlock sched_lock;
+static struct sched_stats stats;
+
+static void sched_timer_expiry(struct k_timer *timer);
+static K_TIMER_DEFINE(sched_timer, sched_timer_expiry, NULL);
+
+// ========== MIN-HEAP ==========
+// Call with sched_lock held
+
+static inline bool before(const struct sched_event *a, const struct sched_event *b)
+{
+    return a->due < b->due || (a->due == b->due && (int32_t)(a->order - b->order) < 0);
+}
+
+static void sift_up(int i)
+{
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!before(&heap[i], &heap[parent])) {
+            break;
+        }
+        struct sched_event tmp = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static void sift_down(int i)
+{
+    for (;;) {
+        int l = 2 * i + 1;
+        int r = l + 1;
+        int min = i;
+
+        if (l < heap_len && before(&heap[l], &heap[min])) {
+            min = l;
+        }
+        if (r < heap_len && before(&heap[r], &heap[min])) {
+            min = r;
+        }
+        if (min == i) {
+            break;
+        }
+        struct sched_event tmp = heap[i];
+        heap[i] = heap[min];
+        heap[min] = tmp;
+        i = min;
+    }
+}
+
+static void remove_at(int i)
+{
+    heap[i] = heap[--heap_len];
+    if (i < heap_len) {
+        sift_down(i);
+        sift_up(i);
+    }
+}
+
+// Arm the timer for the earliest event
+static void rearm(void)
+{
+    if (heap_len) {
+        k_timer_start(&sched_timer, K_TIMEOUT_ABS_TICKS(heap[0].due), K_NO_WAIT);
+    } else {
+        k_timer_stop(&sched_timer);
+    }
+}
+
+static int post(const struct sched_event *ev)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    if (heap_len == SCHED_MAX_EVENTS) {
+        stats.dropped++;
+        k_spin_unlock(&sched_lock, key);
+        return -ENOMEM;
+    }
+
+    heap[heap_len] = *ev;
+    heap[heap_len].order = post_order++;
+    sift_up(heap_len++);
+    if (heap_len > stats.max_depth) {
+        stats.max_depth = heap_len;
+    }
+
+    // Only a new earliest event moves the timer
+    if (heap[0].order == post_order - 1) {
+        rearm();
+    }
+    k_spin_unlock(&sched_lock, key);
+    return 0;
+}
+
+// ========== DISPATCH ==========
+
+static void record_lateness(int64_t late_ticks)
+{
+    uint32_t us = (uint32_t)k_ticks_to_us_floor64(late_ticks > 0 ? late_ticks : 0);
+    uint32_t edge = SCHED_JITTER_BASE_US;
+    int b = 0;
+
+    while (b < SCHED_JITTER_BUCKETS - 1 && us >= edge) {
+        edge <<= 1;
+        b++;
+    }
+    stats.jitter_hist[b]++;
+    stats.sum_late_us += us;
+    if (us > stats.max_late_us) {
+        stats.max_late_us = us;
+    }
+    stats.dispatched++;
+}
+
+static void sched_timer_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    for (;;) {
+        k_spinlock_key_t key = k_spin_lock(&sched_lock);
+        int64_t now = k_uptime_ticks();
+
+        if (!heap_len || heap[0].due > now) {
+            rearm();
+            k_spin_unlock(&sched_lock, key);
+            return;
+        }
+
+        struct sched_event ev = heap[0];
+        remove_at(0);
+        record_lateness(now - ev.due);
+        k_spin_unlock(&sched_lock, key);
+
+        // Outside the lock: handlers post follow-up events
+        if (ev.type == SCHED_MIDI) {
+            // Same path as played notes (emit_note() in main.c)
+            recorder_log(ev.status, ev.data1, ev.data2);
+            ble_midi_send_event(ev.status, ev.data1, ev.data2, 0);
+        } else {
+            ev.fn(ev.due);
+        }
+    }
+}
+
+// ========== API ==========
+
+int64_t scheduler_now(void)
+{
+    return k_uptime_ticks();
+}
+
+int scheduler_post_midi(int64_t due, uint8_t status, uint8_t data1, uint8_t data2)
+{
+    struct sched_event ev = {
+        .due = due,
+        .type = SCHED_MIDI,
+        .status = status,
+        .data1 = data1,
+        .data2 = data2,
+    };
+    return post(&ev);
+}
+
+int scheduler_post_call(int64_t due, sched_fn fn)
+{
+    struct sched_event ev = {
+        .due = due,
+        .type = SCHED_CALL,
+        .fn = fn,
+    };
+    return post(&ev);
+}
+
+int scheduler_cancel_call(sched_fn fn)
+{
+    int removed = 0;
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    // Filter, then rebuild the heap bottom-up
+    int n = 0;
+    for (int i = 0; i < heap_len; i++) {
+        if (heap[i].type == SCHED_CALL && heap[i].fn == fn) {
+            removed++;
+        } else {
+            heap[n++] = heap[i];
+        }
+    }
+    heap_len = n;
+    if (removed) {
+        for (int i = heap_len / 2 - 1; i >= 0; i--) {
+            sift_down(i);
+        }
+        rearm();
+    }
+    k_spin_unlock(&sched_lock, key);
+    return removed;
+}
+
+void scheduler_get_stats(struct sched_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    *out = stats;
+    out->depth = heap_len;
+    k_spin_unlock(&sched_lock, key);
+}
+
+void scheduler_reset_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    memset(&stats, 0, sizeof(stats));
+    k_spin_unlock(&sched_lock, key);
+}
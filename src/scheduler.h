@@ -0,0 +1,68 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <zephyr/types.h>
+
+// ========== MIDI EVENT SCHEDULER ==========
+// Future events sit in a bounded min-heap keyed by due time (kernel
+// ticks). One k_timer is armed for the earliest event with an absolute
+// timeout, so it fires on the system timer's tick (30.5 us on nRF5340)
+// rather than on the scan grid. Due events are dispatched straight from the
+// timer callback: MIDI messages are logged and put on the BLE MIDI TX
+// queue (both non-blocking, ISR-safe), calls run the registered function.
+// Nothing here runs on, or waits for, the scan thread.
+//
+// Lateness (fire time - due time) of every dispatched event is kept as a
+// histogram for "superr sched".
+
+#define SCHED_MAX_EVENTS      64
+#define SCHED_JITTER_BUCKETS  8     // <1 tick, <2, <4 ... doubling, last open
+#define SCHED_JITTER_BASE_US  31    // One 32768 Hz tick
+
+/** Call-event handler; runs in timer (ISR) context */
+typedef void (*sched_fn)(int64_t due);
+
+struct sched_stats {
+    uint32_t dispatched;
+    uint32_t dropped;        // Heap full
+    uint32_t max_late_us;
+    uint64_t sum_late_us;
+    uint32_t jitter_hist[SCHED_JITTER_BUCKETS];
+    uint8_t depth;           // Events pending now
+    uint8_t max_depth;
+};
+
+/**
+ * @brief Current time on the scheduler clock (kernel ticks)
+ */
+int64_t scheduler_now(void);
+
+/**
+ * @brief Schedule a MIDI message
+ *
+ * @param due Time to send it (scheduler_now() based); past times fire now
+ * @return 0 on success, -ENOMEM if the heap is full
+ */
+int scheduler_post_midi(int64_t due, uint8_t status, uint8_t data1, uint8_t data2);
+
+/**
+ * @brief Schedule a call to fn(due)
+ *
+ * @return 0 on success, -ENOMEM if the heap is full
+ */
+int scheduler_post_call(int64_t due, sched_fn fn);
+
+/**
+ * @brief Remove every pending call to fn
+ *
+ * @return Number of calls removed
+ */
+int scheduler_cancel_call(sched_fn fn);
+
+/** @brief Get the dispatch counters and lateness histogram */
+void scheduler_get_stats(struct sched_stats *out);
+
+/** @brief Clear the counters */
+void scheduler_reset_stats(void);
+
+#endif // SCHEDULER_H
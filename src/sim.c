@@ -0,0 +1,421 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/sys/printk.h>
+#include <stdlib.h>
+#include "cmdline.h"
+#include "posix_native_task.h"
+#include "posix_board_if.h"
+#include "sim.h"
+#include "sim_host.h"
+#include "keyboard.h"
+#include "scan_stats.h"
+
+#define SIM_LINE_MAX 128
+
+static const struct gpio_dt_spec cols[NUM_COLS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, col_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
+static const struct gpio_dt_spec m1_rows[NUM_ROWS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, m1_row_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
+static const struct gpio_dt_spec m2_rows[NUM_ROWS] = {
+    DT_FOREACH_PROP_ELEM_SEP(MATRIX_NODE, m2_row_gpios, GPIO_DT_SPEC_GET_BY_IDX, (,))
+};
+
+// Command line
+static char *keys_path;
+static char *midi_path;
+static char *led_path;
+static uint32_t tail_ms = 1000;
+static uint32_t max_key_ns = 2000;
+
+static void *keys_file;
+static void *midi_file;
+static void *led_file;
+
+// Replayed contact states: closed contacts per row, bit per column
+static uint32_t m1_closed[NUM_ROWS];
+static uint32_t m2_closed[NUM_ROWS];
+
+struct contact_edge {
+    uint64_t time_us;
+    uint16_t key;
+    bool m2;
+    bool closed;
+};
+
+static struct contact_edge next_edge;
+static bool edge_pending;       // next_edge holds the next edge of the trace
+static uint32_t trace_line;
+
+static uint32_t edges;
+static uint32_t bad_lines;
+static uint32_t midi_events;
+static uint32_t led_frames;
+static struct k_spinlock capture_lock;
+
+// Scan work (scan thread only): host CPU time of the passes, less the
+// settle waits and the contact emulation inside them
+static unsigned long long pass_start_ns;
+static unsigned long long pass_excluded_ns;
+static unsigned long long work_ns;
+static uint32_t work_passes;
+
+static void finish_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(finish_work, finish_work_handler);
+
+static inline uint64_t now_us(void)
+{
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+}
+
+// ========== CONTACT TRACE ==========
+static char *skip_blanks(char *p)
+{
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    return p;
+}
+
+// "<time_us> <key> <m1|m2> <0|1>", optionally followed by a comment
+static bool parse_edge(char *line, struct contact_edge *e)
+{
+    char *end;
+
+    e->time_us = strtoull(line, &end, 10);
+    if (end == line) {
+        return false;
+    }
+
+    char *p = end;
+    unsigned long key = strtoul(p, &end, 10);
+    if (end == p || key >= NUM_KEYS) {
+        return false;
+    }
+
+    p = skip_blanks(end);
+    if (p[0] != 'm' || (p[1] != '1' && p[1] != '2') || (p[2] != ' ' && p[2] != '\t')) {
+        return false;
+    }
+    e->m2 = (p[1] == '2');
+
+    p += 2;
+    unsigned long closed = strtoul(p, &end, 10);
+    if (end == p || closed > 1) {
+        return false;
+    }
+
+    p = skip_blanks(end);
+    if (*p != '\0' && *p != '#') {
+        return false;
+    }
+
+    e->key = key;
+    e->closed = closed;
+    return true;
+}
+
+// Read ahead to the next edge; false at the end of the trace
+static bool read_edge(struct contact_edge *e)
+{
+    char line[SIM_LINE_MAX];
+
+    while (sim_host_read_line(keys_file, line, sizeof(line)) >= 0) {
+        char *p = skip_blanks(line);
+
+        trace_line++;
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if (parse_edge(p, e)) {
+            return true;
+        }
+        printk("[SIM] %s:%u: not a contact edge, skipped\n", keys_path, trace_line);
+        bad_lines++;
+    }
+    return false;
+}
+
+static void apply_edge(const struct contact_edge *e)
+{
+    uint32_t *closed = e->m2 ? m2_closed : m1_closed;
+    int row = e->key / NUM_COLS;
+    uint32_t bit = BIT(e->key % NUM_COLS);
+
+    if (e->closed) {
+        closed[row] |= bit;
+    } else {
+        closed[row] &= ~bit;
+    }
+    edges++;
+}
+
+// Rows are scanned by driving them LOW
+static bool row_driven(const struct gpio_dt_spec *row)
+{
+    return gpio_emul_output_get(row->port, row->pin) == 0;
+}
+
+static void matrix_sample(void)
+{
+    uint64_t now = now_us();
+    uint32_t pressed = 0;
+    gpio_port_pins_t pins = 0;
+    gpio_port_value_t levels = 0;
+
+    // Edges out of time order are applied as soon as they are read
+    while (edge_pending && next_edge.time_us <= now) {
+        apply_edge(&next_edge);
+        edge_pending = read_edge(&next_edge);
+        if (!edge_pending) {
+            k_work_schedule(&finish_work, K_MSEC(tail_ms));
+        }
+    }
+
+    for (int row = 0; row < NUM_ROWS; row++) {
+        if (row_driven(&m1_rows[row])) {
+            pressed |= m1_closed[row];
+        }
+        if (row_driven(&m2_rows[row])) {
+            pressed |= m2_closed[row];
+        }
+    }
+
+    // Pulled up unless a closed contact (and its diode) connects the
+    // column to a driven row
+    for (int col = 0; col < NUM_COLS; col++) {
+        pins |= BIT(cols[col].pin);
+        if (!(pressed & BIT(col))) {
+            levels |= BIT(cols[col].pin);
+        }
+    }
+    gpio_emul_input_set_masked(cols[0].port, pins, levels);
+}
+
+void sim_matrix_sample(void)
+{
+    unsigned long long start_ns = sim_host_thread_ns();
+
+    matrix_sample();
+    pass_excluded_ns += sim_host_thread_ns() - start_ns;
+}
+
+// ========== SCAN WORK ==========
+void sim_settle_wait(uint32_t us)
+{
+    unsigned long long start_ns = sim_host_thread_ns();
+
+    k_busy_wait(us);
+    pass_excluded_ns += sim_host_thread_ns() - start_ns;
+}
+
+void sim_scan_pass_begin(void)
+{
+    pass_excluded_ns = 0;
+    pass_start_ns = sim_host_thread_ns();
+}
+
+void sim_scan_pass_end(void)
+{
+    work_ns += sim_host_thread_ns() - pass_start_ns - pass_excluded_ns;
+    work_passes++;
+}
+
+// ========== CAPTURE ==========
+void sim_midi_capture(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    char line[48];
+
+    if (!midi_file) {
+        return;
+    }
+
+    int len = snprintk(line, sizeof(line), "%llu %02x %u %u\n",
+                       (unsigned long long)now_us(), status, data1, data2);
+    k_spinlock_key_t key = k_spin_lock(&capture_lock);
+
+    sim_host_write(midi_file, line, len);
+    midi_events++;
+    k_spin_unlock(&capture_lock, key);
+}
+
+void sim_led_capture(const struct led_rgb *pixels, size_t count)
+{
+    char buf[24];
+
+    if (!led_file) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&capture_lock);
+
+    sim_host_write(led_file, buf, snprintk(buf, sizeof(buf), "%llu",
+                                           (unsigned long long)now_us()));
+    for (size_t i = 0; i < count; i++) {
+        sim_host_write(led_file, buf, snprintk(buf, sizeof(buf), " %02x%02x%02x",
+                                               pixels[i].r, pixels[i].g, pixels[i].b));
+    }
+    sim_host_write(led_file, "\n", 1);
+    led_frames++;
+    k_spin_unlock(&capture_lock, key);
+}
+
+// ========== RUN CONTROL ==========
+static void close_file(void **file)
+{
+    if (*file) {
+        sim_host_close(*file);
+        *file = NULL;
+    }
+}
+
+// In simulated time a pass takes exactly its settle waits, so the first
+// check is that the matrix geometry and settle floors fit the scan period.
+// The scan work per key shows what the rest of the pass costs.
+static void report_scan(void)
+{
+    struct scan_stats st;
+
+    scan_stats_get(&st);
+    printk("[SIM] Scan: %u passes, longest %u us of %u us, %u overruns, "
+           "%u deadline misses\n",
+           st.passes, st.duration.max_us, st.target_period_us, st.overruns,
+           st.deadline_misses);
+    printk("[SIM] Focused M2: %u samples, %u strikes caught\n",
+           st.focus_samples, st.focus_strikes);
+    if (st.passes && st.duration.max_us < st.target_period_us && st.overruns == 0) {
+        printk("[SIM] Scan pass fits the period\n");
+    } else {
+        printk("[SIM] Scan pass does NOT fit the period\n");
+    }
+
+    if (!work_passes || !st.passes) {
+        return;
+    }
+
+    uint32_t pass_ns = (uint32_t)(work_ns / work_passes);
+    uint32_t key_ns = pass_ns / NUM_KEYS;
+    uint32_t wait_key_ns = (uint32_t)(st.busy_wait_us * 1000U / st.passes / NUM_KEYS);
+
+    printk("[SIM] Scan work: %u ns per pass, %u ns per key (%u keys); "
+           "settle waits %u ns per key\n",
+           pass_ns, key_ns, NUM_KEYS, wait_key_ns);
+    if (key_ns <= max_key_ns) {
+        printk("[SIM] Scan work per key is within %u ns\n", max_key_ns);
+    } else {
+        printk("[SIM] Scan work per key EXCEEDS %u ns\n", max_key_ns);
+    }
+}
+
+static FUNC_NORETURN void sim_finish(const char *why)
+{
+    printk("[SIM] %s at %llu us: %u contact edges, %u bad trace lines, "
+           "%u MIDI messages, %u LED frames\n",
+           why, (unsigned long long)now_us(), edges, bad_lines, midi_events, led_frames);
+    report_scan();
+
+    k_spinlock_key_t key = k_spin_lock(&capture_lock);
+
+    close_file(&keys_file);
+    close_file(&midi_file);
+    close_file(&led_file);
+    k_spin_unlock(&capture_lock, key);
+
+    posix_exit(0);
+    CODE_UNREACHABLE;
+}
+
+static void finish_work_handler(struct k_work *work)
+{
+    sim_finish("Replay done");
+}
+
+FUNC_NORETURN void sim_power_off(void)
+{
+    sim_finish("System OFF");
+}
+
+static void *open_or_exit(const char *path, int write)
+{
+    void *file = sim_host_open(path, write);
+
+    if (!file) {
+        printk("[SIM] Cannot open %s\n", path);
+        posix_exit(1);
+    }
+    return file;
+}
+
+static int sim_init(void)
+{
+    if (midi_path) {
+        midi_file = open_or_exit(midi_path, 1);
+    }
+    if (led_path) {
+        led_file = open_or_exit(led_path, 1);
+    }
+    if (keys_path) {
+        keys_file = open_or_exit(keys_path, 0);
+        edge_pending = read_edge(&next_edge);
+        if (!edge_pending) {
+            k_work_schedule(&finish_work, K_MSEC(tail_ms));
+        }
+        printk("[SIM] Replaying %s (tail %u ms)\n", keys_path, tail_ms);
+    } else {
+        printk("[SIM] No contact trace (--keys), all keys stay up\n");
+    }
+    return 0;
+}
+
+SYS_INIT(sim_init, APPLICATION, 0);
+
+static void sim_options(void)
+{
+    static struct args_struct_t sim_args[] = {
+        {
+            .option = "keys",
+            .name = "file",
+            .type = 's',
+            .dest = (void *)&keys_path,
+            .descript = "Contact trace to replay on the key matrix",
+        },
+        {
+            .option = "midi-out",
+            .name = "file",
+            .type = 's',
+            .dest = (void *)&midi_path,
+            .descript = "Write every MIDI message sent to this file",
+        },
+        {
+            .option = "led-out",
+            .name = "file",
+            .type = 's',
+            .dest = (void *)&led_path,
+            .descript = "Write every changed LED strip frame to this file",
+        },
+        {
+            .option = "tail-ms",
+            .name = "ms",
+            .type = 'u',
+            .dest = (void *)&tail_ms,
+            .descript = "Keep running this long after the last contact edge "
+                        "(default 1000)",
+        },
+        {
+            .option = "max-key-ns",
+            .name = "ns",
+            .type = 'u',
+            .dest = (void *)&max_key_ns,
+            .descript = "Scan work per key (host CPU time) the final report "
+                        "accepts (default 2000)",
+        },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(sim_args);
+}
+
+NATIVE_TASK(sim_options, PRE_BOOT_1, 1);
@@ -0,0 +1,69 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <zephyr/types.h>
+#include <zephyr/toolchain.h>
+#include <zephyr/drivers/led_strip.h>
+
+// ========== NATIVE_SIM REPLAY ==========
+// CONFIG_SUPERR_SIM builds the firmware for native_sim with the keyboard
+// matrix on the emulated GPIO controller. The contact states come
+// from a trace file, and what the firmware sends is written to files:
+//   --keys=<file>      contact trace to replay (see "Trace format" below)
+//   --midi-out=<file>  every MIDI message handed to the BLE send path
+//   --led-out=<file>   every LED strip frame that differs from the last
+//   --tail-ms=<ms>     run time after the last contact edge (default 1000)
+//   --max-key-ns=<ns>  scan work per key allowed (default 2000, see below)
+// With a trace the run ends by itself after its tail; without one it runs
+// until -stop_at=<s> or Ctrl-C. At the end the longest scan pass is
+// reported against the scan period ("Scan pass fits the period"), with
+// the number of focused M2 samples, and the scan work per key against
+// --max-key-ns ("Scan work per key is within ..."). Scan work is the host
+// CPU time of a pass without its settle waits and the contact emulation:
+// what the scan code itself costs, which the simulated pass time (only
+// the waits) cannot show. It is a regression bound across matrix sizes,
+// not a target budget.
+// --keys=/dev/null with a --tail-ms runs an idle keyboard for that long.
+//
+// Time is simulated time since boot in microseconds (the kernel cycle
+// counter), so a replay is deterministic and, with
+// NATIVE_SIM_SLOWDOWN_TO_REAL_TIME off, runs as fast as the host allows.
+//
+// Trace format, one contact edge per line, in time order:
+//   <time_us> <key> <m1|m2> <0|1>
+// key is the matrix key index (row * columns + column), 1 = closed. Blank
+// lines and lines starting with '#' are ignored. tools/keytrace.py writes
+// synthetic traces.
+//
+// Output formats, one line per event:
+//   MIDI: <time_us> <status hex> <data1> <data2>
+//   LED:  <time_us> <rrggbb> ... (one per pixel, in strip order)
+
+/**
+ * @brief Update the emulated column inputs
+ *
+ * Applies the trace edges due by now and pulls each column LOW that sees
+ * a closed contact on a row currently driven LOW. Called before every
+ * column read.
+ */
+void sim_matrix_sample(void);
+
+/** @brief Settle delay of a row phase (k_busy_wait, not counted as scan work) */
+void sim_settle_wait(uint32_t us);
+
+/** @brief Start of a scan pass, for the scan work time */
+void sim_scan_pass_begin(void);
+
+/** @brief End of a scan pass, for the scan work time */
+void sim_scan_pass_end(void);
+
+/** @brief Capture a MIDI message the firmware sends */
+void sim_midi_capture(uint8_t status, uint8_t data1, uint8_t data2);
+
+/** @brief Capture an LED strip frame */
+void sim_led_capture(const struct led_rgb *pixels, size_t count);
+
+/** @brief System OFF in the simulator: close the captures and exit */
+FUNC_NORETURN void sim_power_off(void);
+
+#endif // SIM_H
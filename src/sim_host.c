@@ -0,0 +1,46 @@
+// Runner side of the native_sim replay build (see sim_host.h): plain host
+// stdio, linked into the native simulator instead of the Zephyr image.
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim_host.h"
+
+void *sim_host_open(const char *path, int write)
+{
+    return fopen(path, write ? "w" : "r");
+}
+
+int sim_host_read_line(void *file, char *buf, int size)
+{
+    if (!fgets(buf, size, file)) {
+        return -1;
+    }
+
+    int len = strcspn(buf, "\r\n");
+    if (buf[len] == '\0' && len == size - 1) {
+        // Truncated: drop the rest of the line
+        int c;
+        while ((c = fgetc(file)) != EOF && c != '\n') {
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+void sim_host_write(void *file, const char *buf, int len)
+{
+    fwrite(buf, 1, len, file);
+}
+
+void sim_host_close(void *file)
+{
+    fclose(file);
+}
+
+unsigned long long sim_host_thread_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
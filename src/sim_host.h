@@ -0,0 +1,37 @@
+#ifndef SIM_HOST_H
+#define SIM_HOST_H
+
+// ========== NATIVE_SIM HOST FILES ==========
+// Host file access (and the host CPU clock) for the native_sim replay build. These functions are
+// compiled into the native simulator runner against the host C library
+// (src/sim_host.c), not into the Zephyr image, so this header only uses
+// plain C types and may be included from both sides.
+
+/**
+ * @brief Open a host file
+ *
+ * @param path  Host path
+ * @param write Non-zero to create/truncate for writing, zero to read
+ * @return Handle, or NULL if the file cannot be opened
+ */
+void *sim_host_open(const char *path, int write);
+
+/**
+ * @brief Read one line (without the line ending)
+ *
+ * Lines longer than the buffer are truncated.
+ *
+ * @return Length of the line, or -1 at end of file
+ */
+int sim_host_read_line(void *file, char *buf, int size);
+
+/** @brief Append len bytes to a file opened for writing */
+void sim_host_write(void *file, const char *buf, int len);
+
+/** @brief Flush and close a file */
+void sim_host_close(void *file);
+
+/** @brief CPU time the calling host thread has used, in nanoseconds */
+unsigned long long sim_host_thread_ns(void);
+
+#endif // SIM_HOST_H
@@ -0,0 +1,524 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+#include "latency_stats.h"
+#include "scan_stats.h"
+#include "ble_midi_service.h"
+#include "ble_adv.h"
+#include "midi_ble_rx.h"
+#include "led_stream.h"
+#include "recorder.h"
+#include "scheduler.h"
+#include "arp.h"
+#include "midi_clock.h"
+#include "pedals.h"
+#include "kbd_state.h"
+#include "led_stats.h"
+#include "keyboard.h"
+
+// ========== SHELL: superr ==========
+// Runtime diagnostics over the UART shell. Commands only read counters
+// that the firmware keeps anyway - nothing here blocks the scan thread for
+// more than a few stores: whatever it writes is read through sequence
+// counters, plain atomics, or (the key state, which cooperative threads
+// also read) a short spinlock.
+
+static const char *const span_names[LATENCY_SPAN_COUNT] = {
+    [LATENCY_QUEUE]  = "capture->queue",
+    [LATENCY_NOTIFY] = "capture->notify",
+};
+
+// superr latency [reset]
+static int cmd_latency(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        latency_reset();
+        shell_print(sh, "Latency histograms cleared");
+        return 0;
+    }
+
+    for (int span = 0; span < LATENCY_SPAN_COUNT; span++) {
+        struct latency_summary sum;
+        uint32_t buckets[LATENCY_NUM_BUCKETS + 1];
+
+        latency_get_summary(span, &sum);
+        latency_get_histogram(span, buckets);
+
+        shell_print(sh, "%s: n=%u p50=%uus p99=%uus max=%uus",
+                    span_names[span], sum.count, sum.p50_us, sum.p99_us, sum.max_us);
+        for (int i = 0; i <= LATENCY_NUM_BUCKETS; i++) {
+            if (buckets[i] == 0) {
+                continue;
+            }
+            if (i == LATENCY_NUM_BUCKETS) {
+                shell_print(sh, "   >=%5uus  %u", i * LATENCY_BUCKET_US, buckets[i]);
+            } else {
+                shell_print(sh, "   <%6uus  %u", (i + 1) * LATENCY_BUCKET_US, buckets[i]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static const char *const scan_phase_names[SCAN_PHASE_COUNT] = {
+    [SCAN_PHASE_M1]       = "M1 rows",
+    [SCAN_PHASE_M2]       = "M2 rows",
+    [SCAN_PHASE_FOCUS]    = "focused M2",
+    [SCAN_PHASE_NOTE_OFF] = "note-off sweep",
+};
+
+// superr scan [reset]
+static int cmd_scan(const struct shell *sh, size_t argc, char **argv)
+{
+    struct scan_stats st;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        scan_stats_reset();
+        shell_print(sh, "Scan statistics cleared");
+        return 0;
+    }
+
+    scan_stats_get(&st);
+    if (st.passes == 0) {
+        shell_print(sh, "No scan passes yet");
+        return 0;
+    }
+
+    uint32_t mean_duration = (uint32_t)(st.duration.sum_us / st.passes);
+    shell_print(sh, "passes=%u period=%uus deadline misses=%u (>+%uus) overruns=%u",
+                st.passes, st.target_period_us, st.deadline_misses, st.miss_slack_us,
+                st.overruns);
+    shell_print(sh, "duration: min=%uus mean=%uus max=%uus (busy-wait %u%%)",
+                st.duration.min_us, mean_duration, st.duration.max_us,
+                (uint32_t)(st.duration.sum_us ? st.busy_wait_us * 100 / st.duration.sum_us : 0));
+    if (st.periods) {
+        uint32_t mean_period = (uint32_t)(st.period.sum_us / st.periods);
+        shell_print(sh, "period:   min=%uus mean=%uus max=%uus (%u Hz)",
+                    st.period.min_us, mean_period, st.period.max_us,
+                    mean_period ? 1000000U / mean_period : 0);
+    }
+
+    for (int i = 0; i < SCAN_PHASE_COUNT; i++) {
+        shell_print(sh, "phase %-14s mean=%uus max=%uus", scan_phase_names[i],
+                    (uint32_t)(st.phase_us[i] / st.passes), st.phase_max_us[i]);
+    }
+
+    shell_print(sh, "focused M2 samples=%u strikes caught=%u",
+                st.focus_samples, st.focus_strikes);
+    shell_print(sh, "settle (us, per row) unsettled reads=%u:", st.unsettled_reads);
+    for (int row = 0; row < NUM_ROWS; row++) {
+        shell_print(sh, "   row %d  M1=%3u  M2=%3u", row + 1,
+                    st.m1_settle_us[row], st.m2_settle_us[row]);
+    }
+
+    shell_print(sh, "jitter |period - target|:");
+    uint32_t edge = SCAN_JITTER_BASE_US;
+    for (int i = 0; i < SCAN_JITTER_BUCKETS; i++) {
+        if (i == SCAN_JITTER_BUCKETS - 1) {
+            shell_print(sh, "   >=%5uus  %u", edge / 2, st.jitter_hist[i]);
+        } else {
+            shell_print(sh, "   <%6uus  %u", edge, st.jitter_hist[i]);
+        }
+        edge <<= 1;
+    }
+
+    return 0;
+}
+
+// superr ble [reset]
+static int cmd_ble(const struct shell *sh, size_t argc, char **argv)
+{
+    struct ble_midi_tx_stats tx;
+    struct ble_midi_link_info links[CONFIG_BT_MAX_CONN];
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        ble_midi_reset_tx_stats();
+        ble_adv_reset_stats();
+        shell_print(sh, "BLE TX and reconnect statistics cleared");
+        return 0;
+    }
+
+    ble_midi_get_tx_stats(&tx);
+    shell_print(sh, "tx queue: depth=%u max=%u enqueued=%u merged=%u dropped=%u trimmed=%u",
+                tx.depth, tx.max_depth, tx.enqueued, tx.merged, tx.dropped, tx.trimmed);
+    shell_print(sh, "tx packets=%u messages=%u", tx.packets, tx.messages);
+
+    struct midi_ble_rx_stats rx;
+    midi_ble_rx_get_stats(&rx);
+    shell_print(sh, "rx packets=%u events=%u realtime=%u sysex=%u dropped=%u malformed=%u sysex overflow=%u",
+                rx.packets, rx.events, rx.realtime, rx.sysex, rx.dropped, rx.malformed,
+                rx.sysex_overflow);
+
+    struct led_stream_stats ls;
+    led_stream_get_stats(&ls);
+    shell_print(sh, "led stream: %s depth=%u frames=%u (key=%u delta=%u) gaps=%u malformed=%u",
+                ls.connected ? "connected" : "idle", ls.depth, ls.frames, ls.keyframes,
+                ls.deltas, ls.seq_gaps, ls.malformed);
+    shell_print(sh, "            overflows=%u underruns=%u skipped=%u",
+                ls.overflows, ls.underruns, ls.skipped);
+
+    struct ble_adv_stats adv;
+    ble_adv_get_stats(&adv);
+    shell_print(sh, "advertising: %s, bonds=%u directed timeouts=%u errors=%u",
+                ble_adv_phase_name(adv.phase), adv.bonds, adv.directed_timeouts, adv.errors);
+    shell_print(sh, "reconnects=%u (directed=%u accept list=%u fast=%u slow=%u)",
+                adv.reconnects, adv.by_phase[ADV_DIRECTED], adv.by_phase[ADV_ACCEPT_LIST],
+                adv.by_phase[ADV_FAST], adv.by_phase[ADV_SLOW]);
+    if (adv.reconnects) {
+        shell_print(sh, "reconnect time: last=%ums min=%ums avg=%ums max=%ums",
+                    adv.last_ms, adv.min_ms, adv.total_ms / adv.reconnects, adv.max_ms);
+    }
+
+    int n = ble_midi_get_links(links, ARRAY_SIZE(links));
+    shell_print(sh, "links: %d/%d", n, CONFIG_BT_MAX_CONN);
+    for (int i = 0; i < n; i++) {
+        shell_print(sh, "   [%u] mtu=%u interval=%u.%02ums phy=%u credits=%u sent=%u missed=%u",
+                    links[i].slot, links[i].mtu,
+                    links[i].interval * 125 / 100, links[i].interval * 125 % 100,
+                    links[i].tx_phy, links[i].credits, links[i].sent, links[i].dropped);
+    }
+
+    return 0;
+}
+
+// superr rec [clear]
+static int cmd_rec(const struct shell *sh, size_t argc, char **argv)
+{
+    struct recorder_stats st;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "clear") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        if (recorder_clear()) {
+            shell_error(sh, "Download in progress");
+            return -EBUSY;
+        }
+        shell_print(sh, "Recording cleared");
+        return 0;
+    }
+
+    recorder_get_stats(&st);
+    shell_print(sh, "session %u: events=%u bytes=%u (%u.%02u B/event)", st.session,
+                st.events, st.bytes, st.events ? st.bytes / st.events : 0,
+                st.events ? (st.bytes * 100 / st.events) % 100 : 0);
+    shell_print(sh, "blocks: closed=%u ram=%u lost=%u", st.blocks, st.ram_blocks, st.lost_blocks);
+    if (st.flash) {
+        shell_print(sh, "flash: blocks=%u spilled=%u errors=%u",
+                    st.flash_blocks, st.spilled, st.flash_errors);
+    } else {
+        shell_print(sh, "flash: off (RAM only)");
+    }
+    shell_print(sh, "downloads=%u", st.downloads);
+
+    return 0;
+}
+
+// superr sched [reset]
+static int cmd_sched(const struct shell *sh, size_t argc, char **argv)
+{
+    struct sched_stats st;
+    struct arp_status arp;
+    struct midi_clock_status clk;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        scheduler_reset_stats();
+        shell_print(sh, "Scheduler statistics cleared");
+        return 0;
+    }
+
+    scheduler_get_stats(&st);
+    shell_print(sh, "events: pending=%u max=%u dispatched=%u dropped=%u",
+                st.depth, st.max_depth, st.dispatched, st.dropped);
+    shell_print(sh, "lateness: mean=%uus max=%uus",
+                st.dispatched ? (uint32_t)(st.sum_late_us / st.dispatched) : 0,
+                st.max_late_us);
+    uint32_t edge = SCHED_JITTER_BASE_US;
+    for (int i = 0; i < SCHED_JITTER_BUCKETS; i++) {
+        if (i == SCHED_JITTER_BUCKETS - 1) {
+            shell_print(sh, "   >=%5uus  %u", edge / 2, st.jitter_hist[i]);
+        } else {
+            shell_print(sh, "   <%6uus  %u", edge, st.jitter_hist[i]);
+        }
+        edge <<= 1;
+    }
+
+    arp_get_status(&arp);
+    shell_print(sh, "arp: held=%u steps=%u grid %s %u.%u BPM",
+                arp.held, arp.steps, arp.clock_running ? "running" : "stopped",
+                arp.tempo_x10 / 10, arp.tempo_x10 % 10);
+
+    midi_clock_get_status(&clk);
+    if (clk.locked) {
+        shell_print(sh, "midi clock: %s %u.%02u BPM (%uus/clock) beat %d + %u/64 jitter=%uus",
+                    clk.running ? "running" : "stopped", clk.tempo_x100 / 100,
+                    clk.tempo_x100 % 100, clk.period_us, clk.beat, clk.phase >> 10,
+                    clk.jitter_us);
+    } else {
+        shell_print(sh, "midi clock: no clock");
+    }
+    shell_print(sh, "            clocks=%u missed=%u relocks=%u starts=%u",
+                clk.ticks, clk.missed, clk.relocks, clk.starts);
+
+    return 0;
+}
+
+// superr stats [reset]
+// One screen of the main counters; the other commands have the details
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct scan_stats scan;
+    struct led_stats led;
+    struct ble_midi_tx_stats tx;
+    struct midi_ble_rx_stats rx;
+    struct ble_midi_link_info links[CONFIG_BT_MAX_CONN];
+    struct latency_summary lat;
+    struct kbd_state_stats keys;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Unknown option: %s", argv[1]);
+            return -EINVAL;
+        }
+        scan_stats_reset();
+        led_stats_reset();
+        ble_midi_reset_tx_stats();
+        shell_print(sh, "Scan, LED and BLE TX statistics cleared");
+        return 0;
+    }
+
+    uint32_t uptime_s = k_uptime_get_32() / 1000;
+    shell_print(sh, "uptime %u:%02u:%02u", uptime_s / 3600, uptime_s / 60 % 60, uptime_s % 60);
+
+    scan_stats_get(&scan);
+    if (scan.periods) {
+        uint32_t mean_period = (uint32_t)(scan.period.sum_us / scan.periods);
+        shell_print(sh, "scan: passes=%u %u Hz duration max=%uus misses=%u overruns=%u",
+                    scan.passes, mean_period ? 1000000U / mean_period : 0,
+                    scan.duration.max_us, scan.deadline_misses, scan.overruns);
+    } else {
+        shell_print(sh, "scan: passes=%u", scan.passes);
+    }
+
+    led_stats_get(&led);
+    shell_print(sh, "led:  frames=%u rendered=%u key events=%u dropped=%u",
+                led.frames, led.renders, led.events, led.dropped);
+
+    ble_midi_get_tx_stats(&tx);
+    midi_ble_rx_get_stats(&rx);
+    shell_print(sh, "ble:  links=%d/%d tx messages=%u packets=%u dropped=%u depth=%u max=%u",
+                ble_midi_get_links(links, ARRAY_SIZE(links)), CONFIG_BT_MAX_CONN,
+                tx.enqueued, tx.packets, tx.dropped, tx.depth, tx.max_depth);
+    shell_print(sh, "      rx packets=%u events=%u dropped=%u malformed=%u",
+                rx.packets, rx.events, rx.dropped, rx.malformed);
+
+    latency_get_summary(LATENCY_NOTIFY, &lat);
+    shell_print(sh, "latency capture->notify: n=%u p50=%uus p99=%uus max=%uus",
+                lat.count, lat.p50_us, lat.p99_us, lat.max_us);
+
+    kbd_state_get_stats(&keys);
+    shell_print(sh, "keys: held=%u", keys.held);
+
+    return 0;
+}
+
+#if defined(CONFIG_THREAD_RUNTIME_STATS) && defined(CONFIG_THREAD_STACK_INFO)
+// superr threads
+// CPU share since the previous call (since boot on the first one) and
+// stack high-water mark per thread. Walks the thread list with
+// k_thread_foreach_unlocked() like the thread analyzer does, but without
+// holding the list lock while stacks are measured, so the scan timer is
+// never held off.
+#define THREAD_SLOTS 16
+
+struct thread_row {
+    const struct k_thread *thread;
+    const char *name;
+    int prio;
+    uint64_t cycles;
+    size_t stack_size;
+    size_t stack_unused;
+};
+
+struct thread_walk {
+    struct thread_row rows[THREAD_SLOTS];
+    int n;
+    int skipped;
+};
+
+static struct {
+    const struct k_thread *thread;
+    uint64_t cycles;
+} prev_cycles[THREAD_SLOTS];
+static uint64_t prev_total;
+
+static void thread_collect(const struct k_thread *thread, void *user_data)
+{
+    struct thread_walk *w = user_data;
+    k_tid_t tid = (k_tid_t)thread;
+    k_thread_runtime_stats_t rt;
+
+    if (w->n == THREAD_SLOTS) {
+        w->skipped++;
+        return;
+    }
+
+    struct thread_row *r = &w->rows[w->n++];
+    const char *name = k_thread_name_get(tid);
+
+    r->thread = thread;
+    r->name = (name && name[0]) ? name : "?";
+    r->prio = k_thread_priority_get(tid);
+    r->cycles = k_thread_runtime_stats_get(tid, &rt) ? 0 : rt.execution_cycles;
+    r->stack_size = thread->stack_info.size;
+    if (k_thread_stack_space_get(thread, &r->stack_unused)) {
+        r->stack_unused = r->stack_size;   // Not measurable (no INIT_STACKS)
+    }
+}
+
+static uint64_t cycles_since(const struct thread_row *r)
+{
+    for (int i = 0; i < THREAD_SLOTS; i++) {
+        if (prev_cycles[i].thread == r->thread && r->cycles >= prev_cycles[i].cycles) {
+            return r->cycles - prev_cycles[i].cycles;
+        }
+    }
+    return r->cycles;
+}
+
+static int cmd_threads(const struct shell *sh, size_t argc, char **argv)
+{
+    static struct thread_walk w;
+    k_thread_runtime_stats_t all;
+
+    w.n = 0;
+    w.skipped = 0;
+    k_thread_foreach_unlocked(thread_collect, &w);
+    if (k_thread_runtime_stats_all_get(&all)) {
+        all.execution_cycles = 0;
+    }
+
+    uint64_t total = all.execution_cycles - prev_total;
+    prev_total = all.execution_cycles;
+
+    shell_print(sh, "%-20s %4s %7s %13s", "thread", "prio", "cpu", "stack used");
+    for (int i = 0; i < w.n; i++) {
+        const struct thread_row *r = &w.rows[i];
+        uint64_t delta = cycles_since(r);
+        uint32_t permille = total ? (uint32_t)(delta * 1000 / total) : 0;
+        size_t used = r->stack_size - r->stack_unused;
+
+        shell_print(sh, "%-20s %4d %3u.%u%% %5u/%-5u %3u%%", r->name, r->prio,
+                    permille / 10, permille % 10, (uint32_t)used, (uint32_t)r->stack_size,
+                    r->stack_size ? (uint32_t)(used * 100 / r->stack_size) : 0);
+    }
+    if (w.skipped) {
+        shell_print(sh, "(%d more threads not shown)", w.skipped);
+    }
+
+    memset(prev_cycles, 0, sizeof(prev_cycles));
+    for (int i = 0; i < w.n; i++) {
+        prev_cycles[i].thread = w.rows[i].thread;
+        prev_cycles[i].cycles = w.rows[i].cycles;
+    }
+
+    return 0;
+}
+#endif
+
+// superr keys
+// Held keys with their strike velocities, one line per matrix row
+static int cmd_keys(const struct shell *sh, size_t argc, char **argv)
+{
+    uint8_t velocity[NUM_KEYS];
+    struct kbd_state_stats st;
+    uint16_t seq = kbd_state_get(velocity);
+
+    kbd_state_get_stats(&st);
+    shell_print(sh, "seq=%u notifications=%u merged=%u too big=%u",
+                seq, st.notifies, st.coalesced, st.too_big);
+
+    int held = 0;
+    for (int row = 0; row < NUM_ROWS; row++) {
+        char line[NUM_COLS * 4 + 1];
+        char *p = line;
+
+        for (int col = 0; col < ROW_KEYS(row); col++) {
+            uint8_t v = velocity[row * NUM_COLS + col];
+
+            if (v) {
+                p += snprintk(p, 5, "%4u", v);
+                held++;
+            } else {
+                p += snprintk(p, 5, "   .");
+            }
+        }
+        *p = '\0';
+        shell_print(sh, "   row %d %s", row + 1, line);
+    }
+    shell_print(sh, "held=%d", held);
+
+    return 0;
+}
+
+#if defined(CONFIG_SUPERR_PEDALS)
+// superr pedals
+static int cmd_pedals(const struct shell *sh, size_t argc, char **argv)
+{
+    struct pedals_stats st;
+
+    pedals_get_stats(&st);
+    shell_print(sh, "batches=%u errors=%u (%u samples at %uus)",
+                st.batches, st.errors, PEDAL_BATCH, PEDAL_SAMPLE_US);
+    for (int i = 0; i < st.count; i++) {
+        shell_print(sh, "   %-10s CC%-2u value=%3u raw=%4d sent=%u", st.pedal[i].name,
+                    st.pedal[i].cc, st.pedal[i].value, st.pedal[i].raw, st.pedal[i].sent);
+    }
+
+    return 0;
+}
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_superr,
+    SHELL_CMD_ARG(stats, NULL, "Scan, LED and BLE counters at a glance [reset]",
+                  cmd_stats, 1, 1),
+#if defined(CONFIG_THREAD_RUNTIME_STATS) && defined(CONFIG_THREAD_STACK_INFO)
+    SHELL_CMD(threads, NULL, "CPU use since the last call and stack high-water per thread",
+              cmd_threads),
+#endif
+    SHELL_CMD_ARG(latency, NULL, "Key-to-notify latency histograms [reset]",
+                  cmd_latency, 1, 1),
+    SHELL_CMD_ARG(scan, NULL, "Scan period, duration, jitter and phase timing [reset]",
+                  cmd_scan, 1, 1),
+    SHELL_CMD_ARG(ble, NULL, "BLE links, advertising, MIDI TX queue and RX parser counters [reset]",
+                  cmd_ble, 1, 1),
+    SHELL_CMD_ARG(rec, NULL, "Performance recorder counters [clear]",
+                  cmd_rec, 1, 1),
+    SHELL_CMD_ARG(sched, NULL, "MIDI event scheduler, arpeggiator and MIDI clock [reset]",
+                  cmd_sched, 1, 1),
+    SHELL_CMD(keys, NULL, "Held keys and their velocities", cmd_keys),
+#if defined(CONFIG_SUPERR_PEDALS)
+    SHELL_CMD(pedals, NULL, "Pedal values and CC counters", cmd_pedals),
+#endif
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(superr, &sub_superr, "Superr keyboard diagnostics", NULL);
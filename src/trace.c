@@ -0,0 +1,142 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "trace.h"
+#include "keyboard.h"
+
+// ========== RING CONFIGURATION ==========
+#define TRACE_RING_SIZE     256   // Records (power of 2) - 3 KB
+#define TRACE_DRAIN_MS      50    // Consumer poll period
+#define TRACE_STACK_SIZE    1024
+
+BUILD_ASSERT((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0,
+             "TRACE_RING_SIZE must be a power of 2");
+
+static struct trace_record ring[TRACE_RING_SIZE];
+static uint32_t head;   // Next slot to write (producers)
+static uint32_t tail;   // Next slot to read (consumer)
+static uint32_t dropped;
+
+// Producers only hold this for a bounds check and a 12-byte copy
+static struct k_spinlock ring_lock;
+
+// ========== PRODUCER ==========
+
+void trace_emit(uint16_t id, uint16_t a, uint32_t b)
+{
+    uint32_t now = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+    if (head - tail >= TRACE_RING_SIZE) {
+        dropped++;
+    } else {
+        struct trace_record *rec = &ring[head & (TRACE_RING_SIZE - 1)];
+        rec->timestamp = now;
+        rec->id = id;
+        rec->a = a;
+        rec->b = b;
+        head++;
+    }
+
+    k_spin_unlock(&ring_lock, key);
+}
+
+uint32_t trace_dropped_count(void)
+{
+    return dropped;
+}
+
+// ========== CONSUMER ==========
+
+#if defined(CONFIG_SUPERR_TRACE_RAW)
+// Raw mode: one hex line per record, decoded on the host
+static void output_record(const struct trace_record *rec)
+{
+    printk("#T %08x %04x %04x %08x\n", rec->timestamp, rec->id, rec->a, rec->b);
+}
+#else
+// Text mode: same messages the scan loop used to print inline
+static void output_record(const struct trace_record *rec)
+{
+    uint32_t us = k_cyc_to_us_floor32(rec->timestamp);
+    int row = rec->a / NUM_COLS + 1;
+    int col = rec->a % NUM_COLS + 1;
+
+    printk("[%u.%06u] ", us / 1000000, us % 1000000);
+
+    switch (rec->id) {
+    case TRACE_M2_CONTACT:
+        printk("[M2] Key[R%d,C%d]: Matrix 2 SECOND contact detected (Note %u)\n",
+               row, col, rec->b);
+        break;
+    case TRACE_M2_WITHOUT_M1:
+        printk("[WARN] Key[R%d,C%d]: M2 contact but M1 not active!\n", row, col);
+        break;
+    case TRACE_NOTE_OFF:
+        printk("[NOTE OFF] Key[R%d,C%d] (Note %u)\n", row, col, rec->b);
+        break;
+    case TRACE_STUCK_KEYS:
+        printk("[DEBUG] %u keys stuck! (Count: %u)\n", rec->a, rec->b);
+        break;
+    case TRACE_STUCK_KEY:
+        printk("   Key[R%d,C%d] Note %d: M1=%d M2=%d Playing=%d\n",
+               row, col, BASE_MIDI_NOTE + rec->a,
+               !!(rec->b & 0x1), !!(rec->b & 0x2), !!(rec->b & 0x4));
+        break;
+    case TRACE_STUCK_RESET:
+        printk("[WARN] Keys stuck for >5 seconds, forcing reset...\n");
+        break;
+    case TRACE_FORCE_RESET:
+        printk("   Reset Key %u (Note %u)\n", rec->a, rec->b);
+        break;
+    case TRACE_IDLE_CHECK:
+        printk("[DEBUG] All keys OFF (OK), Time: %u ms, Columns:", rec->b);
+        for (int c = 0; c < NUM_COLS; c++) {
+            printk(" C%d=%s", c + 1, (rec->a & BIT(c)) ? "HIGH" : "LOW");
+        }
+        printk("\n");
+        break;
+    default:
+        printk("[TRACE] id=%u a=%u b=%u\n", rec->id, rec->a, rec->b);
+        break;
+    }
+}
+#endif
+
+static void trace_thread_entry(void *p1, void *p2, void *p3)
+{
+    uint32_t reported_drops = 0;
+
+#if defined(CONFIG_SUPERR_TRACE_RAW)
+    printk("#TH %u\n", sys_clock_hw_cycles_per_sec());
+#endif
+
+    while (1) {
+        k_msleep(TRACE_DRAIN_MS);
+
+        // Single consumer: only this thread advances tail. Copy each record
+        // out under the lock, print with the lock released.
+        while (1) {
+            struct trace_record rec;
+            k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+            if (tail == head) {
+                k_spin_unlock(&ring_lock, key);
+                break;
+            }
+            rec = ring[tail & (TRACE_RING_SIZE - 1)];
+            tail++;
+            k_spin_unlock(&ring_lock, key);
+
+            output_record(&rec);
+        }
+
+        uint32_t drops = dropped;
+        if (drops != reported_drops) {
+            printk("[TRACE] %u events dropped (ring full)\n", drops - reported_drops);
+            reported_drops = drops;
+        }
+    }
+}
+
+K_THREAD_DEFINE(trace_thread, TRACE_STACK_SIZE, trace_thread_entry, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
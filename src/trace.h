@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <zephyr/types.h>
+
+// ========== DEFERRED BINARY TRACE ==========
+// Hot-path diagnostics are recorded as fixed-size binary records
+// (timestamp, event ID, two arguments) into a RAM ring. A lowest-priority
+// thread formats and prints them later, so the scan thread never waits on
+// the UART. With CONFIG_SUPERR_TRACE_RAW the records are dumped as hex
+// lines instead, to be rendered on the host by tools/trace_decode.py.
+//
+// Event IDs are part of the raw format - only append, never renumber
+// (and keep tools/trace_decode.py in sync).
+enum trace_event {
+    TRACE_M2_CONTACT     = 1,  // a = key index, b = MIDI note
+    TRACE_M2_WITHOUT_M1  = 2,  // a = key index
+    TRACE_NOTE_OFF       = 3,  // a = key index, b = MIDI note
+    TRACE_STUCK_KEYS     = 4,  // a = keys playing, b = consecutive checks
+    TRACE_STUCK_KEY      = 5,  // a = key index, b = TRACE_KEY_FLAGS()
+    TRACE_STUCK_RESET    = 6,  // (no args)
+    TRACE_FORCE_RESET    = 7,  // a = key index, b = MIDI note
+    TRACE_IDLE_CHECK     = 8,  // a = column levels (bit n = column n HIGH), b = uptime ms
+};
+
+// Packs key contact state into a trace argument
+#define TRACE_KEY_FLAGS(m1, m2, playing) \
+    (((m1) ? 0x1 : 0) | ((m2) ? 0x2 : 0) | ((playing) ? 0x4 : 0))
+
+struct trace_record {
+    uint32_t timestamp;  // Hardware cycles (k_cycle_get_32)
+    uint16_t id;         // enum trace_event
+    uint16_t a;
+    uint32_t b;
+};
+
+/**
+ * @brief Record a trace event (non-blocking, any thread or ISR)
+ *
+ * If the ring is full the event is dropped and counted.
+ */
+void trace_emit(uint16_t id, uint16_t a, uint32_t b);
+
+/**
+ * @brief Number of events dropped because the ring was full
+ */
+uint32_t trace_dropped_count(void);
+
+#define TRACE(id, a, b) trace_emit((id), (uint16_t)(a), (uint32_t)(b))
+
+#endif // TRACE_H
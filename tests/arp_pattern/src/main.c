@@ -0,0 +1,122 @@
+#include <zephyr/ztest.h>
+#include "arp.h"
+#include "arp_pattern.h"
+
+// ========== ARPEGGIATOR PATTERN TEST ==========
+// Note order of every pick mode, from the first step on and across the
+// wrap of the pattern, for 1 to ARP_MAX_HELD held notes.
+
+static uint32_t rng;
+
+static void arp_pattern_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    rng = 0x2545F491;   // arp.c's seed
+}
+
+static void expect_sequence(uint8_t mode, uint32_t held, const int *expect, int count)
+{
+    for (int i = 0; i < count; i++) {
+        zassert_equal(arp_pattern_pick(mode, i, held, &rng), expect[i],
+                      "mode %u, %u held, step %d", mode, held, i);
+    }
+}
+
+ZTEST(arp_pattern, test_up)
+{
+    static const int expect[] = { 0, 1, 2, 3, 0, 1, 2, 3, 0 };
+
+    expect_sequence(ARP_UP, 4, expect, ARRAY_SIZE(expect));
+}
+
+ZTEST(arp_pattern, test_down)
+{
+    static const int expect[] = { 3, 2, 1, 0, 3, 2, 1, 0, 3 };
+
+    expect_sequence(ARP_DOWN, 4, expect, ARRAY_SIZE(expect));
+}
+
+ZTEST(arp_pattern, test_up_down)
+{
+    // Top and bottom notes are not repeated at the turns
+    static const int four[] = { 0, 1, 2, 3, 2, 1, 0, 1, 2, 3, 2, 1, 0 };
+    static const int two[] = { 0, 1, 0, 1, 0 };
+
+    expect_sequence(ARP_UP_DOWN, 4, four, ARRAY_SIZE(four));
+    expect_sequence(ARP_UP_DOWN, 2, two, ARRAY_SIZE(two));
+}
+
+ZTEST(arp_pattern, test_one_note)
+{
+    for (uint8_t mode = ARP_UP; mode <= ARP_RANDOM; mode++) {
+        for (uint32_t step = 0; step < 10; step++) {
+            zassert_equal(arp_pattern_pick(mode, step, 1, &rng), 0, "mode %u", mode);
+        }
+    }
+}
+
+ZTEST(arp_pattern, test_every_note_every_cycle)
+{
+    // Each up, down and up/down cycle plays every held note
+    for (uint8_t mode = ARP_UP; mode <= ARP_UP_DOWN; mode++) {
+        for (uint32_t held = 1; held <= ARP_MAX_HELD; held++) {
+            uint32_t cycle = (mode == ARP_UP_DOWN && held > 1) ? 2 * held - 2 : held;
+            uint32_t seen = 0;
+
+            for (uint32_t step = 3 * cycle; step < 4 * cycle; step++) {
+                int i = arp_pattern_pick(mode, step, held, &rng);
+
+                zassert_true(i >= 0 && i < (int)held);
+                seen |= BIT(i);
+            }
+            zassert_equal(seen, BIT_MASK(held), "mode %u, %u held", mode, held);
+        }
+    }
+}
+
+ZTEST(arp_pattern, test_notes_added_mid_pattern)
+{
+    // The step count runs on when a key is added: the pattern continues
+    // from the same position in the longer chord
+    zassert_equal(arp_pattern_pick(ARP_UP, 5, 3, &rng), 2);
+    zassert_equal(arp_pattern_pick(ARP_UP, 6, 4, &rng), 2);
+    zassert_equal(arp_pattern_pick(ARP_DOWN, 6, 4, &rng), 1);
+}
+
+ZTEST(arp_pattern, test_random)
+{
+    uint32_t count[ARP_MAX_HELD] = { 0 };
+    const uint32_t held = 5;
+    const int picks = 5000;
+    int repeats = 0;
+    int last = -1;
+
+    for (int step = 0; step < picks; step++) {
+        int i = arp_pattern_pick(ARP_RANDOM, step, held, &rng);
+
+        zassert_true(i >= 0 && i < (int)held);
+        count[i]++;
+        repeats += (i == last);
+        last = i;
+    }
+    // Roughly uniform, and not stuck
+    for (uint32_t i = 0; i < held; i++) {
+        zassert_between_inclusive(count[i], picks / held * 8 / 10, picks / held * 12 / 10,
+                                  "note %u picked %u times", i, count[i]);
+    }
+    zassert_true(repeats < picks / 3);
+    zassert_not_equal(rng, 0);
+}
+
+ZTEST(arp_pattern, test_random_repeatable)
+{
+    uint32_t a = 1234, b = 1234;
+
+    for (int step = 0; step < 100; step++) {
+        zassert_equal(arp_pattern_pick(ARP_RANDOM, step, 7, &a),
+                      arp_pattern_pick(ARP_RANDOM, step, 7, &b));
+    }
+}
+
+ZTEST_SUITE(arp_pattern, NULL, NULL, arp_pattern_before, NULL, NULL);
@@ -0,0 +1,195 @@
+#include <zephyr/ztest.h>
+#include <zephyr/bluetooth/gap.h>
+#include "ble_adv.h"
+#include "ble_adv_policy.h"
+
+// ========== ADVERTISING POLICY TEST ==========
+// The phase walk of ble_adv.c on a virtual clock: advertise() makes the
+// same calls as adv_update() and remembers when the phase runs out, so a
+// test can step through boot, timeouts, connections and disconnects
+// without a controller.
+
+struct adv {
+    enum ble_adv_phase phase;
+    int64_t end;            // 0 = until a connection
+    int starts;             // Phases entered (advertising restarted)
+    bool have_peer;         // A bonded central waits for its directed burst
+    bool have_bonds;
+    bool slot_free;
+};
+
+static struct adv adv;
+
+static void adv_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    adv = (struct adv){ .phase = ADV_IDLE, .slot_free = true };
+}
+
+static void advertise(enum ble_adv_phase requested, int64_t now)
+{
+    bool enter;
+    enum ble_adv_phase next = ble_adv_policy_next(adv.phase, requested,
+                                                  adv.end && now >= adv.end,
+                                                  adv.slot_free, &enter);
+
+    if (!enter) {
+        return;
+    }
+    if (next != ADV_IDLE) {
+        next = ble_adv_policy_first_usable(next, adv.have_peer, adv.have_bonds);
+        if (next == ADV_DIRECTED) {
+            adv.have_peer = false;      // One burst per disconnect
+        }
+        adv.starts++;
+    }
+    int64_t duration = ble_adv_policy_duration(next);
+    adv.phase = next;
+    adv.end = duration ? now + duration : 0;
+}
+
+ZTEST(ble_adv_policy, test_boot_walks_fast_to_slow)
+{
+    adv.have_bonds = true;
+
+    advertise(ADV_ACCEPT_LIST, 0);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+    zassert_equal(adv.end, ADV_ACCEPT_LIST_MS);
+
+    // Not run out yet: the phase is resumed, not restarted
+    advertise(ADV_IDLE, ADV_ACCEPT_LIST_MS - 1);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+    zassert_equal(adv.starts, 1);
+
+    advertise(ADV_IDLE, ADV_ACCEPT_LIST_MS);
+    zassert_equal(adv.phase, ADV_FAST);
+    zassert_equal(adv.end, ADV_ACCEPT_LIST_MS + ADV_FAST_MS);
+
+    advertise(ADV_IDLE, ADV_ACCEPT_LIST_MS + ADV_FAST_MS);
+    zassert_equal(adv.phase, ADV_SLOW);
+    zassert_equal(adv.end, 0, "slow advertising has no end");
+
+    // Slow runs until a central connects
+    advertise(ADV_IDLE, 24 * 3600 * 1000LL);
+    zassert_equal(adv.phase, ADV_SLOW);
+    zassert_equal(adv.starts, 3);
+}
+
+ZTEST(ble_adv_policy, test_no_bonds_skips_accept_list)
+{
+    advertise(ADV_ACCEPT_LIST, 0);
+    zassert_equal(adv.phase, ADV_FAST);
+    zassert_equal(adv.end, ADV_FAST_MS);
+}
+
+ZTEST(ble_adv_policy, test_connection_restarts_at_fast)
+{
+    adv.have_bonds = true;
+    advertise(ADV_ACCEPT_LIST, 0);
+    advertise(ADV_IDLE, ADV_ACCEPT_LIST_MS);
+    advertise(ADV_IDLE, ADV_ACCEPT_LIST_MS + ADV_FAST_MS);
+    zassert_equal(adv.phase, ADV_SLOW);
+
+    // A central connected with slots left: fast again, for the next one
+    advertise(ADV_FAST, 100000);
+    zassert_equal(adv.phase, ADV_FAST);
+    zassert_equal(adv.end, 100000 + ADV_FAST_MS);
+
+    // Requested again while already fast: entered again, timer restarted
+    advertise(ADV_FAST, 110000);
+    zassert_equal(adv.end, 110000 + ADV_FAST_MS);
+}
+
+ZTEST(ble_adv_policy, test_all_slots_taken_stops)
+{
+    advertise(ADV_FAST, 0);
+    int starts = adv.starts;
+
+    // The last slot was taken: stop, and drop the request of that
+    // connection
+    adv.slot_free = false;
+    advertise(ADV_FAST, 1000);
+    zassert_equal(adv.phase, ADV_IDLE);
+    zassert_equal(adv.end, 0);
+
+    // Nothing runs out while stopped
+    advertise(ADV_IDLE, 1000 + ADV_FAST_MS);
+    zassert_equal(adv.phase, ADV_IDLE);
+    zassert_equal(adv.starts, starts);
+
+    // A slot came free without a request: fast
+    adv.slot_free = true;
+    advertise(ADV_IDLE, 50000);
+    zassert_equal(adv.phase, ADV_FAST);
+}
+
+ZTEST(ble_adv_policy, test_disconnect_restarts_directed)
+{
+    adv.have_bonds = true;
+    adv.slot_free = false;
+    advertise(ADV_FAST, 0);
+    zassert_equal(adv.phase, ADV_IDLE);
+
+    // A bonded central dropped: a directed burst to it first
+    adv.slot_free = true;
+    adv.have_peer = true;
+    advertise(ADV_DIRECTED, 5000);
+    zassert_equal(adv.phase, ADV_DIRECTED);
+    zassert_true(adv.end > 5000);
+
+    // Nobody answered (connected() with an advertising timeout)
+    advertise(ADV_ACCEPT_LIST, 6280);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+
+    // The timeout report got lost: the guard moves on by itself
+    adv.have_peer = true;
+    advertise(ADV_DIRECTED, 20000);
+    zassert_equal(adv.phase, ADV_DIRECTED);
+    advertise(ADV_IDLE, adv.end);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+
+    // Only one burst per disconnect
+    advertise(ADV_DIRECTED, 40000);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+}
+
+ZTEST(ble_adv_policy, test_unbonded_disconnect_skips_directed)
+{
+    advertise(ADV_DIRECTED, 0);
+    zassert_equal(adv.phase, ADV_FAST);
+
+    adv.have_bonds = true;
+    advertise(ADV_DIRECTED, 1000);
+    zassert_equal(adv.phase, ADV_ACCEPT_LIST);
+}
+
+ZTEST(ble_adv_policy, test_intervals)
+{
+    struct ble_adv_interval directed = ble_adv_policy_interval(ADV_DIRECTED);
+    struct ble_adv_interval accept = ble_adv_policy_interval(ADV_ACCEPT_LIST);
+    struct ble_adv_interval fast = ble_adv_policy_interval(ADV_FAST);
+    struct ble_adv_interval slow = ble_adv_policy_interval(ADV_SLOW);
+
+    // High duty directed: the controller picks the interval
+    zassert_equal(directed.min, 0);
+    zassert_equal(directed.max, 0);
+
+    zassert_equal(accept.min, BT_GAP_ADV_FAST_INT_MIN_1);
+    zassert_equal(accept.max, BT_GAP_ADV_FAST_INT_MAX_1);
+    zassert_equal(fast.min, BT_GAP_ADV_FAST_INT_MIN_2);
+    zassert_equal(fast.max, BT_GAP_ADV_FAST_INT_MAX_2);
+    zassert_equal(slow.min, BT_GAP_ADV_SLOW_INT_MIN);
+    zassert_equal(slow.max, BT_GAP_ADV_SLOW_INT_MAX);
+
+    // Each phase advertises less often than the one before it
+    zassert_true(accept.min <= accept.max && accept.max < fast.min);
+    zassert_true(fast.min <= fast.max && fast.max < slow.min);
+    zassert_true(slow.min <= slow.max);
+
+    struct ble_adv_interval idle = ble_adv_policy_interval(ADV_IDLE);
+    zassert_equal(idle.min, 0);
+    zassert_equal(idle.max, 0);
+}
+
+ZTEST_SUITE(ble_adv_policy, NULL, NULL, adv_before, NULL, NULL);
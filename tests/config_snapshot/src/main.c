@@ -0,0 +1,160 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include "config_snapshot.h"
+#include "ble_config_service.h"
+#include "keyboard.h"
+
+// ========== CONFIG SNAPSHOT TEST ==========
+// Publishes snapshots the way the GATT write handlers do (change a global,
+// request a rebuild) and holds them the way the scan and LED threads do,
+// between config_snapshot_get() and config_snapshot_put(). The globals
+// normally come from ble_config_service.c.
+
+uint8_t g_sensitivity = 50;
+uint8_t g_led_theme = 0;
+int8_t  g_transpose = 0;
+uint8_t g_guide_channel = 0;
+struct arp_settings g_arp = {
+    .mode = 0,
+    .division = 4,
+    .gate = 50,
+    .tempo = 120,
+    .clock = 0,
+};
+
+// Past the publish delay, so a requested rebuild has run
+#define PUBLISH_WAIT K_MSEC(50)
+
+static uint32_t current_generation(void)
+{
+    const struct config_snapshot *cfg = config_snapshot_get();
+    uint32_t gen = cfg->generation;
+
+    config_snapshot_put(cfg);
+    return gen;
+}
+
+// What a GATT write does, then wait for the rebuild
+static void publish_sensitivity(uint8_t val)
+{
+    g_sensitivity = val;
+    config_snapshot_request_update();
+    k_sleep(PUBLISH_WAIT);
+}
+
+static void *config_snapshot_setup(void)
+{
+    zassert_ok(config_snapshot_init());
+    return NULL;
+}
+
+static void config_snapshot_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    g_transpose = 0;
+    publish_sensitivity(50);
+}
+
+ZTEST(config_snapshot, test_publish_bumps_generation)
+{
+    uint32_t gen = current_generation();
+
+    publish_sensitivity(80);
+
+    const struct config_snapshot *cfg = config_snapshot_get();
+
+    zassert_equal(cfg->generation, gen + 1);
+    zassert_equal(cfg->sensitivity, 80);
+    config_snapshot_put(cfg);
+}
+
+ZTEST(config_snapshot, test_burst_is_one_publish)
+{
+    uint32_t gen = current_generation();
+
+    for (int i = 0; i < 10; i++) {
+        g_sensitivity = 30 + i;
+        config_snapshot_request_update();
+    }
+    k_sleep(PUBLISH_WAIT);
+    zassert_equal(current_generation(), gen + 1);
+}
+
+ZTEST(config_snapshot, test_held_snapshot_unchanged)
+{
+    const struct config_snapshot *held = config_snapshot_get();
+    uint32_t gen = held->generation;
+    uint8_t vel = held->velocity_curve[10];
+
+    // More publishes than there are buffers
+    for (int i = 0; i < 6; i++) {
+        publish_sensitivity(20 + 10 * i);
+    }
+    zassert_equal(current_generation(), gen + 6);
+
+    zassert_equal(held->generation, gen, "held snapshot was rebuilt");
+    zassert_equal(held->sensitivity, 50);
+    zassert_equal(held->velocity_curve[10], vel);
+    config_snapshot_put(held);
+}
+
+ZTEST(config_snapshot, test_rebuild_waits_for_readers)
+{
+    // Hold the published buffer and the next one; the third is published
+    const struct config_snapshot *a = config_snapshot_get();
+
+    publish_sensitivity(60);
+    const struct config_snapshot *b = config_snapshot_get();
+
+    publish_sensitivity(70);
+    uint32_t gen = current_generation();
+
+    // No buffer is free: the rebuild is postponed, nothing changes
+    publish_sensitivity(90);
+    zassert_equal(current_generation(), gen);
+    zassert_equal(a->sensitivity, 50);
+    zassert_equal(b->sensitivity, 60);
+
+    // Releasing one lets the postponed rebuild through, into that buffer
+    config_snapshot_put(a);
+    k_sleep(PUBLISH_WAIT);
+
+    const struct config_snapshot *cfg = config_snapshot_get();
+
+    zassert_equal_ptr(cfg, a);
+    zassert_equal(cfg->generation, gen + 1);
+    zassert_equal(cfg->sensitivity, 90);
+    zassert_equal(b->sensitivity, 60);
+    config_snapshot_put(cfg);
+    config_snapshot_put(b);
+}
+
+ZTEST(config_snapshot, test_transpose_clamps_at_range_ends)
+{
+    const struct config_snapshot *cfg;
+
+    // Far past the GATT range, so the top and bottom keys leave 0..127
+    g_transpose = 127 - BASE_MIDI_NOTE - 3;
+    publish_sensitivity(50);
+    cfg = config_snapshot_get();
+    for (int i = 0; i < NUM_KEYS; i++) {
+        zassert_equal(cfg->note_map[i], MIN(124 + i, 127), "key %d", i);
+    }
+    // The lowest key on the end note lights the guide for it
+    zassert_equal(cfg->key_for_note[127], 3);
+    zassert_equal(cfg->key_for_note[0], NO_KEY);
+    config_snapshot_put(cfg);
+
+    g_transpose = -BASE_MIDI_NOTE - 2;
+    publish_sensitivity(50);
+    cfg = config_snapshot_get();
+    for (int i = 0; i < NUM_KEYS; i++) {
+        zassert_equal(cfg->note_map[i], MAX(i - 2, 0), "key %d", i);
+    }
+    zassert_equal(cfg->key_for_note[0], 0);
+    zassert_equal(cfg->key_for_note[1], 3);
+    config_snapshot_put(cfg);
+}
+
+ZTEST_SUITE(config_snapshot, NULL, config_snapshot_setup, config_snapshot_before, NULL, NULL);
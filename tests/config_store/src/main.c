@@ -0,0 +1,155 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/settings/settings.h>
+#include "config_store.h"
+#include "ble_config_service.h"
+
+// ========== CONFIG STORE TEST ==========
+// Runs config_store.c on the native_sim flash simulator. The globals and
+// arp_settings_valid() normally come from ble_config_service.c; the GATT
+// write handlers change a global and call setting_changed(), which is
+// mirrored by write_setting() below.
+
+uint8_t g_sensitivity = 50;
+uint8_t g_led_theme = 0;
+int8_t  g_transpose = 0;
+uint8_t g_guide_channel = 0;
+struct arp_settings g_arp = {
+    .mode = 0,
+    .division = 4,
+    .gate = 50,
+    .tempo = 120,
+    .clock = 0,
+};
+
+bool arp_settings_valid(const struct arp_settings *a)
+{
+    return a->division >= 1 && a->gate >= 5 && a->gate <= 100;
+}
+
+// What a GATT write does to the store (ble_config_service.c)
+static void write_setting(uint8_t *global, uint8_t val)
+{
+    *global = val;
+    config_store_schedule_save();
+}
+
+static void wait_for_save(void)
+{
+    k_sleep(K_MSEC(SAVE_DELAY_MS + 100));
+}
+
+static void *config_store_setup(void)
+{
+    const struct flash_area *fa;
+
+    // Start from an empty partition, whatever an earlier run left behind
+    zassert_ok(flash_area_open(FIXED_PARTITION_ID(storage_partition), &fa));
+    zassert_ok(flash_area_erase(fa, 0, fa->fa_size));
+    flash_area_close(fa);
+
+    zassert_ok(config_store_init());
+    return NULL;
+}
+
+static void config_store_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Nothing may stay pending into the next test
+    config_store_flush();
+}
+
+ZTEST(config_store, test_burst_is_one_write)
+{
+    uint32_t before = config_store_write_count();
+
+    // A slider drag: a write every 50 ms for a second
+    for (int i = 0; i < 20; i++) {
+        write_setting(&g_sensitivity, 10 + i);
+        k_sleep(K_MSEC(50));
+    }
+    zassert_equal(config_store_write_count(), before,
+                  "flash written while writes were still coming in");
+
+    k_sleep(K_MSEC(SAVE_DELAY_MS / 2));
+    zassert_equal(config_store_write_count(), before,
+                  "flash written before the save delay");
+
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before + 1);
+}
+
+ZTEST(config_store, test_only_changed_keys_written)
+{
+    uint32_t before = config_store_write_count();
+
+    write_setting(&g_led_theme, g_led_theme + 1);
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before + 1);
+
+    write_setting(&g_guide_channel, 10);
+    write_setting((uint8_t *)&g_transpose, (uint8_t)-5);
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before + 3);
+
+    // Same values again: nothing to write
+    write_setting(&g_guide_channel, 10);
+    write_setting((uint8_t *)&g_transpose, (uint8_t)-5);
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before + 3);
+}
+
+ZTEST(config_store, test_change_and_revert_is_no_write)
+{
+    uint32_t before = config_store_write_count();
+    uint8_t sens = g_sensitivity;
+
+    write_setting(&g_sensitivity, sens + 1);
+    write_setting(&g_sensitivity, sens);
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before);
+}
+
+ZTEST(config_store, test_flush_writes_now)
+{
+    uint32_t before = config_store_write_count();
+
+    write_setting(&g_sensitivity, g_sensitivity ^ 1);
+    g_arp.tempo++;
+    config_store_schedule_save();
+
+    config_store_flush();
+    zassert_equal(config_store_write_count(), before + 2);
+
+    // Nothing left pending once the delay has passed
+    wait_for_save();
+    zassert_equal(config_store_write_count(), before + 2);
+}
+
+ZTEST(config_store, test_values_reload)
+{
+    write_setting(&g_sensitivity, 77);
+    write_setting(&g_led_theme, 2);
+    write_setting((uint8_t *)&g_transpose, (uint8_t)-12);
+    write_setting(&g_guide_channel, 16);
+    g_arp.gate = 25;
+    config_store_schedule_save();
+    config_store_flush();
+
+    g_sensitivity = 0;
+    g_led_theme = 0;
+    g_transpose = 0;
+    g_guide_channel = 0;
+    g_arp.gate = 50;
+
+    zassert_ok(settings_load_subtree("superr"));
+    zassert_equal(g_sensitivity, 77);
+    zassert_equal(g_led_theme, 2);
+    zassert_equal(g_transpose, -12);
+    zassert_equal(g_guide_channel, 16);
+    zassert_equal(g_arp.gate, 25);
+}
+
+ZTEST_SUITE(config_store, NULL, config_store_setup, NULL, config_store_after, NULL);
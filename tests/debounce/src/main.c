@@ -0,0 +1,276 @@
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "debounce.h"
+
+// ========== DEBOUNCE REPLAY TEST ==========
+// Replays contact traces, one sample per scan tick, through debounce.c and
+// the key logic of scan_matrix() / m2_contact(): Note On when M2 turns on
+// while M1 is on, velocity from the M1 -> M2 edge times, Note Off when both
+// are off. Traces are written as strings, '#' = closed, '.' = open. They
+// are synthetic, shaped like rubber-dome contact bounce (short open pulses
+// right after each edge, a few ticks long), not recordings of a real
+// keyboard.
+
+#define TICK_US        1000
+#define TAIL_TICKS     300      // Open samples after every trace
+#define MAX_NOTES      256
+
+// The Kconfig defaults at a 1 ms scan period
+static const struct debounce_cfg m1_cfg = {
+    .release_ticks = 5,
+    .rearm_ticks = 3,
+    .hold_ticks = 250,
+};
+static const struct debounce_cfg m2_cfg = {
+    .release_ticks = 3,
+    .rearm_ticks = 3,
+};
+
+struct note {
+    bool on;
+    uint32_t time_us;
+    uint32_t travel_us;     // Note On: M1 -> M2 edge time (velocity)
+};
+
+static struct {
+    struct debounce_contact m1;
+    struct debounce_contact m2;
+    bool playing;
+} key;
+
+static struct note notes[MAX_NOTES];
+static int note_count;
+static int m2_without_m1;
+
+static void record(bool on, uint32_t time_us, uint32_t travel_us)
+{
+    zassert_true(note_count < MAX_NOTES, "too many notes");
+    notes[note_count++] = (struct note){ on, time_us, travel_us };
+}
+
+// m2_contact() in main.c
+static void m2_contact(uint32_t now_us)
+{
+    debounce_confirm_press(&key.m1, &m1_cfg);
+    debounce_end_hold(&key.m1);
+
+    if (key.m1.active && !key.playing) {
+        record(true, now_us, key.m2.edge_us - key.m1.edge_us);
+        key.playing = true;
+    } else if (!key.m1.active) {
+        m2_without_m1++;
+    }
+}
+
+static bool closed_at(const char *trace, size_t len, size_t tick)
+{
+    return tick < len && trace[tick] == '#';
+}
+
+static void replay_ticks(const char *m1, const char *m2, size_t tail)
+{
+    size_t m1_len = strlen(m1);
+    size_t m2_len = strlen(m2);
+    size_t len = MAX(m1_len, m2_len) + tail;
+
+    memset(&key, 0, sizeof(key));
+    note_count = 0;
+    m2_without_m1 = 0;
+
+    for (size_t t = 0; t < len; t++) {
+        uint32_t now = t * TICK_US;
+
+        debounce_sample(&key.m1, &m1_cfg, closed_at(m1, m1_len, t), now);
+        if (debounce_sample(&key.m2, &m2_cfg, closed_at(m2, m2_len, t), now) ==
+            DEBOUNCE_PRESS) {
+            m2_contact(now);
+        }
+        if (!key.m1.active && !key.m2.active && key.playing) {
+            record(false, now, 0);
+            key.playing = false;
+        }
+    }
+}
+
+static void replay(const char *m1, const char *m2)
+{
+    replay_ticks(m1, m2, TAIL_TICKS);
+}
+
+static void assert_strokes(int count)
+{
+    zassert_equal(note_count, 2 * count, "%d note events", note_count);
+    for (int i = 0; i < note_count; i++) {
+        zassert_equal(notes[i].on, (i % 2) == 0, "event %d out of order", i);
+    }
+}
+
+ZTEST(debounce, test_clean_stroke)
+{
+    replay("..############################....",
+           "......################..........");
+
+    assert_strokes(1);
+    zassert_equal(notes[0].travel_us, 4 * TICK_US);
+    // Note Off on the 5th open M1 sample: the hold ended when M2 landed
+    zassert_equal(notes[1].time_us, (30 + m1_cfg.release_ticks - 1) * TICK_US);
+}
+
+ZTEST(debounce, test_press_bounce)
+{
+    replay("..#.#.##.###################################",
+           "..........#.#..#.######################.....");
+
+    assert_strokes(1);
+    // Timed from the first closed sample of each contact
+    zassert_equal(notes[0].travel_us, 8 * TICK_US);
+}
+
+ZTEST(debounce, test_release_bounce)
+{
+    replay("##############################.#.##.#..#.....#.........",
+           "..####################.#.#.##..#....#..................");
+
+    assert_strokes(1);
+    zassert_equal(m2_without_m1, 0);
+}
+
+ZTEST(debounce, test_slow_press_m1_chatter)
+{
+    // M1 drops out for longer than its release window twice and is open
+    // when M2 lands: the press hold keeps the stroke and its start time
+    replay("..###.........#..#.......##########################",
+           "...........................#######################");
+
+    assert_strokes(1);
+    zassert_equal(m2_without_m1, 0);
+    zassert_equal(notes[0].travel_us, 25 * TICK_US);
+}
+
+ZTEST(debounce, test_slow_press_hold_expires)
+{
+    char m1[400];
+    char m2[400];
+
+    // A press that stalls with M1 open past the hold is a new stroke
+    memset(m1, '.', sizeof(m1));
+    memset(m2, '.', sizeof(m2));
+    memset(m1 + 2, '#', 3);
+    memset(m1 + 300, '#', 60);
+    memset(m2 + 320, '#', 30);
+    m1[sizeof(m1) - 1] = '\0';
+    m2[sizeof(m2) - 1] = '\0';
+    replay(m1, m2);
+
+    assert_strokes(1);
+    zassert_equal(notes[0].travel_us, 20 * TICK_US);
+}
+
+ZTEST(debounce, test_fast_repeat_m2_in_lockout)
+{
+    // M1 reopens for just its release window and closes again while it is
+    // still locked out; M2 of the repeat lands inside the lockout too
+    replay("##############################.....##############################",
+           "...####################..............#############.........");
+
+    assert_strokes(2);
+    zassert_equal(m2_without_m1, 0);
+    zassert_equal(notes[2].travel_us, 2 * TICK_US);
+}
+
+ZTEST(debounce, test_fast_repeat_m2_after_lockout)
+{
+    replay("##############################.....##############################",
+           "...####################.................##########.........");
+
+    assert_strokes(2);
+    // Timed from the first closed sample, not from the end of the lockout
+    zassert_equal(notes[2].travel_us, 5 * TICK_US);
+}
+
+ZTEST(debounce, test_half_press_plays_nothing)
+{
+    replay("..#####.#.##...................",
+           "");
+
+    assert_strokes(0);
+    zassert_false(key.m1.active, "M1 still held after the trace");
+}
+
+ZTEST(debounce, test_m2_without_m1)
+{
+    replay("",
+           "....######......");
+
+    assert_strokes(0);
+    zassert_equal(m2_without_m1, 1);
+}
+
+// Random strokes with random bounce on every edge: each must give exactly
+// one Note On timed from the first closed samples, and one Note Off
+static uint32_t rng = 0x12345678;
+
+static uint32_t next_random(uint32_t n)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng % n;
+}
+
+// Chatter after an edge: up to 3 one-tick pulses of the old level in the
+// first ticks after it
+static void bounce(char *trace, size_t at, char old_level)
+{
+    int pulses = next_random(4);
+
+    for (int i = 0; i < pulses; i++) {
+        trace[at + 1 + 2 * i] = old_level;
+    }
+}
+
+ZTEST(debounce, test_random_bounced_strokes)
+{
+    static char m1[16000];
+    static char m2[16000];
+    static uint32_t travel[100];
+    size_t t = 5;
+    int strokes = 0;
+
+    memset(m1, '.', sizeof(m1));
+    memset(m2, '.', sizeof(m2));
+
+    while (strokes < (int)ARRAY_SIZE(travel)) {
+        size_t m1_on = t;
+        size_t m2_on = m1_on + 8 + next_random(60);     // Travel, past M1 bounce
+        size_t m2_off = m2_on + 10 + next_random(40);
+        size_t m1_off = m2_off + 8 + next_random(20);
+
+        if (m1_off + 60 >= sizeof(m1)) {
+            break;
+        }
+        memset(m1 + m1_on, '#', m1_off - m1_on);
+        memset(m2 + m2_on, '#', m2_off - m2_on);
+        bounce(m1, m1_on, '.');
+        bounce(m2, m2_on, '.');
+        bounce(m2, m2_off, '#');
+        bounce(m1, m1_off, '#');
+
+        travel[strokes++] = (m2_on - m1_on) * TICK_US;
+        // Next stroke after the release window and re-arm, sometimes
+        // right at the edge of them
+        t = m1_off + 8 + m1_cfg.release_ticks + m1_cfg.rearm_ticks + next_random(30);
+    }
+    m1[t] = '\0';
+    m2[t] = '\0';
+
+    replay(m1, m2);
+
+    assert_strokes(strokes);
+    zassert_equal(m2_without_m1, 0);
+    for (int i = 0; i < strokes; i++) {
+        zassert_equal(notes[2 * i].travel_us, travel[i], "stroke %d", i);
+    }
+}
+
+ZTEST_SUITE(debounce, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,330 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include "kbd_state.h"
+#include "ble_config_service.h"
+#include "keyboard.h"
+
+// ========== KEYBOARD STATE TEST ==========
+// Drives kbd_state.c the way the scan thread does and stands in for the
+// Bluetooth host below it: two fake links whose notifications are only
+// taken by the "controller" when a test calls complete(). The notify work
+// runs on the system workqueue, so every change is followed by settle().
+// The counters are cumulative, so tests compare against a copy taken in
+// the before hook.
+
+struct bt_conn {
+    uint8_t index;
+    bool connected;
+    bool subscribed;
+    uint16_t mtu;
+    int notifies;                        // Notifications queued so far
+    bt_gatt_complete_func_t pending;     // Completion of the queued one
+    void *pending_data;
+    uint8_t last[KBD_STATE_MAX_LEN];     // Payload of the last one
+    size_t last_len;
+};
+
+static struct bt_conn conns[CONFIG_BT_MAX_CONN];
+static struct bt_gatt_attr key_state_attr;
+
+const struct bt_gatt_attr *ble_config_key_state_attr(void)
+{
+    return &key_state_attr;
+}
+
+uint8_t bt_conn_index(const struct bt_conn *conn)
+{
+    return conn->index;
+}
+
+void bt_conn_foreach(enum bt_conn_type type, void (*func)(struct bt_conn *conn, void *data),
+                     void *data)
+{
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        if (conns[i].connected) {
+            func(&conns[i], data);
+        }
+    }
+}
+
+bool bt_gatt_is_subscribed(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                           uint16_t ccc_type)
+{
+    return attr == &key_state_attr && conn->subscribed;
+}
+
+uint16_t bt_gatt_get_mtu(struct bt_conn *conn)
+{
+    return conn->mtu;
+}
+
+int bt_gatt_notify_cb(struct bt_conn *conn, struct bt_gatt_notify_params *params)
+{
+    zassert_is_null(conn->pending, "second notification in flight on link %u", conn->index);
+    conn->pending = params->func;
+    conn->pending_data = params->user_data;
+    memcpy(conn->last, params->data, params->len);
+    conn->last_len = params->len;
+    conn->notifies++;
+    return 0;
+}
+
+static struct bt_gatt_cb *gatt_cb;
+
+void bt_gatt_cb_register(struct bt_gatt_cb *cb)
+{
+    gatt_cb = cb;
+}
+
+// Let the notify work run
+static void settle(void)
+{
+    k_sleep(K_MSEC(1));
+}
+
+// The controller took the queued notification (connection event)
+static void complete(struct bt_conn *conn)
+{
+    bt_gatt_complete_func_t func = conn->pending;
+
+    zassert_not_null(func, "nothing in flight on link %u", conn->index);
+    conn->pending = NULL;
+    func(conn, conn->pending_data);
+    settle();
+}
+
+static uint16_t last_seq(const struct bt_conn *conn)
+{
+    return sys_get_le16(&conn->last[1]);
+}
+
+static struct kbd_state_stats base;
+
+static void *kbd_state_setup(void)
+{
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        conns[i].index = i;
+    }
+    kbd_state_init();
+    return NULL;
+}
+
+static void kbd_state_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Links down first, so the releases below are not sent anywhere
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        conns[i] = (struct bt_conn){ .index = i, .mtu = 23 };
+    }
+    for (int k = 0; k < NUM_KEYS; k++) {
+        kbd_state_set(k, 0);
+    }
+    settle();
+    kbd_state_get_stats(&base);
+}
+
+// Nothing may stay in flight into the next test
+static void kbd_state_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        while (conns[i].pending) {
+            complete(&conns[i]);
+        }
+    }
+}
+
+// Both links connected and subscribed, each with one notification taken
+// so that it is synced to the current snapshot. Changes made while the
+// links were down count as coalesced, so the baseline is taken again.
+static void sync_links(void)
+{
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        conns[i].connected = true;
+        conns[i].subscribed = true;
+    }
+    kbd_state_subscribed(true);
+    settle();
+    for (int i = 0; i < ARRAY_SIZE(conns); i++) {
+        if (conns[i].pending) {
+            complete(&conns[i]);
+        }
+    }
+    kbd_state_get_stats(&base);
+}
+
+// ========== ENCODING ==========
+
+ZTEST(kbd_state, test_encoding)
+{
+    uint8_t buf[KBD_STATE_MAX_LEN];
+    uint8_t vel[NUM_KEYS];
+
+    kbd_state_set(0, 100);
+    kbd_state_set(9, 1);
+    kbd_state_set(NUM_KEYS - 1, 127);
+
+    struct kbd_state_stats st;
+    kbd_state_get_stats(&st);
+    zassert_equal(st.held, 3);
+    zassert_equal((uint16_t)(st.seq - base.seq), 3);
+
+    size_t len = kbd_state_encode(buf);
+    zassert_equal(len, 4 + KBD_STATE_BITMAP + 3);
+    zassert_equal(buf[0], KBD_STATE_VERSION);
+    zassert_equal(sys_get_le16(&buf[1]), st.seq);
+    zassert_equal(buf[3], NUM_KEYS);
+
+    // Bit k = key k, LSB first; velocities follow in key order
+    uint8_t bitmap[KBD_STATE_BITMAP] = { 0 };
+    bitmap[0] |= BIT(0);
+    bitmap[9 / 8] |= BIT(9 % 8);
+    bitmap[(NUM_KEYS - 1) / 8] |= BIT((NUM_KEYS - 1) % 8);
+    zassert_mem_equal(&buf[4], bitmap, KBD_STATE_BITMAP);
+    zassert_equal(buf[4 + KBD_STATE_BITMAP], 100);
+    zassert_equal(buf[4 + KBD_STATE_BITMAP + 1], 1);
+    zassert_equal(buf[4 + KBD_STATE_BITMAP + 2], 127);
+
+    // A release drops the key from the bitmap and the velocity list
+    kbd_state_set(9, 0);
+    len = kbd_state_encode(buf);
+    zassert_equal(len, 4 + KBD_STATE_BITMAP + 2);
+    zassert_false(buf[4 + 9 / 8] & BIT(9 % 8));
+    zassert_equal(buf[4 + KBD_STATE_BITMAP + 1], 127);
+
+    zassert_equal(kbd_state_get(vel), sys_get_le16(&buf[1]));
+    zassert_equal(vel[0], 100);
+    zassert_equal(vel[9], 0);
+    zassert_equal(vel[NUM_KEYS - 1], 127);
+}
+
+ZTEST(kbd_state, test_unchanged_key_keeps_seq)
+{
+    struct kbd_state_stats st;
+
+    kbd_state_set(5, 64);
+    kbd_state_set(5, 64);      // Same velocity again
+    kbd_state_set(6, 0);       // Already up
+    kbd_state_set(NUM_KEYS, 1);    // Out of range
+    kbd_state_get_stats(&st);
+    zassert_equal((uint16_t)(st.seq - base.seq), 1);
+
+    kbd_state_set(5, 90);      // Restrike with another velocity
+    kbd_state_get_stats(&st);
+    zassert_equal((uint16_t)(st.seq - base.seq), 2);
+}
+
+// ========== NOTIFICATIONS ==========
+
+ZTEST(kbd_state, test_one_in_flight_per_link)
+{
+    struct bt_conn *a = &conns[0], *b = &conns[1];
+    struct kbd_state_stats st;
+
+    sync_links();
+    int a_sent = a->notifies, b_sent = b->notifies;
+
+    // First change goes out on both links at once
+    kbd_state_set(1, 80);
+    settle();
+    zassert_equal(a->notifies, a_sent + 1);
+    zassert_equal(b->notifies, b_sent + 1);
+
+    // Neither link has taken it: later changes wait (bt_gatt_notify_cb
+    // fails the test on a second one in flight)
+    kbd_state_set(2, 81);
+    kbd_state_set(3, 82);
+    kbd_state_set(4, 83);
+    settle();
+    zassert_equal(a->notifies, a_sent + 1);
+    zassert_equal(b->notifies, b_sent + 1);
+
+    // Link A takes it: it gets the latest state, the two changes in
+    // between folded in; link B is still waiting on its own
+    complete(a);
+    zassert_equal(a->notifies, a_sent + 2);
+    zassert_equal(b->notifies, b_sent + 1);
+    kbd_state_get_stats(&st);
+    zassert_equal(last_seq(a), st.seq);
+    zassert_equal(st.coalesced - base.coalesced, 2);
+
+    complete(b);
+    zassert_equal(b->notifies, b_sent + 2);
+    zassert_equal(last_seq(b), st.seq);
+    kbd_state_get_stats(&st);
+    zassert_equal(st.coalesced - base.coalesced, 4);
+
+    // Nothing new: taking those sends nothing more
+    complete(a);
+    complete(b);
+    zassert_equal(a->notifies, a_sent + 2);
+    zassert_equal(b->notifies, b_sent + 2);
+}
+
+ZTEST(kbd_state, test_unsubscribed_and_small_mtu)
+{
+    struct bt_conn *a = &conns[0];
+    struct kbd_state_stats st;
+
+    a->connected = true;
+    kbd_state_set(1, 80);
+    settle();
+    zassert_equal(a->notifies, 0, "sent without a subscription");
+
+    // 24 keys held do not fit a 23-byte ATT MTU; a larger MTU retries
+    a->subscribed = true;
+    for (int k = 0; k < NUM_KEYS; k++) {
+        kbd_state_set(k, 100);
+    }
+    kbd_state_subscribed(true);
+    settle();
+    zassert_equal(a->notifies, 0);
+    kbd_state_get_stats(&st);
+    zassert_true(st.too_big > base.too_big);
+
+    a->mtu = 3 + KBD_STATE_MAX_LEN;
+    gatt_cb->att_mtu_updated(a, a->mtu, a->mtu);
+    settle();
+    zassert_equal(a->notifies, 1);
+    zassert_equal(a->last_len, 4 + KBD_STATE_BITMAP + NUM_KEYS);
+}
+
+ZTEST(kbd_state, test_coalesced_across_seq_wrap)
+{
+    struct bt_conn *a = &conns[0];
+    struct kbd_state_stats st;
+
+    // Links down: walk the 16-bit sequence number up to just below 0xFFFF
+    kbd_state_get_stats(&st);
+    for (uint16_t seq = st.seq; seq != 0xFFF0; seq++) {
+        kbd_state_set(2, (seq & 1) ? 0 : 50);
+    }
+    sync_links();
+    int a_sent = a->notifies;
+
+    // One notification in flight, then changes that carry the sequence
+    // number past 0xFFFF before the link takes it
+    kbd_state_set(1, 80);
+    settle();
+    zassert_equal(last_seq(a), 0xFFF1);
+    for (int i = 0; i < 20; i++) {
+        kbd_state_set(3, (i & 1) ? 0 : 50);
+    }
+    settle();
+    zassert_equal(a->notifies, a_sent + 1);
+
+    complete(a);
+    zassert_equal(a->notifies, a_sent + 2);
+    zassert_equal(last_seq(a), 0x0005);
+    kbd_state_get_stats(&st);
+    zassert_equal(st.seq, 0x0005);
+    zassert_equal(st.coalesced - base.coalesced, 19);
+}
+
+ZTEST_SUITE(kbd_state, NULL, kbd_state_setup, kbd_state_before, kbd_state_after, NULL);
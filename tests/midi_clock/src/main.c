@@ -0,0 +1,277 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <stdlib.h>
+#include "midi_clock.h"
+
+// ========== MIDI CLOCK FOLLOWER TEST ==========
+// A simulated sender and link feed midi_clock.c. The sender plays clocks
+// at an exact tempo and stamps them with its own millisecond clock (which
+// may drift against ours); the link delivers them in batches on
+// connection events, can lose them, and adds a fixed delay. The follower
+// is then asked, as the arpeggiator does, where the next beat falls and
+// where the song is now, and compared with the sender's true timing.
+//
+// Arrival times are passed in explicitly and lie in the future of the
+// kernel clock, so the follower's timeout never expires mid-test. Each
+// test starts far enough after the previous one to begin from scratch.
+
+#define LATENCY_US      1500         // Fixed part of the transport delay
+#define SETTLE_CLOCKS   (4 * MIDI_CLOCK_PPQN)
+#define TEST_GAP_US     (600LL * 1000000)
+
+struct link {
+    uint32_t interval_us;   // Connection interval
+    int32_t drift_ppm;      // Sender's clock against ours
+    uint32_t loss_pct;      // Connection events lost
+};
+
+struct result {
+    int64_t max_beat_err_us;     // Predicted local time of the next beat
+    int64_t max_pos_err_us;      // Song position at a clock's true time
+    int32_t tempo_err_x100;      // At the end
+    uint32_t settled_relocks;    // Relock count once settled
+    struct midi_clock_status status;
+};
+
+static int64_t epoch_us;     // Local time the current test starts at
+static struct midi_clock_status base;
+static uint32_t rng = 0x2468ACE1;
+
+static uint32_t next_random(uint32_t n)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng % n;
+}
+
+static int64_t ticks(int64_t us)
+{
+    return (int64_t)k_us_to_ticks_floor64(us);
+}
+
+static void send(uint8_t source, uint8_t status, int64_t sender_us, int64_t rx_us)
+{
+    midi_clock_input(source, status, (uint16_t)((sender_us / 1000) & 0x1FFF), ticks(rx_us));
+}
+
+static void midi_clock_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Past the timeout of whatever the last test left behind
+    epoch_us += TEST_GAP_US;
+    midi_clock_get_status(&base);
+}
+
+// Sender time of a local time: its own origin, and drift
+static int64_t sender_time(const struct link *l, int64_t local_us)
+{
+    return 5000000 + (local_us - epoch_us) * (1000000 + l->drift_ppm) / 1000000;
+}
+
+// Connection event a message sent at local_us rides on
+static int64_t arrival(const struct link *l, int64_t local_us)
+{
+    int64_t ci = l->interval_us;
+
+    return (local_us + ci - 1) / ci * ci + LATENCY_US;
+}
+
+// Start, then `clocks` clocks at period_us from local time start_us.
+// Every clock is checked once the loop has settled.
+static void play(const struct link *l, int64_t start_us, uint32_t period_us, int clocks,
+                 struct result *r)
+{
+    int64_t beat_us = (int64_t)period_us * MIDI_CLOCK_PPQN;
+    int64_t rx_start = arrival(l, start_us);
+
+    memset(r, 0, sizeof(*r));
+    send(0, 0xFA, sender_time(l, start_us), rx_start);
+
+    // Clock n (from 0, the first after Start) leaves at start + n periods
+    for (int n = 0; n < clocks; n++) {
+        int64_t sent = start_us + period_us + (int64_t)n * period_us;
+        int64_t rx = arrival(l, sent);
+
+        // Lost events take every clock that was to ride on them
+        if (next_random(100) < l->loss_pct) {
+            continue;
+        }
+        send(0, 0xF8, sender_time(l, sent), rx);
+
+        if (n < SETTLE_CLOCKS) {
+            continue;
+        }
+        if (n == SETTLE_CLOCKS) {
+            struct midi_clock_status st;
+
+            midi_clock_get_status(&st);
+            r->settled_relocks = st.relocks;
+        }
+
+        int64_t pos_q16;
+        zassert_true(midi_clock_position(ticks(sent + LATENCY_US), &pos_q16),
+                     "not running at clock %d", n);
+
+        // Song position at the clock's own (delayed) time: n clocks
+        int64_t pos_err_q16 = pos_q16 - ((int64_t)n << 16) / MIDI_CLOCK_PPQN;
+        int64_t pos_err_us = pos_err_q16 * beat_us / 65536;
+        r->max_pos_err_us = MAX(r->max_pos_err_us, llabs(pos_err_us));
+
+        // Where the next beat falls, as the arpeggiator asks
+        int64_t beat = n / MIDI_CLOCK_PPQN + 1;
+        int64_t beat_true = start_us + period_us + beat * beat_us + LATENCY_US;
+        int64_t beat_pred = (int64_t)k_ticks_to_us_floor64(midi_clock_time_of(beat << 16));
+        r->max_beat_err_us = MAX(r->max_beat_err_us, llabs(beat_pred - beat_true));
+    }
+
+    midi_clock_get_status(&r->status);
+    r->tempo_err_x100 = (int32_t)r->status.tempo_x100 -
+                        (int32_t)(6000000000LL / ((int64_t)period_us * MIDI_CLOCK_PPQN));
+}
+
+// Batching by connection events does not reach the loop: what is left is
+// the 1 ms timestamp resolution. Arrival times alone would be off by up
+// to a whole connection interval.
+ZTEST(midi_clock, test_connection_interval_quantisation)
+{
+    static const uint32_t intervals_us[] = { 7500, 15000, 30000, 45000 };
+    struct result r;
+
+    for (int i = 0; i < (int)ARRAY_SIZE(intervals_us); i++) {
+        struct link l = { .interval_us = intervals_us[i] };
+
+        epoch_us += TEST_GAP_US;
+        play(&l, epoch_us, 20833, 40 * MIDI_CLOCK_PPQN, &r);   // 120 BPM
+
+        zassert_true(r.status.running);
+        zassert_within(r.tempo_err_x100, 0, 5, "CI %u us: %d", l.interval_us,
+                       r.tempo_err_x100);
+        zassert_true(r.max_beat_err_us <= 1500, "CI %u us: beat off by %lld us",
+                     l.interval_us, r.max_beat_err_us);
+        zassert_true(r.max_pos_err_us <= 1500, "CI %u us: position off by %lld us",
+                     l.interval_us, r.max_pos_err_us);
+    }
+}
+
+ZTEST(midi_clock, test_loss)
+{
+    struct link l = { .interval_us = 15000, .loss_pct = 5 };
+    struct result r;
+
+    play(&l, epoch_us, 25000, 60 * MIDI_CLOCK_PPQN, &r);   // 100 BPM
+
+    // Lost clocks are bridged, not taken as a tempo change
+    zassert_true(r.status.missed - base.missed > 0);
+    zassert_equal(r.status.relocks, r.settled_relocks);
+    zassert_within(r.tempo_err_x100, 0, 5, "%d", r.tempo_err_x100);
+    zassert_true(r.max_beat_err_us <= 2000, "beat off by %lld us", r.max_beat_err_us);
+    zassert_true(r.max_pos_err_us <= 2000, "position off by %lld us", r.max_pos_err_us);
+}
+
+ZTEST(midi_clock, test_drift)
+{
+    static const int32_t drift_ppm[] = { -100, -20, 20, 100 };
+    struct result r;
+
+    for (int i = 0; i < (int)ARRAY_SIZE(drift_ppm); i++) {
+        struct link l = { .interval_us = 30000, .drift_ppm = drift_ppm[i] };
+
+        epoch_us += TEST_GAP_US;
+        // Long enough for the delay estimate to follow the drift
+        play(&l, epoch_us, 20833, 200 * MIDI_CLOCK_PPQN, &r);
+
+        zassert_within(r.tempo_err_x100, 0, 5, "%d ppm: %d", drift_ppm[i],
+                       r.tempo_err_x100);
+        // Timestamp quantisation, plus the delay estimate catching up
+        // with the drift in OFFSET_LEAK_US steps
+        zassert_true(r.max_beat_err_us <= 2500, "%d ppm: beat off by %lld us",
+                     drift_ppm[i], r.max_beat_err_us);
+        zassert_true(r.max_pos_err_us <= 2500, "%d ppm: position off by %lld us",
+                     drift_ppm[i], r.max_pos_err_us);
+    }
+}
+
+ZTEST(midi_clock, test_tempo_change_relocks)
+{
+    struct link l = { .interval_us = 15000 };
+    struct result r;
+
+    play(&l, epoch_us, 20833, 8 * MIDI_CLOCK_PPQN, &r);     // 120 BPM
+
+    // Jump to 90 BPM without a new Start: the loop relocks and the song
+    // position carries on
+    int64_t t = epoch_us + 20833LL * (8 * MIDI_CLOCK_PPQN + 1);
+    struct midi_clock_status st;
+
+    for (int n = 0; n < 2 * MIDI_CLOCK_PPQN; n++) {
+        int64_t sent = t + (n + 1) * 27778LL;
+
+        send(0, 0xF8, sender_time(&l, sent), arrival(&l, sent));
+    }
+    midi_clock_get_status(&st);
+    zassert_true(st.relocks > r.status.relocks);
+    zassert_within(st.tempo_x100, 9000, 10, "%u", st.tempo_x100);
+
+    int64_t pos_q16;
+    zassert_true(midi_clock_position(ticks(t + 2 * MIDI_CLOCK_PPQN * 27778LL + LATENCY_US),
+                                     &pos_q16));
+    zassert_within(pos_q16 >> 16, 10, 1, "beat %lld", pos_q16 >> 16);
+}
+
+ZTEST(midi_clock, test_start_stop)
+{
+    struct link l = { .interval_us = 7500 };
+    int64_t pos_q16;
+    struct result r;
+
+    play(&l, epoch_us, 20833, 2 * MIDI_CLOCK_PPQN, &r);
+    int64_t t = epoch_us + 20833LL * (2 * MIDI_CLOCK_PPQN + 1);
+
+    zassert_true(midi_clock_position(ticks(t), &pos_q16));
+    zassert_within(pos_q16, 2 << 16, 1 << 12);
+
+    // Stop: not running, while the sender's clock keeps ticking
+    send(0, 0xFC, sender_time(&l, t), arrival(&l, t));
+    zassert_false(midi_clock_position(ticks(t), &pos_q16));
+    for (int n = 0; n < MIDI_CLOCK_PPQN; n++) {
+        t += 20833;
+        send(0, 0xF8, sender_time(&l, t), arrival(&l, t));
+    }
+
+    // Start: until the next clock the position is just below beat 0
+    send(0, 0xFA, sender_time(&l, t + 5000), arrival(&l, t + 5000));
+    zassert_true(midi_clock_position(ticks(t + 10000), &pos_q16));
+    zassert_true(pos_q16 < 0 && pos_q16 > -(1 << 16) / MIDI_CLOCK_PPQN, "%lld", pos_q16);
+
+    t += 20833;
+    send(0, 0xF8, sender_time(&l, t), arrival(&l, t));
+    zassert_true(midi_clock_position(ticks(t + LATENCY_US), &pos_q16));
+    zassert_within(pos_q16, 0, 1 << 10, "%lld", pos_q16);
+    zassert_within((int64_t)k_ticks_to_us_floor64(midi_clock_time_of(1 << 16)),
+                   t + LATENCY_US + 24 * 20833LL, 1500);
+}
+
+ZTEST(midi_clock, test_second_source_ignored)
+{
+    struct link l = { .interval_us = 15000 };
+    struct result r;
+
+    play(&l, epoch_us, 20833, 8 * MIDI_CLOCK_PPQN, &r);
+    int64_t t = epoch_us + 20833LL * (8 * MIDI_CLOCK_PPQN + 1);
+
+    // Another central's Stop and clocks while the first one is ticking
+    midi_clock_input(1, 0xFC, 0, ticks(arrival(&l, t)));
+    for (int n = 0; n < 10; n++) {
+        midi_clock_input(1, 0xF8, n * 7, ticks(arrival(&l, t + n * 7000)));
+    }
+
+    struct midi_clock_status st;
+    midi_clock_get_status(&st);
+    zassert_true(st.running);
+    zassert_within(st.tempo_x100, 12000, 5);
+    zassert_equal(st.ticks - r.status.ticks, 0);
+}
+
+ZTEST_SUITE(midi_clock, NULL, NULL, midi_clock_before, NULL, NULL);
@@ -0,0 +1,311 @@
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include "pedal_filter.h"
+
+// ========== PEDAL FILTER TEST ==========
+// Raw sample streams for a 12-bit ADC, one sample per millisecond, cut
+// into batches as pedals.c does and run through pedal_filter.c. Noise is
+// uniform, up to NOISE counts either way on every sample; a 7-bit step
+// is about 32 counts.
+
+#define BATCH       16          // PEDAL_BATCH
+#define FULL        4095
+#define NOISE       20
+#define MAX_SENT    512
+
+static const struct pedal_filter_cfg expression = {
+    .raw_min = 0,
+    .raw_max = FULL,
+    .hysteresis = 8,            // The devicetree defaults
+    .threshold = 1,
+};
+static const struct pedal_filter_cfg sustain = {
+    .raw_min = 0,
+    .raw_max = FULL,
+    .is_switch = true,
+};
+
+static struct pedal_filter filter;
+static uint8_t sent[MAX_SENT];
+static int sent_count;
+static uint32_t rng;
+
+static int32_t noise(int32_t amplitude)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (int32_t)(rng % (2 * amplitude + 1)) - amplitude;
+}
+
+static int16_t sample(int32_t level, int32_t amplitude)
+{
+    return CLAMP(level + noise(amplitude), 0, FULL);
+}
+
+static void run_batch(const struct pedal_filter_cfg *cfg, const int16_t *samples)
+{
+    uint8_t value;
+
+    if (pedal_filter_batch(&filter, cfg, samples, BATCH, 1, &value)) {
+        zassert_true(sent_count < MAX_SENT, "too many CCs");
+        sent[sent_count++] = value;
+    }
+}
+
+// `batches` batches of a pedal held at `level`
+static void hold(const struct pedal_filter_cfg *cfg, int32_t level, int batches)
+{
+    int16_t samples[BATCH];
+
+    for (int b = 0; b < batches; b++) {
+        for (int i = 0; i < BATCH; i++) {
+            samples[i] = sample(level, NOISE);
+        }
+        run_batch(cfg, samples);
+    }
+}
+
+static void pedal_filter_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    pedal_filter_init(&filter);
+    sent_count = 0;
+    rng = 0x13579BDF;
+}
+
+// ========== EXPRESSION ==========
+
+ZTEST(pedal_filter, test_first_batch_reports)
+{
+    hold(&expression, 0, 1);
+
+    zassert_equal(sent_count, 1);
+    zassert_equal(sent[0], 0);
+}
+
+ZTEST(pedal_filter, test_noisy_pot_at_rest)
+{
+    // Anywhere on the travel, including right on a step boundary: one CC
+    // when the pedal is first read, then silence
+    static const int32_t levels[] = { 1000, 2048, 3000,
+                                      (int32_t)(40.5 * FULL / 127) };
+
+    for (int i = 0; i < (int)ARRAY_SIZE(levels); i++) {
+        pedal_filter_init(&filter);
+        sent_count = 0;
+        hold(&expression, levels[i], 1000);
+
+        zassert_equal(sent_count, 1, "level %d: %d CCs", levels[i], sent_count);
+        zassert_within(sent[0], levels[i] * 127 / FULL, 1);
+    }
+}
+
+ZTEST(pedal_filter, test_noisier_pot)
+{
+    // Three times the noise right on a step boundary: with the default dead band
+    // the value may flicker around the level; a wider one
+    // (expression-hysteresis) silences it
+    struct pedal_filter_cfg wide = expression;
+    int16_t samples[BATCH];
+    int32_t level = 2048;       // 63.5 steps
+    int flicker;
+
+    wide.hysteresis = 24;
+    for (int pass = 0; pass < 2; pass++) {
+        const struct pedal_filter_cfg *cfg = pass ? &wide : &expression;
+
+        pedal_filter_init(&filter);
+        sent_count = 0;
+        for (int b = 0; b < 1000; b++) {
+            for (int i = 0; i < BATCH; i++) {
+                samples[i] = sample(level, 3 * NOISE);
+            }
+            run_batch(cfg, samples);
+        }
+        for (int i = 0; i < sent_count; i++) {
+            zassert_between_inclusive(sent[i], 62, 65, "CC %d = %u", i, sent[i]);
+        }
+        if (pass == 0) {
+            flicker = sent_count;
+        }
+    }
+    zassert_equal(sent_count, 1, "%d CCs with the wide dead band", sent_count);
+    zassert_true(flicker < 100, "%d CCs", flicker);
+}
+
+// Heel to toe and back over `batches` batches each way
+static void sweep(const struct pedal_filter_cfg *cfg, int batches)
+{
+    for (int b = 0; b <= batches; b++) {
+        hold(cfg, (int32_t)b * FULL / batches, 1);
+    }
+    for (int b = batches; b >= 0; b--) {
+        hold(cfg, (int32_t)b * FULL / batches, 1);
+    }
+}
+
+ZTEST(pedal_filter, test_sweep)
+{
+    int top = 0;
+
+    sweep(&expression, 400);
+
+    // Up to 127 and back to 0, each way without a step backwards
+    for (int i = 0; i < sent_count; i++) {
+        if (sent[i] == 127) {
+            top = i;
+            break;
+        }
+        zassert_true(i == 0 || sent[i] > sent[i - 1], "up: CC %d = %u", i, sent[i]);
+    }
+    zassert_equal(sent[top], 127);
+    zassert_true(top > 100, "only %d CCs up", top);
+    for (int i = top + 1; i < sent_count; i++) {
+        zassert_true(sent[i] < sent[i - 1], "down: CC %d = %u", i, sent[i]);
+    }
+    zassert_equal(sent[sent_count - 1], 0);
+}
+
+ZTEST(pedal_filter, test_fast_sweep)
+{
+    // Heel to toe in 10 batches: few CCs, but the end stops are reached
+    sweep(&expression, 10);
+
+    zassert_true(sent_count <= 22);
+    zassert_true(memchr(sent, 127, sent_count) != NULL);
+    zassert_equal(sent[sent_count - 1], 0);
+}
+
+ZTEST(pedal_filter, test_threshold)
+{
+    struct pedal_filter_cfg coarse = expression;
+
+    coarse.threshold = 4;
+    sweep(&coarse, 400);
+
+    // Coarser steps, but still fully on and off
+    for (int i = 1; i < sent_count; i++) {
+        if (sent[i] != 0 && sent[i] != 127) {
+            zassert_true(abs(sent[i] - sent[i - 1]) >= 4, "CC %d: %u after %u",
+                         i, sent[i], sent[i - 1]);
+        }
+    }
+    zassert_true(memchr(sent, 127, sent_count) != NULL);
+    zassert_equal(sent[sent_count - 1], 0);
+    zassert_true(sent_count < 80, "%d CCs", sent_count);
+}
+
+ZTEST(pedal_filter, test_end_stops_snap)
+{
+    // A pot that stops short of both rails still reaches 0 and 127
+    hold(&expression, 3 * FULL / 4, 1);
+    hold(&expression, FULL - 25, 5);
+    zassert_equal(sent[sent_count - 1], 127);
+    hold(&expression, 25, 5);
+    zassert_equal(sent[sent_count - 1], 0);
+}
+
+ZTEST(pedal_filter, test_reversed_range_and_stride)
+{
+    struct pedal_filter_cfg reversed = expression;
+    int16_t interleaved[2 * BATCH];
+    uint8_t value;
+
+    reversed.raw_min = FULL;
+    reversed.raw_max = 0;
+
+    // Every other sample belongs to another channel
+    for (int i = 0; i < BATCH; i++) {
+        interleaved[2 * i] = 0;
+        interleaved[2 * i + 1] = FULL;
+    }
+    zassert_true(pedal_filter_batch(&filter, &reversed, interleaved, BATCH, 2, &value));
+    zassert_equal(value, 127);
+    zassert_equal(filter.average, 0);
+}
+
+// ========== SUSTAIN ==========
+
+// Strokes of a sustain switch with contact bounce: up to `pulses` one
+// sample pulses of the old level in the first `window` samples after
+// each edge, plus noise
+static void bouncing_strokes(int strokes, int pulses, int window)
+{
+    int16_t trace[BATCH * 64];
+    int len = 0;
+
+    for (int s = 0; s < strokes; s++) {
+        int down = 40 + abs(noise(200));
+        int up = 40 + abs(noise(200));
+        bool level = false;
+        int run = 0;
+
+        // One stroke: released for `up` ms, pressed for `down` ms
+        for (int t = 0; t < up + down; t++) {
+            bool pressed = t >= up;
+            int since = pressed ? t - up : t;
+
+            if (pressed != level) {
+                level = pressed;
+                run = 0;
+            }
+            bool bounce = since < window && run < pulses && (noise(1) != 0);
+            if (bounce) {
+                run++;
+            }
+            bool closed = bounce ? !pressed : pressed;
+
+            trace[len++] = sample(closed ? FULL - 300 : 300, NOISE);
+            if (len == ARRAY_SIZE(trace) || (s == strokes - 1 && t == up + down - 1)) {
+                for (int b = 0; b + BATCH <= len; b += BATCH) {
+                    run_batch(&sustain, &trace[b]);
+                }
+                // Carry a partial batch over
+                int rest = len % BATCH;
+                memmove(trace, &trace[len - rest], rest * sizeof(trace[0]));
+                len = rest;
+            }
+        }
+    }
+}
+
+ZTEST(pedal_filter, test_bouncing_sustain)
+{
+    // Up to 3 pulses in 6 ms on every edge, then a worn switch with up to
+    // 8 in 14 ms: one CC64 on and one off per stroke either way
+    for (int worn = 0; worn < 2; worn++) {
+        pedal_filter_init(&filter);
+        sent_count = 0;
+        if (worn) {
+            bouncing_strokes(200, 8, 14);
+        } else {
+            bouncing_strokes(200, 3, 6);
+        }
+
+        // Released first, pressed last
+        zassert_equal(sent_count, 2 * 200, "%d CCs", sent_count);
+        for (int i = 0; i < sent_count; i++) {
+            zassert_equal(sent[i], (i % 2) ? 127 : 0, "CC %d = %u", i, sent[i]);
+        }
+    }
+}
+
+ZTEST(pedal_filter, test_sustain_half_press)
+{
+    // Resting between the thresholds changes nothing, either way
+    hold(&sustain, FULL / 2, 10);
+    zassert_equal(sent_count, 1);
+    zassert_equal(sent[0], 0);
+
+    hold(&sustain, FULL, 1);
+    hold(&sustain, FULL / 2, 10);
+    zassert_equal(sent_count, 2);
+    zassert_equal(sent[1], 127);
+
+    hold(&sustain, FULL / 4, 1);
+    zassert_equal(sent[sent_count - 1], 0);
+}
+
+ZTEST_SUITE(pedal_filter, NULL, NULL, pedal_filter_before, NULL, NULL);
@@ -0,0 +1,221 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include "pedals.h"
+#include "recorder.h"
+#include "ble_midi_service.h"
+
+// ========== PEDALS TEST ==========
+// Runs pedals.c on the native_sim emulated ADC (boards/native_sim.overlay:
+// sustain on channel 0, expression on channel 1). Each channel reads a
+// waveform of simulated time, so the pedal thread samples it exactly as
+// it would a real jack; the CCs it sends are caught by the
+// recorder_log() / ble_midi_send_event() stubs below.
+
+#define ADC_NODE    DT_NODELABEL(adc0)
+#define CH_SUSTAIN  0
+#define CH_EXPR     1
+#define FULL        4095
+#define NOISE       20
+#define MAX_CC      256
+
+struct cc {
+    uint8_t number;
+    uint8_t value;
+};
+
+static struct cc ccs[MAX_CC];
+static atomic_t cc_count;
+static atomic_t queued;
+
+void recorder_log(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    int i = atomic_inc(&cc_count);
+
+    ARG_UNUSED(status);
+    if (i < MAX_CC) {
+        ccs[i] = (struct cc){ data1, data2 };
+    }
+}
+
+int ble_midi_send_event(uint8_t status, uint8_t data1, uint8_t data2, uint32_t capture_cyc)
+{
+    ARG_UNUSED(status);
+    ARG_UNUSED(data1);
+    ARG_UNUSED(data2);
+    ARG_UNUSED(capture_cyc);
+
+    atomic_inc(&queued);
+    return 0;
+}
+
+// ========== WAVEFORMS ==========
+// From `from` to `to` at `start_ms`: a linear ramp over ramp_ms, or a
+// step with contact bounce (the old level on every other millisecond)
+// for bounce_ms; uniform noise on top
+struct wave {
+    int32_t from;
+    int32_t to;
+    int64_t start_ms;
+    uint32_t ramp_ms;
+    uint32_t bounce_ms;
+};
+
+static struct wave waves[2];
+static struct k_spinlock wave_lock;     // The ADC reads them in its own thread
+static uint32_t rng = 0x2468ACE1;
+
+static int32_t noise(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (int32_t)(rng % (2 * NOISE + 1)) - NOISE;
+}
+
+static int wave_value(const struct device *dev, unsigned int chan, void *data,
+                      uint32_t *result)
+{
+    k_spinlock_key_t key = k_spin_lock(&wave_lock);
+    struct wave w = *(const struct wave *)data;
+
+    k_spin_unlock(&wave_lock, key);
+
+    int64_t t = k_uptime_get() - w.start_ms;
+    int32_t level;
+
+    ARG_UNUSED(dev);
+    ARG_UNUSED(chan);
+
+    if (t < 0) {
+        level = w.from;
+    } else if (t < w.ramp_ms) {
+        level = w.from + (w.to - w.from) * (int32_t)t / (int32_t)w.ramp_ms;
+    } else if (t < w.bounce_ms && (t & 1)) {
+        level = w.from;
+    } else {
+        level = w.to;
+    }
+    *result = CLAMP(level + noise(), 0, FULL);
+    return 0;
+}
+
+static void set_wave(int chan, int32_t to, uint32_t ramp_ms, uint32_t bounce_ms)
+{
+    struct wave *w = &waves[chan];
+    k_spinlock_key_t key = k_spin_lock(&wave_lock);
+
+    // From wherever the last wave ended
+    w->from = w->to;
+    w->to = to;
+    w->ramp_ms = ramp_ms;
+    w->bounce_ms = bounce_ms;
+    w->start_ms = k_uptime_get();
+    k_spin_unlock(&wave_lock, key);
+}
+
+// CCs of one controller sent since the test started
+static int collect(uint8_t number, uint8_t *values, int max)
+{
+    int n = 0;
+
+    for (int i = 0; i < MIN(atomic_get(&cc_count), MAX_CC); i++) {
+        if (ccs[i].number == number && n < max) {
+            values[n++] = ccs[i].value;
+        }
+    }
+    return n;
+}
+
+static void *pedals_setup(void)
+{
+    const struct device *adc = DEVICE_DT_GET(ADC_NODE);
+
+    zassert_true(device_is_ready(adc));
+    for (int chan = 0; chan < 2; chan++) {
+        zassert_ok(adc_emul_value_func_set(adc, chan, wave_value, &waves[chan]));
+    }
+    pedals_start();
+    return NULL;
+}
+
+static void pedals_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Both pedals up and settled, then start counting
+    set_wave(CH_SUSTAIN, 0, 0, 0);
+    set_wave(CH_EXPR, 0, 0, 0);
+    k_msleep(200);
+    atomic_set(&cc_count, 0);
+    atomic_set(&queued, 0);
+}
+
+ZTEST(pedals, test_noisy_rest_is_quiet)
+{
+    struct pedals_stats st;
+
+    set_wave(CH_EXPR, FULL / 3, 0, 0);
+    k_msleep(1000);
+
+    uint8_t v[MAX_CC];
+    int n = collect(11, v, ARRAY_SIZE(v));
+
+    zassert_equal(n, 1, "%d CC11s", n);
+    zassert_within(v[0], 127 / 3, 1);
+    zassert_equal(collect(64, v, ARRAY_SIZE(v)), 0);
+    zassert_equal(atomic_get(&queued), atomic_get(&cc_count));
+
+    pedals_get_stats(&st);
+    zassert_equal(st.count, 2);
+    zassert_equal(st.errors, 0);
+    zassert_true(st.batches > 0);
+    zassert_within(st.pedal[1].raw, FULL / 3, NOISE);
+}
+
+ZTEST(pedals, test_expression_sweep)
+{
+    uint8_t v[MAX_CC];
+
+    set_wave(CH_EXPR, FULL, 2000, 0);
+    k_msleep(2200);
+    set_wave(CH_EXPR, 0, 2000, 0);
+    k_msleep(2200);
+
+    int n = collect(11, v, ARRAY_SIZE(v));
+    int top = 0;
+
+    while (top < n && v[top] != 127) {
+        zassert_true(top == 0 || v[top] > v[top - 1], "up: CC %d = %u", top, v[top]);
+        top++;
+    }
+    zassert_true(top < n, "never reached 127");
+    zassert_true(top > 60, "only %d CCs up", top);
+    for (int i = top + 1; i < n; i++) {
+        zassert_true(v[i] < v[i - 1], "down: CC %d = %u", i, v[i]);
+    }
+    zassert_equal(v[n - 1], 0);
+}
+
+ZTEST(pedals, test_bouncing_sustain)
+{
+    uint8_t v[MAX_CC];
+
+    // 6 ms of contact bounce on every edge, 10 strokes
+    for (int s = 0; s < 10; s++) {
+        set_wave(CH_SUSTAIN, FULL - 300, 0, 6);
+        k_msleep(150);
+        set_wave(CH_SUSTAIN, 300, 0, 6);
+        k_msleep(150);
+    }
+
+    int n = collect(64, v, ARRAY_SIZE(v));
+
+    zassert_equal(n, 20, "%d CC64s", n);
+    for (int i = 0; i < n; i++) {
+        zassert_equal(v[i], (i % 2) ? 0 : 127, "CC %d = %u", i, v[i]);
+    }
+    zassert_equal(collect(11, v, ARRAY_SIZE(v)), 0);
+}
+
+ZTEST_SUITE(pedals, NULL, pedals_setup, pedals_before, NULL, NULL);
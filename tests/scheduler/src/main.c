@@ -0,0 +1,266 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include "scheduler.h"
+#include "ble_midi_service.h"
+#include "recorder.h"
+
+// ========== SCHEDULER TEST ==========
+// Posts MIDI messages and calls on the real kernel timer and checks the
+// order and time they come out in. Dispatched messages are caught by the
+// recorder_log() / ble_midi_send_event() stubs below; data1 and data2 of
+// each message carry the index it was posted with.
+
+#define MAX_FIRED  (2 * SCHED_MAX_EVENTS)
+
+struct fired {
+    int64_t due;            // Calls only
+    int64_t at;
+    uint16_t id;
+    bool call;
+};
+
+static struct fired fired[MAX_FIRED];
+static int fired_count;
+static int sent_count;
+
+static void fire(int64_t due, uint16_t id, bool call)
+{
+    if (fired_count < MAX_FIRED) {
+        fired[fired_count] = (struct fired){ due, scheduler_now(), id, call };
+    }
+    fired_count++;
+}
+
+void recorder_log(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    ARG_UNUSED(status);
+
+    fire(0, data1 | (data2 << 7), false);
+}
+
+int ble_midi_send_event(uint8_t status, uint8_t data1, uint8_t data2, uint32_t capture_cyc)
+{
+    ARG_UNUSED(status);
+    ARG_UNUSED(data1);
+    ARG_UNUSED(data2);
+    ARG_UNUSED(capture_cyc);
+
+    sent_count++;
+    return 0;
+}
+
+static void call_a(int64_t due)
+{
+    fire(due, 0xA, true);
+}
+
+static void call_b(int64_t due)
+{
+    fire(due, 0xB, true);
+}
+
+static uint32_t rng = 0x12345678;
+
+static uint32_t next_random(uint32_t n)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng % n;
+}
+
+static int64_t ms(int n)
+{
+    return k_ms_to_ticks_ceil64(n);
+}
+
+static int post_id(int64_t due, uint16_t id)
+{
+    return scheduler_post_midi(due, 0x90, id & 0x7F, id >> 7);
+}
+
+static void scheduler_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    // Nothing pending from an earlier test
+    scheduler_cancel_call(call_a);
+    scheduler_cancel_call(call_b);
+    k_sleep(K_MSEC(200));
+    fired_count = 0;
+    sent_count = 0;
+    scheduler_reset_stats();
+}
+
+ZTEST(scheduler, test_due_order)
+{
+    int64_t now = scheduler_now();
+    int64_t due[SCHED_MAX_EVENTS];
+
+    // A full heap of random due times, many of them equal
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        due[i] = now + ms(20) + ms(next_random(16)) * 2;
+        zassert_ok(post_id(due[i], i));
+    }
+    k_sleep(K_MSEC(100));
+
+    zassert_equal(fired_count, SCHED_MAX_EVENTS);
+    zassert_equal(sent_count, SCHED_MAX_EVENTS);
+    for (int i = 0; i < fired_count; i++) {
+        const struct fired *f = &fired[i];
+
+        zassert_true(f->at >= due[f->id], "event %u fired early", f->id);
+        zassert_true(f->at - due[f->id] <= ms(1), "event %u fired late", f->id);
+        if (i > 0) {
+            const struct fired *p = &fired[i - 1];
+
+            zassert_true(due[p->id] <= due[f->id], "event %u before %u", p->id, f->id);
+            if (due[p->id] == due[f->id]) {
+                zassert_true(p->id < f->id, "equal due times not in post order");
+            }
+        }
+    }
+
+    struct sched_stats st;
+
+    scheduler_get_stats(&st);
+    zassert_equal(st.dispatched, SCHED_MAX_EVENTS);
+    zassert_equal(st.max_depth, SCHED_MAX_EVENTS);
+    zassert_equal(st.depth, 0);
+    zassert_equal(st.dropped, 0);
+}
+
+ZTEST(scheduler, test_full_heap)
+{
+    int64_t due = scheduler_now() + ms(10);
+    struct sched_stats st;
+
+    for (int i = 0; i < SCHED_MAX_EVENTS; i++) {
+        zassert_ok(post_id(due, i));
+    }
+    zassert_equal(post_id(due, SCHED_MAX_EVENTS), -ENOMEM);
+    zassert_equal(scheduler_post_call(due, call_a), -ENOMEM);
+
+    scheduler_get_stats(&st);
+    zassert_equal(st.dropped, 2);
+    zassert_equal(st.depth, SCHED_MAX_EVENTS);
+
+    k_sleep(K_MSEC(50));
+    zassert_equal(fired_count, SCHED_MAX_EVENTS);
+}
+
+ZTEST(scheduler, test_past_due_fires_now)
+{
+    int64_t now = scheduler_now();
+
+    zassert_ok(post_id(now + ms(30), 1));
+    zassert_ok(post_id(now - ms(5), 2));
+    k_sleep(K_MSEC(5));
+
+    zassert_equal(fired_count, 1);
+    zassert_equal(fired[0].id, 2);
+    k_sleep(K_MSEC(50));
+    zassert_equal(fired_count, 2);
+}
+
+ZTEST(scheduler, test_cancel_call)
+{
+    int64_t now = scheduler_now();
+    int64_t due[40];
+    int a_posted = 0;
+
+    // Calls to two functions and messages interleaved. The cancelled calls
+    // are the earliest events, so removing them reshapes the whole heap.
+    for (int i = 0; i < (int)ARRAY_SIZE(due); i++) {
+        switch (i % 3) {
+        case 0:
+            due[i] = now + ms(5) + ms(i % 4);
+            zassert_ok(scheduler_post_call(due[i], call_a));
+            a_posted++;
+            break;
+        case 1:
+            due[i] = now + ms(10) + ms(next_random(30));
+            zassert_ok(scheduler_post_call(due[i], call_b));
+            break;
+        default:
+            due[i] = now + ms(10) + ms(next_random(30));
+            zassert_ok(post_id(due[i], i));
+            break;
+        }
+    }
+
+    zassert_equal(scheduler_cancel_call(call_a), a_posted);
+    zassert_equal(scheduler_cancel_call(call_a), 0);
+
+    struct sched_stats st;
+
+    scheduler_get_stats(&st);
+    zassert_equal(st.depth, ARRAY_SIZE(due) - a_posted);
+
+    k_sleep(K_MSEC(100));
+
+    // The rebuilt heap still comes out in due order, each event on time
+    zassert_equal(fired_count, ARRAY_SIZE(due) - a_posted);
+    for (int i = 0; i < fired_count; i++) {
+        struct fired *f = &fired[i];
+
+        zassert_not_equal(f->id, 0xA, "cancelled call ran");
+        if (!f->call) {
+            f->due = due[f->id];
+        }
+        zassert_true(f->at >= f->due, "event %d early", i);
+        zassert_true(f->at - f->due <= ms(1), "event %d late", i);
+        if (i > 0) {
+            zassert_true(fired[i - 1].due <= f->due, "event %d out of order", i);
+        }
+    }
+}
+
+ZTEST(scheduler, test_cancel_everything)
+{
+    int64_t now = scheduler_now();
+
+    zassert_ok(scheduler_post_call(now + ms(10), call_a));
+    zassert_ok(scheduler_post_call(now + ms(20), call_a));
+    zassert_equal(scheduler_cancel_call(call_a), 2);
+
+    // The timer is stopped with the heap empty, and restarted by a post
+    k_sleep(K_MSEC(30));
+    zassert_equal(fired_count, 0);
+
+    zassert_ok(scheduler_post_call(scheduler_now() + ms(5), call_b));
+    k_sleep(K_MSEC(10));
+    zassert_equal(fired_count, 1);
+    zassert_equal(fired[0].id, 0xB);
+}
+
+// A call that posts the next one on a fixed grid from its due time, as
+// the arpeggiator step does
+static int64_t grid_step;
+static int grid_left;
+
+static void grid_call(int64_t due)
+{
+    fire(due, 0xC, true);
+    if (--grid_left > 0) {
+        scheduler_post_call(due + grid_step, grid_call);
+    }
+}
+
+ZTEST(scheduler, test_self_posting_call_keeps_grid)
+{
+    int64_t start = scheduler_now() + ms(5);
+
+    grid_step = ms(7);
+    grid_left = 20;
+    zassert_ok(scheduler_post_call(start, grid_call));
+    k_sleep(K_MSEC(200));
+
+    zassert_equal(fired_count, 20);
+    for (int i = 0; i < fired_count; i++) {
+        zassert_equal(fired[i].due, start + i * grid_step, "step %d drifted", i);
+        zassert_true(fired[i].at >= fired[i].due);
+    }
+}
+
+ZTEST_SUITE(scheduler, NULL, NULL, scheduler_before, NULL, NULL);
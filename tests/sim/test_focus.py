@@ -0,0 +1,52 @@
+"""Focused M2 sampling in the native_sim replay build.
+
+Run by twister as the superr.sim.focus scenario in sample.yaml: the
+harness passes the build directory, the test writes a contact trace with
+tools/keytrace.py and replays it through zephyr.exe (see src/sim.h).
+"""
+
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+ROOT = Path(__file__).resolve().parents[2]
+
+
+@pytest.fixture
+def zephyr_exe(request):
+    return Path(request.config.getoption("--build-dir")) / "zephyr" / "zephyr.exe"
+
+
+def replay(exe, tmp_path, score):
+    """Replay a keytrace score; returns the console and the MIDI lines."""
+    (tmp_path / "score.txt").write_text(score)
+    subprocess.run([sys.executable, str(ROOT / "tools" / "keytrace.py"),
+                    str(tmp_path / "score.txt"), "-o", str(tmp_path / "keys.trace")],
+                   check=True)
+    run = subprocess.run([str(exe), "--keys=%s" % (tmp_path / "keys.trace"),
+                          "--midi-out=%s" % (tmp_path / "midi.txt"), "--tail-ms=200"],
+                         capture_output=True, text=True, timeout=120, check=True)
+    return run.stdout, (tmp_path / "midi.txt").read_text().splitlines()
+
+
+def focus_samples(console):
+    m = re.search(r"\[SIM\] Focused M2: (\d+) samples", console)
+    assert m, console
+    return int(m.group(1))
+
+
+def test_idle_keyboard_has_no_focused_samples(zephyr_exe, tmp_path):
+    console, _ = replay(zephyr_exe, tmp_path, "# no strokes\n")
+    assert focus_samples(console) == 0
+
+
+def test_slow_stroke_is_focus_sampled(zephyr_exe, tmp_path):
+    # Key 5, 80 ms from M1 to M2: about 40 scan periods mid-stroke, each
+    # with time left after the full pass for a focused M2 sample
+    console, midi = replay(zephyr_exe, tmp_path, "0 5 80000 100\n")
+    assert focus_samples(console) > 0
+    notes_on = [l for l in midi if l.split()[1].startswith("9") and l.split()[3] != "0"]
+    assert len(notes_on) == 1, midi
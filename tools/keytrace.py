@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Write a synthetic contact trace for the native_sim replay build.
+
+The trace drives the emulated key matrix (CONFIG_SUPERR_SIM, see
+src/sim.h): one "<time_us> <key> <m1|m2> <0|1>" edge per line.
+
+Notes come from a score file, one key stroke per line ('#' comments):
+
+    <time_ms> <key> <travel_us> <hold_ms> [<release_us>]
+
+travel_us is the M1 -> M2 time the firmware turns into velocity (short =
+loud), hold_ms how long M2 stays closed, release_us the M2 -> M1 release
+time (defaults to travel_us). Or generate random strokes:
+
+    python3 tools/keytrace.py score.txt -o keys.trace
+    python3 tools/keytrace.py --random 200 --seed 7 --bounce 3 -o keys.trace
+
+Replay with:
+
+    build/zephyr/zephyr.exe --keys=keys.trace --midi-out=midi.txt --led-out=leds.txt
+"""
+
+import argparse
+import random
+import sys
+
+NUM_KEYS = 24            # keyboard-matrix in native_sim.overlay
+LEAD_IN_MS = 1000        # Boot and settings restore first
+
+
+def stroke_edges(t_us, key, travel_us, hold_us, release_us, bounce, bounce_us):
+    """Edges of one key stroke as (time_us, key, contact, closed)."""
+    edges = []
+
+    def contact(start, end, name):
+        # Closes at start, opens at end; bounce adds open/close pairs
+        # right after each edge
+        edges.append((start, key, name, 1))
+        for i in range(bounce):
+            edges.append((start + (2 * i + 1) * bounce_us, key, name, 0))
+            edges.append((start + (2 * i + 2) * bounce_us, key, name, 1))
+        edges.append((end, key, name, 0))
+        for i in range(bounce):
+            edges.append((end + (2 * i + 1) * bounce_us, key, name, 1))
+            edges.append((end + (2 * i + 2) * bounce_us, key, name, 0))
+
+    m2_open = t_us + travel_us + hold_us
+    contact(t_us, m2_open + release_us, "m1")
+    contact(t_us + travel_us, m2_open, "m2")
+    return edges
+
+
+def read_score(path):
+    """Yield (time_ms, key, travel_us, hold_ms, release_us) per stroke."""
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            if len(line) not in (4, 5):
+                raise ValueError("%s:%d: expected <time_ms> <key> <travel_us> "
+                                 "<hold_ms> [<release_us>]" % (path, n))
+            time_ms, key, travel_us, hold_ms = (int(v) for v in line[:4])
+            release_us = int(line[4]) if len(line) == 5 else travel_us
+            yield time_ms, key, travel_us, hold_ms, release_us
+
+
+def random_score(count, seed, keys):
+    """Strokes at random times, keys and velocities, one per 50-400 ms."""
+    rng = random.Random(seed)
+    t_ms = 0
+    for _ in range(count):
+        t_ms += rng.randint(50, 400)
+        travel_us = rng.randint(2000, 60000)
+        yield t_ms, rng.randrange(keys), travel_us, rng.randint(30, 800), travel_us
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("score", nargs="?", help="score file (see above)")
+    ap.add_argument("--random", type=int, metavar="N", help="N random strokes instead of a score")
+    ap.add_argument("--seed", type=int, default=1, help="random seed (default 1)")
+    ap.add_argument("--keys", type=int, default=NUM_KEYS, help="keys on the matrix (default %d)" % NUM_KEYS)
+    ap.add_argument("--bounce", type=int, default=0, metavar="N",
+                    help="open/close chatter pairs after every contact edge")
+    ap.add_argument("--bounce-us", type=int, default=40, help="chatter pulse length (default 40)")
+    ap.add_argument("--lead-in-ms", type=int, default=LEAD_IN_MS,
+                    help="offset added to every stroke (default %d)" % LEAD_IN_MS)
+    ap.add_argument("-o", "--output", help="trace file (default stdout)")
+    args = ap.parse_args()
+
+    if (args.score is None) == (args.random is None):
+        ap.error("give a score file or --random N")
+
+    strokes = random_score(args.random, args.seed, args.keys) if args.random is not None \
+        else read_score(args.score)
+
+    edges = []
+    for time_ms, key, travel_us, hold_ms, release_us in strokes:
+        if not 0 <= key < args.keys:
+            sys.exit("key %d out of range (0-%d)" % (key, args.keys - 1))
+        t_us = (time_ms + args.lead_in_ms) * 1000
+        edges += stroke_edges(t_us, key, travel_us, hold_ms * 1000, release_us,
+                              args.bounce, args.bounce_us)
+
+    # Stable sort: edges at the same time keep their stroke order
+    edges.sort(key=lambda e: e[0])
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    out.write("# time_us key contact closed\n")
+    for t_us, key, name, closed in edges:
+        out.write("%d %d %s %d\n" % (t_us, key, name, closed))
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
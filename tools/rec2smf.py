@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Convert a Superr recorder download to a Standard MIDI File.
+
+The input is the recorder blocks as received on the download channel
+(L2CAP PSM 0x0083): every REC_SDU_BLOCK payload, without its type byte,
+appended to one file. Blocks may be in any order and repeated; they are
+sorted by sequence number and de-duplicated.
+
+    python3 tools/rec2smf.py download.bin -o take.mid
+    python3 tools/rec2smf.py download.bin --list
+    python3 tools/rec2smf.py download.bin --session 3 -o take.mid
+
+Block layout must match struct rec_block_hdr in src/recorder.h.
+"""
+
+import argparse
+import struct
+import sys
+
+BLOCK_MAGIC = 0xA5
+FORMAT_VERSION = 1
+HDR = struct.Struct("<BBHIIHH")   # magic, version, len, seq, start_ms, session, reserved
+
+# 1 tick = 1 ms: 1000 ticks per quarter note at 60 bpm
+TICKS_PER_QUARTER = 1000
+TEMPO_US = 1000000
+
+
+def read_blocks(data):
+    """Yield (seq, session, start_ms, payload) for every block in data."""
+    off = 0
+    while off + HDR.size <= len(data):
+        magic, version, length, seq, start_ms, session, _ = HDR.unpack_from(data, off)
+        if magic != BLOCK_MAGIC or version != FORMAT_VERSION:
+            raise ValueError("bad block header at offset %d" % off)
+        off += HDR.size
+        payload = data[off:off + length]
+        if len(payload) != length:
+            raise ValueError("truncated block %d" % seq)
+        off += length
+        yield seq, session, start_ms, payload
+
+
+def read_vlq(buf, i):
+    value = 0
+    while True:
+        b = buf[i]
+        i += 1
+        value = (value << 7) | (b & 0x7F)
+        if not b & 0x80:
+            return value, i
+
+
+def data_len(status):
+    return 1 if status & 0xF0 in (0xC0, 0xD0) else 2
+
+
+def decode_block(start_ms, payload):
+    """Yield (time_ms, message bytes) for the events of one block."""
+    t = start_ms
+    status = None
+    i = 0
+    while i < len(payload):
+        delta, i = read_vlq(payload, i)
+        t += delta
+        if payload[i] & 0x80:
+            status = payload[i]
+            i += 1
+        if status is None:
+            raise ValueError("running status without a status byte")
+        n = data_len(status)
+        yield t, bytes([status]) + payload[i:i + n]
+        i += n
+
+
+def vlq(value):
+    out = [value & 0x7F]
+    value >>= 7
+    while value:
+        out.insert(0, 0x80 | (value & 0x7F))
+        value >>= 7
+    return bytes(out)
+
+
+def write_smf(path, events):
+    track = bytearray()
+    track += vlq(0) + b"\xff\x51\x03" + TEMPO_US.to_bytes(3, "big")
+    last = events[0][0] if events else 0
+    for t, msg in events:
+        track += vlq(t - last) + msg
+        last = t
+    track += vlq(0) + b"\xff\x2f\x00"
+
+    with open(path, "wb") as f:
+        f.write(b"MThd" + struct.pack(">IHHH", 6, 0, 1, TICKS_PER_QUARTER))
+        f.write(b"MTrk" + struct.pack(">I", len(track)) + track)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("download", help="concatenated recorder blocks")
+    ap.add_argument("-o", "--output", help="MIDI file to write")
+    ap.add_argument("--session", type=int,
+                    help="boot session to convert (default: the latest)")
+    ap.add_argument("--list", action="store_true", help="list sessions and exit")
+    args = ap.parse_args()
+
+    with open(args.download, "rb") as f:
+        data = f.read()
+
+    blocks = {}
+    for seq, session, start_ms, payload in read_blocks(data):
+        blocks[seq] = (session, start_ms, payload)
+    if not blocks:
+        sys.exit("no recorder blocks in %s" % args.download)
+
+    sessions = {}
+    for seq in sorted(blocks):
+        sessions.setdefault(blocks[seq][0], []).append(seq)
+
+    if args.list:
+        for session, seqs in sorted(sessions.items()):
+            gaps = (seqs[-1] - seqs[0] + 1) - len(seqs)
+            print("session %u: blocks %u-%u (%u missing)" % (session, seqs[0], seqs[-1], gaps))
+        return
+
+    session = args.session if args.session is not None else max(sessions)
+    if session not in sessions:
+        sys.exit("session %u not in download" % session)
+    if not args.output:
+        ap.error("-o/--output is required")
+
+    events = []
+    for seq in sessions[session]:
+        _, start_ms, payload = blocks[seq]
+        events.extend(decode_block(start_ms, payload))
+
+    write_smf(args.output, events)
+    span = (events[-1][0] - events[0][0]) / 1000.0 if events else 0
+    print("session %u: %d events, %.1f s -> %s" % (session, len(events), span, args.output))
+
+
+if __name__ == "__main__":
+    main()
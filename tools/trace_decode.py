@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Render Superr raw trace output (CONFIG_SUPERR_TRACE_RAW=y).
+
+Reads a captured console log (file or stdin), picks out the "#TH" header
+and "#T" record lines and prints them as text. Other console lines are
+passed through unchanged so the trace stays in context.
+
+    python3 tools/trace_decode.py uart.log
+    minicom -C uart.log ... ; tail -f uart.log | python3 tools/trace_decode.py
+
+Event IDs and argument layout must match enum trace_event in src/trace.h.
+"""
+
+import argparse
+import sys
+
+# Matrix geometry of the board that produced the trace (keyboard-matrix
+# devicetree node); defaults match the 24-key overlay, see --cols/--base-note
+NUM_COLS = 4
+BASE_MIDI_NOTE = 60
+
+
+def key_rc(key):
+    return "R%d,C%d" % (key // NUM_COLS + 1, key % NUM_COLS + 1)
+
+
+def fmt_idle(a, b):
+    cols = " ".join("C%d=%s" % (c + 1, "HIGH" if a & (1 << c) else "LOW")
+                    for c in range(NUM_COLS))
+    return "[DEBUG] All keys OFF (OK), Time: %u ms, Columns: %s" % (b, cols)
+
+
+FORMATTERS = {
+    1: lambda a, b: "[M2] Key[%s]: Matrix 2 SECOND contact detected (Note %u)" % (key_rc(a), b),
+    2: lambda a, b: "[WARN] Key[%s]: M2 contact but M1 not active!" % key_rc(a),
+    3: lambda a, b: "[NOTE OFF] Key[%s] (Note %u)" % (key_rc(a), b),
+    4: lambda a, b: "[DEBUG] %u keys stuck! (Count: %u)" % (a, b),
+    5: lambda a, b: "   Key[%s] Note %d: M1=%d M2=%d Playing=%d" % (
+        key_rc(a), BASE_MIDI_NOTE + a, b & 1, (b >> 1) & 1, (b >> 2) & 1),
+    6: lambda a, b: "[WARN] Keys stuck for >5 seconds, forcing reset...",
+    7: lambda a, b: "   Reset Key %u (Note %u)" % (a, b),
+    8: fmt_idle,
+}
+
+
+class Decoder:
+    def __init__(self, hz):
+        self.hz = hz
+        self.base = None     # First timestamp seen (cycles)
+        self.last = None     # For unwrapping the 32-bit counter
+        self.wraps = 0
+
+    def timestamp_us(self, cyc):
+        if self.last is not None and cyc < self.last:
+            self.wraps += 1
+        self.last = cyc
+        full = cyc + (self.wraps << 32)
+        if self.base is None:
+            self.base = full
+        return (full - self.base) * 1000000 // self.hz
+
+    def line(self, text):
+        parts = text.split()
+        if parts[0] == "#TH":
+            self.hz = int(parts[1])
+            return None
+        if parts[0] != "#T" or len(parts) != 5:
+            return text
+        cyc, evt, a, b = (int(p, 16) for p in parts[1:])
+        us = self.timestamp_us(cyc)
+        fmt = FORMATTERS.get(evt)
+        msg = fmt(a, b) if fmt else "[TRACE] id=%u a=%u b=%u" % (evt, a, b)
+        return "[%d.%06d] %s" % (us // 1000000, us % 1000000, msg)
+
+
+def main():
+    global NUM_COLS, BASE_MIDI_NOTE
+
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("log", nargs="?", help="captured console log (default: stdin)")
+    ap.add_argument("--hz", type=int, default=32768,
+                    help="cycle counter rate if the #TH header was not captured")
+    ap.add_argument("--only", action="store_true", help="drop non-trace console lines")
+    ap.add_argument("--cols", type=int, default=NUM_COLS,
+                    help="matrix columns (col-gpios entries) of the traced board")
+    ap.add_argument("--base-note", type=int, default=BASE_MIDI_NOTE,
+                    help="base-note of the traced board")
+    args = ap.parse_args()
+
+    NUM_COLS = args.cols
+    BASE_MIDI_NOTE = args.base_note
+
+    src = open(args.log, errors="replace") if args.log else sys.stdin
+    dec = Decoder(args.hz)
+    for raw in src:
+        text = raw.rstrip("\r\n")
+        if not text.strip():
+            continue
+        is_trace = text.startswith("#T")
+        if args.only and not is_trace:
+            continue
+        out = dec.line(text)
+        if out is not None:
+            print(out)
+
+
+if __name__ == "__main__":
+    main()